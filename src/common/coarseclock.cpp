@@ -0,0 +1,117 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "coarseclock.h"
+
+#include <algorithm>
+#include "Win32Exception.h"
+
+#pragma warning(push, 4)
+
+// coarseclock::s_ticks (static)
+//
+// Zero indicates that there is no active coarseclock instance
+std::atomic<uint64_t> coarseclock::s_ticks(0);
+
+//-----------------------------------------------------------------------------
+// coarseclock Constructor
+//
+// Arguments:
+//
+//	granularity		- Interval at which to refresh the cached date/time
+
+coarseclock::coarseclock(timespan granularity) : m_granularity(granularity)
+{
+	// The thread pool timer period is in milliseconds, the minimum is one
+	DWORD period = static_cast<DWORD>(std::max<uint64_t>(1, std::min<uint64_t>(granularity.milliseconds(), MAXDWORD)));
+
+	m_timer = CreateThreadpoolTimer(Refresh, nullptr, nullptr);
+	if(m_timer == nullptr) throw Win32Exception();
+
+	// Prime the cached date/time before starting the timer so it's never stale
+	s_ticks = datetime::now();
+
+	FILETIME duetime{ 0, 0 };
+	SetThreadpoolTimer(m_timer, &duetime, period, 0);
+}
+
+//-----------------------------------------------------------------------------
+// coarseclock Destructor
+
+coarseclock::~coarseclock()
+{
+	SetThreadpoolTimer(m_timer, nullptr, 0, 0);
+	WaitForThreadpoolTimerCallbacks(m_timer, TRUE);
+	CloseThreadpoolTimer(m_timer);
+
+	s_ticks = 0;
+}
+
+//-----------------------------------------------------------------------------
+// coarseclock::getGranularity
+//
+// Gets the interval at which the cached date/time is refreshed
+
+timespan coarseclock::getGranularity(void) const
+{
+	return m_granularity;
+}
+
+//-----------------------------------------------------------------------------
+// coarseclock::now (static)
+//
+// Gets the cached date/time (UTC)
+//
+// Arguments:
+//
+//	NONE
+
+datetime coarseclock::now(void)
+{
+	uint64_t ticks = s_ticks.load(std::memory_order_relaxed);
+	return (ticks) ? datetime(ticks) : datetime::now();
+}
+
+//-----------------------------------------------------------------------------
+// coarseclock::Refresh (private, static)
+//
+// Thread pool timer callback that refreshes the cached date/time
+//
+// Arguments:
+//
+//	instance		- Thread pool callback instance
+//	context			- Context pointer provided to CreateThreadpoolTimer
+//	timer			- Thread pool timer object
+
+void CALLBACK coarseclock::Refresh(PTP_CALLBACK_INSTANCE instance, void* context, PTP_TIMER timer)
+{
+	UNREFERENCED_PARAMETER(instance);
+	UNREFERENCED_PARAMETER(context);
+	UNREFERENCED_PARAMETER(timer);
+
+	s_ticks.store(datetime::now(), std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
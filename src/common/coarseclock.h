@@ -0,0 +1,96 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __COARSECLOCK_H_
+#define __COARSECLOCK_H_
+#pragma once
+
+#include <atomic>
+#include <Windows.h>
+#include "datetime.h"
+#include "timespan.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// coarseclock
+//
+// Cached date/time (UTC) that is refreshed by a thread pool timer at a fixed
+// granularity, similar to CLOCK_REALTIME_COARSE.  Reading the cached value is
+// a single load; when no coarseclock instance is active the precise system
+// clock is used instead.  Only one instance should be active at a time
+
+class coarseclock final
+{
+public:
+
+	// Instance Constructor
+	//
+	explicit coarseclock(timespan granularity);
+
+	// Destructor
+	//
+	~coarseclock();
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// now (static)
+	//
+	// Gets the cached date/time (UTC)
+	static datetime now(void);
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// Granularity
+	//
+	// Gets the interval at which the cached date/time is refreshed
+	__declspec(property(get=getGranularity)) timespan Granularity;
+	timespan getGranularity(void) const;
+
+private:
+
+	coarseclock(coarseclock const&)=delete;
+	coarseclock& operator=(coarseclock const&)=delete;
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// Refresh (static)
+	//
+	// Thread pool timer callback that refreshes the cached date/time
+	static void CALLBACK Refresh(PTP_CALLBACK_INSTANCE instance, void* context, PTP_TIMER timer);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	static std::atomic<uint64_t>	s_ticks;			// Cached date/time
+	timespan const					m_granularity;		// Refresh interval
+	PTP_TIMER						m_timer;			// Thread pool timer
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __COARSECLOCK_H_
@@ -0,0 +1,137 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __FREELIST_H_
+#define __FREELIST_H_
+#pragma once
+
+#include <malloc.h>
+#include <new>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include "posix.h"
+#endif
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// freelist
+//
+// Lock-free cache of small fixed-size memory blocks, intended to back the class
+// specific operator new/delete of short-lived objects that are allocated at a
+// high rate.  Blocks are grouped by size in MEMORY_ALLOCATION_ALIGNMENT units,
+// each distinct _tag type maintains its own independent set of lists.  Cached
+// blocks are not returned to the process heap; at most _depth blocks of each
+// size are retained
+
+template <typename _tag, USHORT _depth = 256>
+class freelist final
+{
+public:
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// allocate (static)
+	//
+	// Allocates a block of memory, reusing a cached block if one is available
+	static void* allocate(size_t size)
+	{
+		size_t bucket = bucket_index(size);
+
+		// Blocks that are too large to be cached come directly from the heap
+		if(bucket >= BUCKETS) return ::operator new(size);
+
+		// Pop a cached block from the list or allocate a new one of the full bucket size
+		void* block = InterlockedPopEntrySList(&lists().heads[bucket]);
+		if(block == nullptr) block = _aligned_malloc((bucket + 1) * MEMORY_ALLOCATION_ALIGNMENT, MEMORY_ALLOCATION_ALIGNMENT);
+		if(block == nullptr) throw std::bad_alloc();
+
+		return block;
+	}
+
+	// release (static)
+	//
+	// Releases a block of memory previously allocated with allocate()
+	static void release(void* ptr, size_t size)
+	{
+		if(ptr == nullptr) return;
+
+		size_t bucket = bucket_index(size);
+		if(bucket >= BUCKETS) return ::operator delete(ptr);
+
+		// Cache the block unless the list has reached the maximum depth
+		SLIST_HEADER* head = &lists().heads[bucket];
+		if(QueryDepthSList(head) < _depth) InterlockedPushEntrySList(head, reinterpret_cast<PSLIST_ENTRY>(ptr));
+		else _aligned_free(ptr);
+	}
+
+private:
+
+	freelist()=delete;
+	~freelist()=delete;
+	freelist(freelist const&)=delete;
+	freelist& operator=(freelist const&)=delete;
+
+	// BUCKETS
+	//
+	// Number of block size buckets maintained
+	static const size_t BUCKETS = 16;
+
+	// lists_t
+	//
+	// Array of interlocked singly linked list heads, one per bucket
+	struct lists_t
+	{
+		lists_t() { for(auto& head : heads) InitializeSListHead(&head); }
+
+		SLIST_HEADER heads[BUCKETS];
+	};
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// bucket_index (static)
+	//
+	// Gets the bucket index for a block size
+	static size_t bucket_index(size_t size)
+	{
+		return (size == 0) ? 0 : ((size - 1) / MEMORY_ALLOCATION_ALIGNMENT);
+	}
+
+	// lists (static)
+	//
+	// Accesses the list heads; this is initialized on first use
+	static lists_t& lists(void)
+	{
+		static lists_t s_lists;
+		return s_lists;
+	}
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __FREELIST_H_
@@ -0,0 +1,399 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __POSIX_H_
+#define __POSIX_H_
+#pragma once
+
+// This header provides POSIX implementations of the Win32 primitives that the
+// platform-neutral core (sync.h, freelist.h and the TempFileSystem heap) relies
+// upon; it has no effect when building for Windows.  Note that <unistd.h> cannot
+// be included along with sync.h since it declares a global sync() function
+#ifndef _WIN32
+
+#include <atomic>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <time.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// Types and Constants
+
+typedef int				BOOL;
+typedef uint32_t		DWORD;
+typedef uint16_t		USHORT;
+typedef uint32_t		ULONG;
+typedef void*			HANDLE;
+
+#ifndef FALSE
+#define FALSE			0
+#endif
+
+#ifndef TRUE
+#define TRUE			1
+#endif
+
+#define INFINITE						0xFFFFFFFF
+#define ALL_PROCESSOR_GROUPS			0xFFFF
+#define HEAP_NO_SERIALIZE				0x00000001
+#define HEAP_ZERO_MEMORY				0x00000008
+#define MEMORY_ALLOCATION_ALIGNMENT		16
+
+#ifndef UNREFERENCED_PARAMETER
+#define UNREFERENCED_PARAMETER(P)		(void)(P)
+#endif
+
+// LARGE_INTEGER
+//
+// 64-bit signed integer used by the performance counter functions
+union LARGE_INTEGER
+{
+	int64_t				QuadPart;
+};
+
+//-----------------------------------------------------------------------------
+// Processors and Threads
+
+// GetActiveProcessorCount
+//
+// Gets the number of online processors; processor groups are not applicable
+inline DWORD GetActiveProcessorCount(USHORT group)
+{
+	UNREFERENCED_PARAMETER(group);
+
+	unsigned int count = std::thread::hardware_concurrency();
+	return (count > 0) ? static_cast<DWORD>(count) : 1;
+}
+
+// GetCurrentThreadId
+//
+// Gets a process-unique identifier for the calling thread; identifiers are assigned
+// as multiples of four to match the distribution of Win32 thread identifiers
+inline DWORD GetCurrentThreadId(void)
+{
+	static std::atomic<DWORD> s_next(4);
+	thread_local DWORD const id = s_next.fetch_add(4);
+
+	return id;
+}
+
+// QueryPerformanceCounter
+//
+// Gets the current monotonic timestamp in nanoseconds
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* counter)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	counter->QuadPart = (static_cast<int64_t>(now.tv_sec) * 1000000000) + now.tv_nsec;
+	return TRUE;
+}
+
+// QueryPerformanceFrequency
+//
+// Gets the frequency of the performance counter, which is always nanoseconds
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+	frequency->QuadPart = 1000000000;
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// Slim Reader/Writer Locks
+
+// SRWLOCK
+//
+// Slim reader/writer lock implemented with a pthread reader/writer lock
+struct SRWLOCK
+{
+	pthread_rwlock_t	rwlock;
+};
+
+typedef SRWLOCK*		PSRWLOCK;
+
+#define SRWLOCK_INIT	{ PTHREAD_RWLOCK_INITIALIZER }
+
+inline void InitializeSRWLock(PSRWLOCK srwl) { pthread_rwlock_init(&srwl->rwlock, nullptr); }
+inline void AcquireSRWLockExclusive(PSRWLOCK srwl) { pthread_rwlock_wrlock(&srwl->rwlock); }
+inline void AcquireSRWLockShared(PSRWLOCK srwl) { pthread_rwlock_rdlock(&srwl->rwlock); }
+inline void ReleaseSRWLockExclusive(PSRWLOCK srwl) { pthread_rwlock_unlock(&srwl->rwlock); }
+inline void ReleaseSRWLockShared(PSRWLOCK srwl) { pthread_rwlock_unlock(&srwl->rwlock); }
+inline BOOL TryAcquireSRWLockExclusive(PSRWLOCK srwl) { return (pthread_rwlock_trywrlock(&srwl->rwlock) == 0) ? TRUE : FALSE; }
+inline BOOL TryAcquireSRWLockShared(PSRWLOCK srwl) { return (pthread_rwlock_tryrdlock(&srwl->rwlock) == 0) ? TRUE : FALSE; }
+
+//-----------------------------------------------------------------------------
+// Critical Sections
+
+// CRITICAL_SECTION
+//
+// Recursive mutex; RecursionCount is maintained for the owning thread only
+struct CRITICAL_SECTION
+{
+	pthread_mutex_t		mutex;
+	long				RecursionCount;
+};
+
+inline void InitializeCriticalSection(CRITICAL_SECTION* cs)
+{
+	pthread_mutexattr_t attributes;
+
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&cs->mutex, &attributes);
+	pthread_mutexattr_destroy(&attributes);
+
+	cs->RecursionCount = 0;
+}
+
+inline void DeleteCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_destroy(&cs->mutex); }
+inline void EnterCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_lock(&cs->mutex); ++cs->RecursionCount; }
+inline void LeaveCriticalSection(CRITICAL_SECTION* cs) { --cs->RecursionCount; pthread_mutex_unlock(&cs->mutex); }
+
+inline BOOL TryEnterCriticalSection(CRITICAL_SECTION* cs)
+{
+	if(pthread_mutex_trylock(&cs->mutex) != 0) return FALSE;
+
+	++cs->RecursionCount;
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// Condition Variables
+
+// CONDITION_VARIABLE
+//
+// Condition variable that can be used with an exclusively held SRWLOCK.  pthread
+// condition variables require a mutex, so the sleeper takes the internal mutex
+// before releasing the SRWLOCK and waits for the wake sequence to change
+struct CONDITION_VARIABLE
+{
+	pthread_mutex_t		mutex;
+	pthread_cond_t		cond;
+	uint64_t			sequence;
+};
+
+#define CONDITION_VARIABLE_INIT		{ PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0 }
+
+// SleepConditionVariableSRW
+//
+// Releases an exclusively held SRWLOCK and waits for the condition variable to
+// be woken; only INFINITE timeouts and exclusive acquisition are supported
+inline BOOL SleepConditionVariableSRW(CONDITION_VARIABLE* cv, PSRWLOCK srwl, DWORD milliseconds, ULONG flags)
+{
+	UNREFERENCED_PARAMETER(milliseconds);
+	UNREFERENCED_PARAMETER(flags);
+
+	pthread_mutex_lock(&cv->mutex);
+	uint64_t sequence = cv->sequence;
+
+	ReleaseSRWLockExclusive(srwl);
+	while(cv->sequence == sequence) pthread_cond_wait(&cv->cond, &cv->mutex);
+	pthread_mutex_unlock(&cv->mutex);
+
+	AcquireSRWLockExclusive(srwl);
+	return TRUE;
+}
+
+// WakeAllConditionVariable
+//
+// Wakes all threads waiting on the condition variable
+inline void WakeAllConditionVariable(CONDITION_VARIABLE* cv)
+{
+	pthread_mutex_lock(&cv->mutex);
+	++cv->sequence;
+	pthread_cond_broadcast(&cv->cond);
+	pthread_mutex_unlock(&cv->mutex);
+}
+
+//-----------------------------------------------------------------------------
+// Singly Linked Lists
+
+// SLIST_ENTRY
+//
+// Singly linked list entry
+struct SLIST_ENTRY
+{
+	SLIST_ENTRY*		Next;
+};
+
+typedef SLIST_ENTRY*	PSLIST_ENTRY;
+
+// SLIST_HEADER
+//
+// Singly linked list head; the list is protected by a mutex rather than the
+// double-width compare and exchange used by the Win32 implementation
+struct SLIST_HEADER
+{
+	pthread_mutex_t		mutex;
+	SLIST_ENTRY*		first;
+	USHORT				depth;
+};
+
+typedef SLIST_HEADER*	PSLIST_HEADER;
+
+inline void InitializeSListHead(PSLIST_HEADER head)
+{
+	pthread_mutex_init(&head->mutex, nullptr);
+	head->first = nullptr;
+	head->depth = 0;
+}
+
+inline USHORT QueryDepthSList(PSLIST_HEADER head)
+{
+	pthread_mutex_lock(&head->mutex);
+	USHORT depth = head->depth;
+	pthread_mutex_unlock(&head->mutex);
+
+	return depth;
+}
+
+inline PSLIST_ENTRY InterlockedPopEntrySList(PSLIST_HEADER head)
+{
+	pthread_mutex_lock(&head->mutex);
+
+	PSLIST_ENTRY entry = head->first;
+	if(entry) { head->first = entry->Next; --head->depth; }
+
+	pthread_mutex_unlock(&head->mutex);
+	return entry;
+}
+
+inline PSLIST_ENTRY InterlockedPushEntrySList(PSLIST_HEADER head, PSLIST_ENTRY entry)
+{
+	pthread_mutex_lock(&head->mutex);
+
+	PSLIST_ENTRY previous = head->first;
+	entry->Next = previous;
+	head->first = entry;
+	++head->depth;
+
+	pthread_mutex_unlock(&head->mutex);
+	return previous;
+}
+
+//-----------------------------------------------------------------------------
+// Memory Allocation
+
+// _aligned_malloc
+//
+// Allocates a block of memory with the specified alignment
+inline void* _aligned_malloc(size_t size, size_t alignment)
+{
+	void* ptr = nullptr;
+	return (posix_memalign(&ptr, (alignment < sizeof(void*)) ? sizeof(void*) : alignment, size) == 0) ? ptr : nullptr;
+}
+
+// _aligned_free
+//
+// Releases a block of memory allocated with _aligned_malloc
+inline void _aligned_free(void* ptr) { free(ptr); }
+
+// Private heaps are not available; the heap functions allocate from the process
+// heap with a header that records the requested size of each block so that
+// HeapSize() reports the same value the Win32 implementation would
+namespace posix { namespace heap {
+
+	// header_t
+	//
+	// Prefix of each allocated block, sized to retain allocation alignment
+	union header_t
+	{
+		size_t			size;
+		uint8_t			alignment[MEMORY_ALLOCATION_ALIGNMENT];
+	};
+
+	inline header_t* header(void* ptr) { return reinterpret_cast<header_t*>(ptr) - 1; }
+	inline void* body(header_t* header) { return header + 1; }
+
+} }	// namespace posix::heap
+
+inline HANDLE HeapCreate(DWORD options, size_t initialsize, size_t maximumsize)
+{
+	UNREFERENCED_PARAMETER(options);
+	UNREFERENCED_PARAMETER(initialsize);
+	UNREFERENCED_PARAMETER(maximumsize);
+
+	// Any non-null value will do, there is no per-heap state
+	static int s_heap;
+	return &s_heap;
+}
+
+inline BOOL HeapDestroy(HANDLE heap) { UNREFERENCED_PARAMETER(heap); return TRUE; }
+
+inline void* HeapAlloc(HANDLE heap, DWORD flags, size_t bytes)
+{
+	UNREFERENCED_PARAMETER(heap);
+
+	size_t length = sizeof(posix::heap::header_t) + bytes;
+	auto header = reinterpret_cast<posix::heap::header_t*>((flags & HEAP_ZERO_MEMORY) ? calloc(1, length) : malloc(length));
+	if(header == nullptr) return nullptr;
+
+	header->size = bytes;
+	return posix::heap::body(header);
+}
+
+inline BOOL HeapFree(HANDLE heap, DWORD flags, void* ptr)
+{
+	UNREFERENCED_PARAMETER(heap);
+	UNREFERENCED_PARAMETER(flags);
+
+	if(ptr) free(posix::heap::header(ptr));
+	return TRUE;
+}
+
+inline void* HeapReAlloc(HANDLE heap, DWORD flags, void* ptr, size_t bytes)
+{
+	UNREFERENCED_PARAMETER(heap);
+
+	size_t oldbytes = posix::heap::header(ptr)->size;
+
+	auto header = reinterpret_cast<posix::heap::header_t*>(realloc(posix::heap::header(ptr), sizeof(posix::heap::header_t) + bytes));
+	if(header == nullptr) return nullptr;
+
+	// HEAP_ZERO_MEMORY applies to the portion of the block that was added
+	void* body = posix::heap::body(header);
+	if((flags & HEAP_ZERO_MEMORY) && (bytes > oldbytes)) memset(reinterpret_cast<uint8_t*>(body) + oldbytes, 0, bytes - oldbytes);
+
+	header->size = bytes;
+	return body;
+}
+
+inline size_t HeapSize(HANDLE heap, DWORD flags, void const* ptr)
+{
+	UNREFERENCED_PARAMETER(heap);
+	UNREFERENCED_PARAMETER(flags);
+
+	return posix::heap::header(const_cast<void*>(ptr))->size;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// !_WIN32
+
+#endif	// __POSIX_H_
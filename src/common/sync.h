@@ -24,7 +24,20 @@
 #define __SYNC_H_
 #pragma once
 
+#include <malloc.h>
+#include <new>
+#include <stdint.h>
+
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include "posix.h"
+#endif
+
+#ifdef SYNC_LOCK_PROFILING
+#include <atomic>
+#include <string.h>
+#endif
 
 #pragma warning(push, 4)
 
@@ -36,10 +49,181 @@
 // well in general use outside of that implementation.  In some cases, like with
 // the reader_writer_lock, the primitive Win32 implementation can be orders of
 // magnitude faster.
+//
+// Defining SYNC_LOCK_PROFILING builds the primitives with contention profiling;
+// locks that are given a name at construction record acquisition counts, the
+// number of contended acquisitions, a wait time histogram and the maximum time
+// the lock was held exclusively.  Locks that share a name share statistics.
 //-----------------------------------------------------------------------------
 
 namespace sync {
 
+#ifdef SYNC_LOCK_PROFILING
+
+// lock_profile
+//
+// Contention statistics collected for all locks that share a name
+class lock_profile
+{
+public:
+
+	// HISTOGRAM_BUCKETS
+	//
+	// Number of power-of-two wait time histogram buckets (nanoseconds)
+	static size_t const HISTOGRAM_BUCKETS = 32;
+
+	// snapshot_t
+	//
+	// Snapshot of the statistics collected for a lock profile
+	struct snapshot_t
+	{
+		char const*			name;							// Lock name
+		uint64_t			acquisitions;					// Number of acquisitions
+		uint64_t			contentions;					// Number of contended acquisitions
+		uint64_t			waitns;							// Total wait time
+		uint64_t			maxholdns;						// Maximum exclusive hold time
+		uint64_t			histogram[HISTOGRAM_BUCKETS];	// Wait time histogram
+	};
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// acquired
+	//
+	// Records an acquisition of the lock and the time spent waiting for it
+	void acquired(bool contended, uint64_t waitticks)
+	{
+		m_acquisitions++;
+		if(!contended) return;
+
+		uint64_t ns = to_nanoseconds(waitticks);
+
+		m_contentions++;
+		m_waitns += ns;
+
+		// Bucket zero holds zero nanosecond waits, bucket n holds waits in the range [2^(n-1), 2^n)
+		size_t bucket = 0;
+		while((bucket < (HISTOGRAM_BUCKETS - 1)) && ((ns >> bucket) != 0)) bucket++;
+		m_histogram[bucket]++;
+	}
+
+	// enumerate (static)
+	//
+	// Enumerates a snapshot of each lock profile
+	template <typename _func>
+	static void enumerate(_func func)
+	{
+		AcquireSRWLockShared(&registry_lock());
+
+		for(lock_profile* profile = registry_head(); profile; profile = profile->m_next) {
+
+			snapshot_t snapshot{ profile->m_name, profile->m_acquisitions, profile->m_contentions, profile->m_waitns, profile->m_maxholdns };
+			for(size_t index = 0; index < HISTOGRAM_BUCKETS; index++) snapshot.histogram[index] = profile->m_histogram[index];
+
+			func(snapshot);
+		}
+
+		ReleaseSRWLockShared(&registry_lock());
+	}
+
+	// find (static)
+	//
+	// Locates or creates the lock profile associated with a name
+	static lock_profile* find(char const* name)
+	{
+		AcquireSRWLockExclusive(&registry_lock());
+
+		lock_profile* profile = registry_head();
+		while((profile) && (strcmp(profile->m_name, name) != 0)) profile = profile->m_next;
+
+		// Profiles are never released, they exist for the lifetime of the process
+		if(profile == nullptr) {
+
+			profile = new lock_profile(name);
+			profile->m_next = registry_head();
+			registry_head() = profile;
+		}
+
+		ReleaseSRWLockExclusive(&registry_lock());
+		return profile;
+	}
+
+	// released
+	//
+	// Records the amount of time that the lock was held exclusively
+	void released(uint64_t holdticks)
+	{
+		uint64_t ns = to_nanoseconds(holdticks);
+		uint64_t current = m_maxholdns;
+
+		while((ns > current) && (!m_maxholdns.compare_exchange_weak(current, ns))) { /* spin */ }
+	}
+
+	// timestamp (static)
+	//
+	// Gets the current high resolution timestamp
+	static uint64_t timestamp(void)
+	{
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return static_cast<uint64_t>(counter.QuadPart);
+	}
+
+private:
+
+	lock_profile(const lock_profile&)=delete;
+	lock_profile& operator=(const lock_profile&)=delete;
+
+	// Instance Constructor
+	//
+	explicit lock_profile(char const* name) : m_name(name), m_acquisitions(0), m_contentions(0), m_waitns(0), m_maxholdns(0), 
+		m_next(nullptr)
+	{
+		for(auto& bucket : m_histogram) bucket = 0;
+	}
+
+	//-----------------------------------------------------------------------
+	// Private Member Functions
+
+	// registry_head (static)
+	//
+	// Accesses the head of the lock profile registry
+	static lock_profile*& registry_head(void) { static lock_profile* head = nullptr; return head; }
+
+	// registry_lock (static)
+	//
+	// Accesses the lock profile registry synchronization object
+	static SRWLOCK& registry_lock(void) { static SRWLOCK lock = SRWLOCK_INIT; return lock; }
+
+	// to_nanoseconds (static)
+	//
+	// Converts a high resolution timestamp interval into nanoseconds
+	static uint64_t to_nanoseconds(uint64_t ticks)
+	{
+		static uint64_t const frequency = []() -> uint64_t {
+
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency(&frequency);
+			return static_cast<uint64_t>(frequency.QuadPart);
+		}();
+
+		return ((ticks / frequency) * UINT64_C(1000000000)) + (((ticks % frequency) * UINT64_C(1000000000)) / frequency);
+	}
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	char const* const				m_name;							// Lock name
+	std::atomic<uint64_t>			m_acquisitions;					// Number of acquisitions
+	std::atomic<uint64_t>			m_contentions;					// Number of contended acquisitions
+	std::atomic<uint64_t>			m_waitns;						// Total wait time
+	std::atomic<uint64_t>			m_maxholdns;					// Maximum exclusive hold time
+	std::atomic<uint64_t>			m_histogram[HISTOGRAM_BUCKETS];	// Wait time histogram
+	lock_profile*					m_next;							// Next registered profile
+};
+
+#endif	// SYNC_LOCK_PROFILING
+
 // critical_section
 //
 // Win32 critical section implementation
@@ -47,9 +231,20 @@ class critical_section
 {
 public:
 
-	// Instance Constructor
+	// Instance Constructors
 	//
-	critical_section() { InitializeCriticalSection(&m_cs); }
+	critical_section() : critical_section(nullptr) {}
+	explicit critical_section(char const* name)
+	{
+		InitializeCriticalSection(&m_cs);
+
+#ifdef SYNC_LOCK_PROFILING
+		m_profile = (name) ? lock_profile::find(name) : nullptr;
+		m_acquired = 0;
+#else
+		UNREFERENCED_PARAMETER(name);
+#endif
+	}
 
 	// Destructor
 	//
@@ -61,17 +256,50 @@ public:
 	// lock
 	//
 	// Enters the critical section
-	void lock(void) { EnterCriticalSection(&m_cs); }
+	void lock(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) {
+
+			bool contended = (TryEnterCriticalSection(&m_cs) == FALSE);
+			uint64_t start = (contended) ? lock_profile::timestamp() : 0;
+			if(contended) EnterCriticalSection(&m_cs);
+
+			m_profile->acquired(contended, (contended) ? lock_profile::timestamp() - start : 0);
+			if(m_cs.RecursionCount == 1) m_acquired = lock_profile::timestamp();
+			return;
+		}
+#endif
+		EnterCriticalSection(&m_cs);
+	}
 
 	// try_lock
 	//
 	// Attempts to enter the critical section, fails if already entered
-	bool try_lock(void) { return (TryEnterCriticalSection(&m_cs) == TRUE); }
+	bool try_lock(void)
+	{
+		if(TryEnterCriticalSection(&m_cs) == FALSE) return false;
+
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) {
+
+			m_profile->acquired(false, 0);
+			if(m_cs.RecursionCount == 1) m_acquired = lock_profile::timestamp();
+		}
+#endif
+		return true;
+	}
 
 	// unlock
 	//
 	// Leaves the critical section
-	void unlock(void) { LeaveCriticalSection(&m_cs); }
+	void unlock(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if((m_profile) && (m_cs.RecursionCount == 1)) m_profile->released(lock_profile::timestamp() - m_acquired);
+#endif
+		LeaveCriticalSection(&m_cs);
+	}
 
 	// critical_section::scoped_lock
 	//
@@ -114,6 +342,11 @@ private:
 	// Member Variables
 
 	CRITICAL_SECTION		m_cs;		// Underlying CRITICAL_SECTION
+
+#ifdef SYNC_LOCK_PROFILING
+	lock_profile*			m_profile;	// Lock profile or nullptr
+	uint64_t				m_acquired;	// Time the lock was acquired
+#endif
 };
 
 // reader_writer_lock
@@ -123,9 +356,18 @@ class reader_writer_lock
 {
 public:
 
-	// Instance Constructor
+	// Instance Constructors
 	//
-	reader_writer_lock() : m_srwl(SRWLOCK_INIT) {}
+	reader_writer_lock() : reader_writer_lock(nullptr) {}
+	explicit reader_writer_lock(char const* name) : m_srwl(SRWLOCK_INIT)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		m_profile = (name) ? lock_profile::find(name) : nullptr;
+		m_acquired = 0;
+#else
+		UNREFERENCED_PARAMETER(name);
+#endif
+	}
 
 	// Destructor
 	//
@@ -137,22 +379,67 @@ public:
 	// lock_read
 	//
 	// Acquires a shared reader lock
-	void lock_read(void) { AcquireSRWLockShared(&m_srwl); }
+	void lock_read(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) {
+
+			bool contended = (TryAcquireSRWLockShared(&m_srwl) == FALSE);
+			uint64_t start = (contended) ? lock_profile::timestamp() : 0;
+			if(contended) AcquireSRWLockShared(&m_srwl);
+
+			m_profile->acquired(contended, (contended) ? lock_profile::timestamp() - start : 0);
+			return;
+		}
+#endif
+		AcquireSRWLockShared(&m_srwl);
+	}
 
 	// lock_write
 	//
 	// Acquires an exclusive writer lock
-	void lock_write(void) { AcquireSRWLockExclusive(&m_srwl); }
+	void lock_write(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) {
+
+			bool contended = (TryAcquireSRWLockExclusive(&m_srwl) == FALSE);
+			uint64_t start = (contended) ? lock_profile::timestamp() : 0;
+			if(contended) AcquireSRWLockExclusive(&m_srwl);
+
+			m_profile->acquired(contended, (contended) ? lock_profile::timestamp() - start : 0);
+			m_acquired = lock_profile::timestamp();
+			return;
+		}
+#endif
+		AcquireSRWLockExclusive(&m_srwl);
+	}
 
 	// try_lock_read
 	//
 	// Attempts to acquire a shared reader lock
-	bool try_lock_read(void) { return (TryAcquireSRWLockShared(&m_srwl)) ? true : false; }
+	bool try_lock_read(void)
+	{
+		if(!TryAcquireSRWLockShared(&m_srwl)) return false;
+
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) m_profile->acquired(false, 0);
+#endif
+		return true;
+	}
 
 	// try_lock_write
 	//
 	// Attempts to acquire an exclusive writer lock
-	bool try_lock_write(void) { return (TryAcquireSRWLockExclusive(&m_srwl)) ? true : false; }
+	bool try_lock_write(void)
+	{
+		if(!TryAcquireSRWLockExclusive(&m_srwl)) return false;
+
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) { m_profile->acquired(false, 0); m_acquired = lock_profile::timestamp(); }
+#endif
+		return true;
+	}
 
 	// unlock_read
 	//
@@ -162,7 +449,13 @@ public:
 	// unlock_write
 	//
 	// Releases an exclusive writer lock
-	void unlock_write(void) { ReleaseSRWLockExclusive(&m_srwl); }
+	void unlock_write(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) m_profile->released(lock_profile::timestamp() - m_acquired);
+#endif
+		ReleaseSRWLockExclusive(&m_srwl);
+	}
 
 	// reader_writer_lock::scoped_lock
 	//
@@ -251,6 +544,438 @@ private:
 	// Member Variables
 
 	SRWLOCK						m_srwl;			// Underlying SRWLOCK object
+
+#ifdef SYNC_LOCK_PROFILING
+	lock_profile*				m_profile;		// Lock profile or nullptr
+	uint64_t					m_acquired;		// Time the lock was acquired
+#endif
+};
+
+// distributed_reader_writer_lock
+//
+// Read-mostly ("big reader") variant of reader_writer_lock.  The lock is split
+// into a number of cache line aligned slim reader/writer locks; readers acquire
+// only the slot associated with the calling thread so that shared acquisitions
+// on different processors do not write the same cache line, while writers must
+// acquire every slot in order.  Since a thread always maps to the same slot the
+// reader does not need to remember which slot was acquired, use only for locks
+// that are rarely taken exclusively
+class distributed_reader_writer_lock
+{
+public:
+
+	// Instance Constructors
+	//
+	distributed_reader_writer_lock() : distributed_reader_writer_lock(nullptr) {}
+	explicit distributed_reader_writer_lock(char const* name) : m_count(slot_count())
+	{
+		m_slots = reinterpret_cast<slot_t*>(_aligned_malloc(sizeof(slot_t) * m_count, alignof(slot_t)));
+		if(m_slots == nullptr) throw std::bad_alloc();
+
+		for(size_t index = 0; index < m_count; index++) InitializeSRWLock(&m_slots[index].srwl);
+
+#ifdef SYNC_LOCK_PROFILING
+		m_profile = (name) ? lock_profile::find(name) : nullptr;
+		m_acquired = 0;
+#else
+		UNREFERENCED_PARAMETER(name);
+#endif
+	}
+
+	// Destructor
+	//
+	~distributed_reader_writer_lock() { _aligned_free(m_slots); }
+
+	//-----------------------------------------------------------------------
+	// Member Functions
+
+	// lock_read
+	//
+	// Acquires a shared reader lock
+	void lock_read(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) {
+
+			PSRWLOCK srwl = &m_slots[slot_index()].srwl;
+			bool contended = (TryAcquireSRWLockShared(srwl) == FALSE);
+			uint64_t start = (contended) ? lock_profile::timestamp() : 0;
+			if(contended) AcquireSRWLockShared(srwl);
+
+			m_profile->acquired(contended, (contended) ? lock_profile::timestamp() - start : 0);
+			return;
+		}
+#endif
+		AcquireSRWLockShared(&m_slots[slot_index()].srwl);
+	}
+
+	// lock_write
+	//
+	// Acquires an exclusive writer lock
+	void lock_write(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) {
+
+			bool contended = false;
+			uint64_t start = lock_profile::timestamp();
+
+			for(size_t index = 0; index < m_count; index++) {
+
+				if(TryAcquireSRWLockExclusive(&m_slots[index].srwl)) continue;
+
+				contended = true;
+				AcquireSRWLockExclusive(&m_slots[index].srwl);
+			}
+
+			m_acquired = lock_profile::timestamp();
+			m_profile->acquired(contended, m_acquired - start);
+			return;
+		}
+#endif
+		for(size_t index = 0; index < m_count; index++) AcquireSRWLockExclusive(&m_slots[index].srwl);
+	}
+
+	// try_lock_read
+	//
+	// Attempts to acquire a shared reader lock
+	bool try_lock_read(void)
+	{
+		if(!TryAcquireSRWLockShared(&m_slots[slot_index()].srwl)) return false;
+
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) m_profile->acquired(false, 0);
+#endif
+		return true;
+	}
+
+	// try_lock_write
+	//
+	// Attempts to acquire an exclusive writer lock
+	bool try_lock_write(void)
+	{
+		for(size_t index = 0; index < m_count; index++) {
+
+			if(!TryAcquireSRWLockExclusive(&m_slots[index].srwl)) {
+
+				// Release any slots that were acquired before the failure
+				while(index > 0) ReleaseSRWLockExclusive(&m_slots[--index].srwl);
+				return false;
+			}
+		}
+
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) { m_profile->acquired(false, 0); m_acquired = lock_profile::timestamp(); }
+#endif
+		return true;
+	}
+
+	// unlock_read
+	//
+	// Releases a shared reader lock
+	void unlock_read(void) { ReleaseSRWLockShared(&m_slots[slot_index()].srwl); }
+
+	// unlock_write
+	//
+	// Releases an exclusive writer lock
+	void unlock_write(void)
+	{
+#ifdef SYNC_LOCK_PROFILING
+		if(m_profile) m_profile->released(lock_profile::timestamp() - m_acquired);
+#endif
+		for(size_t index = m_count; index > 0; index--) ReleaseSRWLockExclusive(&m_slots[index - 1].srwl);
+	}
+
+	// distributed_reader_writer_lock::scoped_lock
+	//
+	class scoped_lock
+	{
+	protected:
+
+		// Instance Constructor
+		//
+		scoped_lock(distributed_reader_writer_lock& rwl) : m_rwl(rwl), m_held(true) {}
+
+		//---------------------------------------------------------------------
+		// Protected Member Variables
+
+		distributed_reader_writer_lock&		m_rwl;		// Referenced distributed_reader_writer_lock
+		bool								m_held;		// Flag if the reader is held
+
+	private:
+
+		scoped_lock(const scoped_lock&)=delete;
+		scoped_lock& operator=(const scoped_lock&)=delete;
+	};
+
+	// distributed_reader_writer_lock::scoped_lock_read
+	//
+	class scoped_lock_read : public scoped_lock
+	{
+	public:
+
+		// Instance Constructor
+		//
+		explicit scoped_lock_read(distributed_reader_writer_lock& rwl) : scoped_lock(rwl) { m_rwl.lock_read(); }
+
+		// Destructor
+		//
+		~scoped_lock_read() { if(m_held) m_rwl.unlock_read(); }
+
+		//---------------------------------------------------------------------
+		// Member Functions
+
+		// unlock
+		//
+		// Unlocks the scoped lock before it falls out of scope
+		void unlock(void) { if(m_held) m_rwl.unlock_read(); m_held = false; }
+
+	private:
+
+		scoped_lock_read(const scoped_lock_read&)=delete;
+		scoped_lock_read& operator=(const scoped_lock_read&)=delete;
+	};
+
+	// distributed_reader_writer_lock::scoped_lock_write
+	//
+	class scoped_lock_write : public scoped_lock
+	{
+	public:
+
+		// Instance Constructor
+		//
+		explicit scoped_lock_write(distributed_reader_writer_lock& rwl) : scoped_lock(rwl) { m_rwl.lock_write(); }
+
+		// Destructor
+		//
+		~scoped_lock_write() { if(m_held) m_rwl.unlock_write(); }
+
+		//---------------------------------------------------------------------
+		// Member Functions
+
+		// unlock
+		//
+		// Unlocks the scoped lock before it falls out of scope
+		void unlock(void) { if(m_held) m_rwl.unlock_write(); m_held = false; }
+
+	private:
+
+		scoped_lock_write(const scoped_lock_write&)=delete;
+		scoped_lock_write& operator=(const scoped_lock_write&)=delete;
+	};
+
+private:
+
+	distributed_reader_writer_lock(const distributed_reader_writer_lock&)=delete;
+	distributed_reader_writer_lock& operator=(const distributed_reader_writer_lock&)=delete;
+
+	// MAX_SLOTS
+	//
+	// Maximum number of slots allocated for a single lock
+	static size_t const MAX_SLOTS = 64;
+
+	// slot_t
+	//
+	// Cache line aligned SRWLOCK
+	struct alignas(64) slot_t
+	{
+		SRWLOCK		srwl;			// Underlying SRWLOCK object
+	};
+
+	// slot_count (static)
+	//
+	// Determines the number of slots to allocate for a lock
+	static size_t slot_count(void)
+	{
+		static size_t const count = []() -> size_t {
+
+			DWORD processors = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+			return (processors == 0) ? 1 : (processors < MAX_SLOTS) ? processors : MAX_SLOTS;
+		}();
+
+		return count;
+	}
+
+	// slot_index
+	//
+	// Determines the slot associated with the calling thread; thread identifiers
+	// are multiples of four so the low bits are discarded
+	size_t slot_index(void) const { return (GetCurrentThreadId() >> 2) % m_count; }
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	size_t const				m_count;		// Number of lock slots
+	slot_t*						m_slots;		// Array of lock slots
+
+#ifdef SYNC_LOCK_PROFILING
+	lock_profile*				m_profile;		// Lock profile or nullptr
+	uint64_t					m_acquired;		// Time the lock was acquired
+#endif
+};
+
+// range_lock
+//
+// Byte range lock; shared and exclusive ranges can be held concurrently as long
+// as no exclusive range overlaps any other range.  Each scoped lock object is
+// the record of the range it holds, no memory is allocated to lock a range
+class range_lock
+{
+public:
+
+	// Instance Constructor
+	//
+	range_lock() : m_srwl(SRWLOCK_INIT), m_cv(CONDITION_VARIABLE_INIT), m_ranges(nullptr) {}
+
+	// Destructor
+	//
+	~range_lock()=default;
+
+	// range_lock::scoped_lock
+	//
+	class scoped_lock
+	{
+	protected:
+
+		// Instance Constructor
+		//
+		scoped_lock(range_lock& rl, size_t offset, size_t length, bool exclusive) : m_rl(rl), m_held(length > 0), m_offset(offset), 
+			m_end((length > (SIZE_MAX - offset)) ? SIZE_MAX : offset + length), m_exclusive(exclusive), m_prev(nullptr), m_next(nullptr) 
+		{
+			if(m_held) m_rl.lock(this);
+		}
+
+		// Destructor
+		//
+		~scoped_lock() { if(m_held) m_rl.unlock(this); }
+
+		//---------------------------------------------------------------------
+		// Protected Member Variables
+
+		range_lock&					m_rl;			// Referenced range_lock
+		bool						m_held;			// Flag if the range is held
+
+	private:
+
+		friend class range_lock;
+
+		scoped_lock(const scoped_lock&)=delete;
+		scoped_lock& operator=(const scoped_lock&)=delete;
+
+		//---------------------------------------------------------------------
+		// Member Variables
+
+		size_t const				m_offset;		// Starting offset of the range
+		size_t const				m_end;			// Ending offset of the range
+		bool const					m_exclusive;	// Flag if range is exclusive
+		scoped_lock*				m_prev;			// Previous held range
+		scoped_lock*				m_next;			// Next held range
+	};
+
+	// range_lock::scoped_lock_read
+	//
+	class scoped_lock_read : public scoped_lock
+	{
+	public:
+
+		// Instance Constructor
+		//
+		scoped_lock_read(range_lock& rl, size_t offset, size_t length) : scoped_lock(rl, offset, length, false) {}
+
+		//---------------------------------------------------------------------
+		// Member Functions
+
+		// unlock
+		//
+		// Unlocks the scoped lock before it falls out of scope
+		void unlock(void) { if(m_held) m_rl.unlock(this); m_held = false; }
+
+	private:
+
+		scoped_lock_read(const scoped_lock_read&)=delete;
+		scoped_lock_read& operator=(const scoped_lock_read&)=delete;
+	};
+
+	// range_lock::scoped_lock_write
+	//
+	class scoped_lock_write : public scoped_lock
+	{
+	public:
+
+		// Instance Constructor
+		//
+		scoped_lock_write(range_lock& rl, size_t offset, size_t length) : scoped_lock(rl, offset, length, true) {}
+
+		//---------------------------------------------------------------------
+		// Member Functions
+
+		// unlock
+		//
+		// Unlocks the scoped lock before it falls out of scope
+		void unlock(void) { if(m_held) m_rl.unlock(this); m_held = false; }
+
+	private:
+
+		scoped_lock_write(const scoped_lock_write&)=delete;
+		scoped_lock_write& operator=(const scoped_lock_write&)=delete;
+	};
+
+private:
+
+	range_lock(const range_lock&)=delete;
+	range_lock& operator=(const range_lock&)=delete;
+
+	// conflicts
+	//
+	// Determines if a range conflicts with any range that is currently held
+	bool conflicts(scoped_lock const* range) const
+	{
+		for(scoped_lock const* held = m_ranges; held; held = held->m_next) {
+
+			if((range->m_offset < held->m_end) && (held->m_offset < range->m_end) && (range->m_exclusive || held->m_exclusive)) return true;
+		}
+
+		return false;
+	}
+
+	// lock
+	//
+	// Waits for a range to become available and adds it to the held ranges
+	void lock(scoped_lock* range)
+	{
+		AcquireSRWLockExclusive(&m_srwl);
+
+		while(conflicts(range)) SleepConditionVariableSRW(&m_cv, &m_srwl, INFINITE, 0);
+
+		range->m_prev = nullptr;
+		range->m_next = m_ranges;
+		if(m_ranges) m_ranges->m_prev = range;
+		m_ranges = range;
+
+		ReleaseSRWLockExclusive(&m_srwl);
+	}
+
+	// unlock
+	//
+	// Removes a range from the held ranges and wakes any waiters
+	void unlock(scoped_lock* range)
+	{
+		AcquireSRWLockExclusive(&m_srwl);
+
+		if(range->m_prev) range->m_prev->m_next = range->m_next;
+		else m_ranges = range->m_next;
+		if(range->m_next) range->m_next->m_prev = range->m_prev;
+
+		ReleaseSRWLockExclusive(&m_srwl);
+		WakeAllConditionVariable(&m_cv);
+	}
+
+	//-----------------------------------------------------------------------
+	// Member Variables
+
+	SRWLOCK						m_srwl;			// Underlying SRWLOCK object
+	CONDITION_VARIABLE			m_cv;			// Range released condition
+	scoped_lock*				m_ranges;		// Currently held ranges
 };
 
 //---------------------------------------------------------------------------
@@ -26,7 +26,10 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <cwchar>
 #include <cwctype>
+#include <emmintrin.h>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -72,14 +75,37 @@ namespace std {
 	{
 		if(psz == nullptr) return std::string();
 
-		// Create a buffer big enough to hold the converted string data and convert it
-		int buffercch = WideCharToMultiByte(CP_UTF8, 0, psz, cch, nullptr, 0, nullptr, nullptr);
-		auto buffer = std::make_unique<char_t[]>(buffercch);
-		WideCharToMultiByte(CP_UTF8, 0, psz, cch, buffer.get(), buffercch, nullptr, nullptr);
+		size_t length = (cch == -1) ? wcslen(psz) : static_cast<size_t>(cch);
+		size_t index = 0;
 
-		// Construct an std::string around the converted character data, watch for the API
-		// returning the length including the NULL character when -1 was provided as length
-		return std::string(buffer.get(), (cch == -1) ? buffercch - 1 : buffercch);
+		// Size the result for all-ASCII input; short results are stored inline by std::string
+		std::string result;
+		result.resize(length);
+		char_t* dest = &result[0];
+
+		// ASCII fast path: narrow eight characters at a time until a non-ASCII character is found
+		__m128i const highbits = _mm_set1_epi16(static_cast<short>(0xFF80));
+		__m128i const zero = _mm_setzero_si128();
+		while((length - index) >= 8) {
+
+			__m128i chars = _mm_loadu_si128(reinterpret_cast<__m128i const*>(psz + index));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chars, highbits), zero)) != 0xFFFF) break;
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dest + index), _mm_packus_epi16(chars, chars));
+			index += 8;
+		}
+
+		while((index < length) && (psz[index] < 0x80)) { dest[index] = static_cast<char_t>(psz[index]); index++; }
+		if(index == length) return result;
+
+		// Convert the remainder in a single pass into a worst-case buffer; each UTF-16 code unit
+		// produces at most three UTF-8 code units (surrogate pairs produce four from two)
+		int remaining = static_cast<int>(length - index);
+		result.resize(index + (remaining * 3));
+		int converted = WideCharToMultiByte(CP_UTF8, 0, psz + index, remaining, &result[index], remaining * 3, nullptr, nullptr);
+		result.resize(index + converted);
+
+		return result;
 	}
 
 	// std::to_string overloads
@@ -97,14 +123,37 @@ namespace std {
 	{
 		if(psz == nullptr) return std::wstring();
 
-		// Create a buffer big enough to hold the converted string data and convert it
-		int buffercch = MultiByteToWideChar(CP_UTF8, 0, psz, cch, nullptr, 0);
-		auto buffer = std::make_unique<wchar_t[]>(buffercch);
-		MultiByteToWideChar(CP_UTF8, 0, psz, cch, buffer.get(), buffercch);
+		size_t length = (cch == -1) ? strlen(psz) : static_cast<size_t>(cch);
+		size_t index = 0;
+
+		// Size the result for all-ASCII input; short results are stored inline by std::wstring
+		std::wstring result;
+		result.resize(length);
+		wchar_t* dest = &result[0];
+
+		// ASCII fast path: widen sixteen characters at a time until a non-ASCII character is found
+		__m128i const zero = _mm_setzero_si128();
+		while((length - index) >= 16) {
+
+			__m128i chars = _mm_loadu_si128(reinterpret_cast<__m128i const*>(psz + index));
+			if(_mm_movemask_epi8(chars) != 0) break;
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + index), _mm_unpacklo_epi8(chars, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + index + 8), _mm_unpackhi_epi8(chars, zero));
+			index += 16;
+		}
+
+		while((index < length) && (static_cast<unsigned char>(psz[index]) < 0x80)) { dest[index] = static_cast<wchar_t>(psz[index]); index++; }
+		if(index == length) return result;
+
+		// Convert the remainder in a single pass into a worst-case buffer; each UTF-8 code unit
+		// produces at most one UTF-16 code unit
+		int remaining = static_cast<int>(length - index);
+		result.resize(index + remaining);
+		int converted = MultiByteToWideChar(CP_UTF8, 0, psz + index, remaining, &result[index], remaining);
+		result.resize(index + converted);
 
-		// Construct an std::wstring around the converted character data, watch for the API
-		// returning the length including the NULL character when -1 was provided as length
-		return std::wstring(buffer.get(), (cch == -1) ? buffercch - 1 : buffercch);
+		return result;
 	}
 
 	// std::to_wstring overloads
@@ -145,10 +194,10 @@ namespace std {
 	// Performs an lowercase conversion of a string
 	inline std::string tolower(const std::string& str)
 	{
-		std::string result;
+		std::string result(str);
 
-		result.resize(str.size());
-		std::transform(str.begin(), str.end(), result.begin(), ::tolower);
+		// Characters are converted in place; narrow characters must be passed as unsigned
+		std::transform(result.begin(), result.end(), result.begin(), [](char_t ch) -> char_t { return static_cast<char_t>(::tolower(static_cast<unsigned char>(ch))); });
 
 		return result;
 	}
@@ -158,10 +207,10 @@ namespace std {
 	// Performs an lowercase conversion of a string
 	inline std::wstring tolower(const std::wstring& str)
 	{
-		std::wstring result;
+		std::wstring result(str);
 
-		result.resize(str.size());
-		std::transform(str.begin(), str.end(), result.begin(), ::towlower);
+		// Characters are converted in place
+		std::transform(result.begin(), result.end(), result.begin(), [](wchar_t ch) -> wchar_t { return static_cast<wchar_t>(::towlower(ch)); });
 
 		return result;
 	}
@@ -171,10 +220,10 @@ namespace std {
 	// Performs an uppercase conversion of a string
 	inline std::string toupper(const std::string& str)
 	{
-		std::string result;
+		std::string result(str);
 
-		result.resize(str.size());
-		std::transform(str.begin(), str.end(), result.begin(), ::toupper);
+		// Characters are converted in place; narrow characters must be passed as unsigned
+		std::transform(result.begin(), result.end(), result.begin(), [](char_t ch) -> char_t { return static_cast<char_t>(::toupper(static_cast<unsigned char>(ch))); });
 
 		return result;
 	}
@@ -184,10 +233,10 @@ namespace std {
 	// Performs an uppercase conversion of a string
 	inline std::wstring toupper(const std::wstring& str)
 	{
-		std::wstring result;
+		std::wstring result(str);
 
-		result.resize(str.size());
-		std::transform(str.begin(), str.end(), result.begin(), ::towupper);
+		// Characters are converted in place
+		std::transform(result.begin(), result.end(), result.begin(), [](wchar_t ch) -> wchar_t { return static_cast<wchar_t>(::towupper(ch)); });
 
 		return result;
 	}
@@ -0,0 +1,242 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "BootTrace.h"
+
+#include <iomanip>
+#include <sstream>
+#include <Win32Exception.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// GetTimestampFrequency (local)
+//
+// Gets the frequency of the performance counter
+//
+// Arguments:
+//
+//	NONE
+
+static int64_t GetTimestampFrequency(void)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return frequency.QuadPart;
+}
+
+//-----------------------------------------------------------------------------
+// WriteJsonString (local)
+//
+// Writes an escaped JSON string literal into an output stream
+//
+// Arguments:
+//
+//	stream		- Output stream
+//	value		- String to be escaped and written
+
+static void WriteJsonString(std::ostream& stream, char const* value)
+{
+	stream << '"';
+
+	for(char const* ch = value; (ch) && (*ch); ch++) {
+
+		switch(*ch) {
+
+			case '"': stream << "\\\""; break;
+			case '\\': stream << "\\\\"; break;
+			case '\n': stream << "\\n"; break;
+			case '\r': stream << "\\r"; break;
+			case '\t': stream << "\\t"; break;
+
+			default:
+				
+				// Remaining control characters must be written as unicode escapes
+				if(static_cast<uint8_t>(*ch) < 0x20) stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(*ch) << std::dec;
+				else stream << *ch;
+		}
+	}
+
+	stream << '"';
+}
+
+//-----------------------------------------------------------------------------
+// BootTrace Constructor
+//
+// Arguments:
+//
+//	NONE
+
+BootTrace::BootTrace() : m_origin(Timestamp()), m_frequency(GetTimestampFrequency()), m_lock("BootTrace::m_lock")
+{
+}
+
+//-----------------------------------------------------------------------------
+// BootTrace::Record
+//
+// Records a completed span into the trace
+//
+// Arguments:
+//
+//	category	- Span category
+//	name		- Span name
+//	start		- Starting timestamp
+//	end			- Ending timestamp
+
+void BootTrace::Record(char const* category, char const* name, int64_t start, int64_t end)
+{
+	sync::critical_section::scoped_lock cs{ m_lock };
+	m_events.push_back({ category, name, start, end, GetCurrentThreadId() });
+}
+
+//-----------------------------------------------------------------------------
+// BootTrace::Timestamp (static)
+//
+// Gets the current performance counter timestamp
+//
+// Arguments:
+//
+//	NONE
+
+int64_t BootTrace::Timestamp(void)
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+//-----------------------------------------------------------------------------
+// BootTrace::Write
+//
+// Writes the recorded spans out to a Chrome trace-event JSON file
+//
+// Arguments:
+//
+//	path		- Path to the output file
+
+void BootTrace::Write(tchar_t const* path) const
+{
+	std::ostringstream		stream;				// Output JSON stream
+
+	if(path == nullptr) throw Win32Exception(ERROR_INVALID_PARAMETER);
+
+	// ToMicroseconds (local)
+	//
+	// Converts a timestamp interval into fractional microseconds
+	auto ToMicroseconds = [&](int64_t ticks) -> double { return (static_cast<double>(ticks) * 1000000.0) / static_cast<double>(m_frequency); };
+
+	stream << "{\"traceEvents\":[";
+	stream << std::fixed << std::setprecision(3);
+
+	// Each span is written as a complete ("X") event, the viewer derives the nesting from the
+	// timestamps and durations of the events recorded on each thread
+	sync::critical_section::scoped_lock cs{ m_lock };
+	for(size_t index = 0; index < m_events.size(); index++) {
+
+		auto const& event = m_events[index];
+
+		if(index > 0) stream << ',';
+		stream << "\n{\"name\":";
+		WriteJsonString(stream, event.name.c_str());
+		stream << ",\"cat\":";
+		WriteJsonString(stream, event.category);
+		stream << ",\"ph\":\"X\",\"ts\":" << ToMicroseconds(event.start - m_origin) << ",\"dur\":" << ToMicroseconds(event.end - event.start) << 
+			",\"pid\":" << GetCurrentProcessId() << ",\"tid\":" << event.threadid << '}';
+	}
+	cs.unlock();
+
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	std::string json = stream.str();
+
+	// Create or overwrite the output file and write the generated JSON into it
+	HANDLE file = CreateFile(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE) throw Win32Exception();
+
+	DWORD written = 0;
+	BOOL result = WriteFile(file, json.data(), static_cast<DWORD>(json.length()), &written, nullptr);
+	DWORD error = GetLastError();
+
+	CloseHandle(file);
+	if(!result) throw Win32Exception(error);
+}
+
+//
+// BOOTTRACE::SPAN IMPLEMENTATION
+//
+
+//-----------------------------------------------------------------------------
+// BootTrace::Span Constructor
+//
+// Arguments:
+//
+//	trace		- BootTrace instance to record into, or nullptr
+//	category	- Span category
+//	name		- Span name
+
+BootTrace::Span::Span(BootTrace* trace, char const* category, char const* name) : m_trace(trace), m_category(category), m_start(0)
+{
+	if(m_trace == nullptr) return;
+
+	m_name = (name) ? name : "";
+	m_start = BootTrace::Timestamp();
+}
+
+//-----------------------------------------------------------------------------
+// BootTrace::Span Move Constructor
+
+BootTrace::Span::Span(Span&& rhs) : m_trace(rhs.m_trace), m_category(rhs.m_category), m_name(std::move(rhs.m_name)), m_start(rhs.m_start)
+{
+	rhs.m_trace = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// BootTrace::Span Destructor
+
+BootTrace::Span::~Span()
+{
+	// Spans that were not explicitly ended (exceptions) are recorded here
+	try { End(); }
+	catch(...) { /* DO NOTHING */ }
+}
+
+//-----------------------------------------------------------------------------
+// BootTrace::Span::End
+//
+// Ends the span and records it into the trace
+//
+// Arguments:
+//
+//	NONE
+
+void BootTrace::Span::End(void)
+{
+	if(m_trace == nullptr) return;
+
+	m_trace->Record(m_category, m_name.c_str(), m_start, BootTrace::Timestamp());
+	m_trace = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
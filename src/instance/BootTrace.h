@@ -0,0 +1,141 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __BOOTTRACE_H_
+#define __BOOTTRACE_H_
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sync.h>
+#include <text.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// BootTrace
+//
+// Records timed spans during virtual machine startup and writes them out in the
+// Chrome trace-event JSON format (chrome://tracing, Perfetto).  Timestamps are
+// taken from the performance counter and reported relative to the construction
+// of the trace instance
+
+class BootTrace
+{
+public:
+
+	// Instance Constructor
+	//
+	BootTrace();
+
+	// Destructor
+	//
+	~BootTrace()=default;
+
+	// Span
+	//
+	// Records a single span into a BootTrace when it is ended or destroyed; a span
+	// constructed against a null BootTrace pointer does nothing
+	class Span
+	{
+	public:
+
+		// Instance Constructors
+		//
+		Span(BootTrace* trace, char const* category, char const* name);
+		Span(Span&& rhs);
+
+		// Destructor
+		//
+		~Span();
+
+		//---------------------------------------------------------------------
+		// Member Functions
+
+		// End
+		//
+		// Ends the span and records it into the trace
+		void End(void);
+
+	private:
+
+		Span(Span const&)=delete;
+		Span& operator=(Span const&)=delete;
+
+		//---------------------------------------------------------------------
+		// Member Variables
+
+		BootTrace*				m_trace;		// Owning BootTrace instance
+		char const*				m_category;		// Span category
+		std::string				m_name;			// Span name
+		int64_t					m_start;		// Span starting timestamp
+	};
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Record
+	//
+	// Records a completed span into the trace
+	void Record(char const* category, char const* name, int64_t start, int64_t end);
+
+	// Timestamp (static)
+	//
+	// Gets the current performance counter timestamp
+	static int64_t Timestamp(void);
+
+	// Write
+	//
+	// Writes the recorded spans out to a Chrome trace-event JSON file
+	void Write(tchar_t const* path) const;
+
+private:
+
+	BootTrace(BootTrace const&)=delete;
+	BootTrace& operator=(BootTrace const&)=delete;
+
+	// event_t
+	//
+	// Represents a single recorded span
+	struct event_t
+	{
+		char const*				category;		// Span category
+		std::string				name;			// Span name
+		int64_t					start;			// Starting timestamp
+		int64_t					end;			// Ending timestamp
+		DWORD					threadid;		// Recording thread identifier
+	};
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	int64_t const					m_origin;		// Trace origin timestamp
+	int64_t const					m_frequency;	// Performance counter frequency
+	std::vector<event_t>			m_events;		// Recorded events
+	mutable sync::critical_section	m_lock;			// Synchronization object
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __BOOTTRACE_H_
@@ -71,7 +71,7 @@ CompressedFileReader::CompressedFileReader(tchar_t const* path, size_t offset) :
 //	offset		- Offset within the file to begin reading
 //	length		- Maximum number of bytes to read from the file
 
-CompressedFileReader::CompressedFileReader(tchar_t const* path, size_t offset, size_t length) : m_view(nullptr)
+CompressedFileReader::CompressedFileReader(tchar_t const* path, size_t offset, size_t length) : m_view(nullptr), m_length(0), m_format(CompressionFormat::None)
 {
 	LARGE_INTEGER			filesize;				// Size of the input file
 	ULARGE_INTEGER			uloffset;				// Offset as a ULARGE_INTEGER
@@ -95,6 +95,7 @@ CompressedFileReader::CompressedFileReader(tchar_t const* path, size_t offset, s
 
 		// Adjust the length to the actual file size if zero was specified
 		length = (length == 0) ? static_cast<size_t>(filesize.QuadPart) : length;
+		m_length = length;
 
 		// Map the specified file with PAGE_READONLY access
 		HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, filesize.HighPart, filesize.LowPart, nullptr);
@@ -109,24 +110,39 @@ CompressedFileReader::CompressedFileReader(tchar_t const* path, size_t offset, s
 			try {
 
 				// GZIP
-				if(CheckMagic(m_view, length, UINT8_C(0x1F), UINT8_C(0x8B), UINT8_C(0x08), UINT8_C(0x00))) 
+				if(CheckMagic(m_view, length, UINT8_C(0x1F), UINT8_C(0x8B), UINT8_C(0x08), UINT8_C(0x00))) {
+
 					m_stream = std::make_unique<GZipStreamReader>(m_view, length);
+					m_format = CompressionFormat::GZip;
+				}
 
 				// XZ
-				else if(CheckMagic(m_view, length, UINT8_C(0xFD), '7', 'z', 'X', 'Z', UINT8_C(0x00))) 
+				else if(CheckMagic(m_view, length, UINT8_C(0xFD), '7', 'z', 'X', 'Z', UINT8_C(0x00))) {
+
 					m_stream = std::make_unique<XzStreamReader>(m_view, length);
+					m_format = CompressionFormat::Xz;
+				}
 
 				// BZIP2
-				else if(CheckMagic(m_view, length, 'B', 'Z', 'h')) 
+				else if(CheckMagic(m_view, length, 'B', 'Z', 'h')) {
+
 					m_stream = std::make_unique<BZip2StreamReader>(m_view, length);
+					m_format = CompressionFormat::BZip2;
+				}
 
 				// LZMA
-				else if(CheckMagic(m_view, length, UINT8_C(0x5D), UINT8_C(0x00), UINT8_C(0x00), UINT8_C(0x00))) 
+				else if(CheckMagic(m_view, length, UINT8_C(0x5D), UINT8_C(0x00), UINT8_C(0x00), UINT8_C(0x00))) {
+
 					m_stream = std::make_unique<LzmaStreamReader>(m_view, length);
+					m_format = CompressionFormat::Lzma;
+				}
 
 				// LZ4 (Legacy Format)
-				else if(CheckMagic(m_view, length, UINT8_C(0x02), UINT8_C(0x21), UINT8_C(0x4C), UINT8_C(0x18))) 
+				else if(CheckMagic(m_view, length, UINT8_C(0x02), UINT8_C(0x21), UINT8_C(0x4C), UINT8_C(0x18))) {
+
 					m_stream = std::make_unique<Lz4StreamReader>(m_view, length);
+					m_format = CompressionFormat::Lz4;
+				}
 
 				// UNKNOWN OR UNCOMPRESSED
 				else m_stream = std::make_unique<MemoryStreamReader>(m_view, length);
@@ -171,6 +187,26 @@ bool CompressedFileReader::CheckMagic(void* pointer, size_t length)
 	return true; 
 }
 	
+//-----------------------------------------------------------------------------
+// CompressedFileReader::getCompressedLength
+//
+// Gets the length of the underlying compressed data
+
+size_t CompressedFileReader::getCompressedLength(void) const
+{
+	return m_length;
+}
+
+//-----------------------------------------------------------------------------
+// CompressedFileReader::getFormat
+//
+// Gets the detected compression format of the underlying data
+
+CompressedFileReader::CompressionFormat CompressedFileReader::getFormat(void) const
+{
+	return m_format;
+}
+
 //-----------------------------------------------------------------------------
 // CompressedFileReader::getPosition
 //
@@ -42,6 +42,19 @@ class CompressedFileReader : public StreamReader
 {
 public:
 
+	// CompressionFormat
+	//
+	// Compression format detected for the underlying data
+	enum class CompressionFormat
+	{
+		None		= 0,		// Uncompressed data
+		BZip2,					// BZIP2
+		GZip,					// GZIP
+		Lz4,					// LZ4 (Legacy Format)
+		Lzma,					// LZMA
+		Xz,						// XZ
+	};
+
 	// Instance Constructors
 	//
 	CompressedFileReader(tchar_t const* path);
@@ -68,6 +81,18 @@ public:
 	//---------------------------------------------------------------------
 	// Properties
 
+	// CompressedLength
+	//
+	// Gets the length of the underlying compressed data
+	__declspec(property(get=getCompressedLength)) size_t CompressedLength;
+	size_t getCompressedLength(void) const;
+
+	// Format
+	//
+	// Gets the detected compression format of the underlying data
+	__declspec(property(get=getFormat)) CompressionFormat Format;
+	CompressionFormat getFormat(void) const;
+
 	// Position (StreamReader)
 	//
 	// Gets the current position within the stream
@@ -108,6 +133,8 @@ private:
 	// Member Variables
 
 	void*							m_view;		// Underlying mapped file view
+	size_t							m_length;	// Length of the mapped file view
+	CompressionFormat				m_format;	// Detected compression format
 	std::unique_ptr<StreamReader>	m_stream;	// Underlying stream implementation
 };
 
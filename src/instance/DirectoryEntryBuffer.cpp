@@ -0,0 +1,159 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "DirectoryEntryBuffer.h"
+
+#include <align.h>
+
+#include "LinuxException.h"
+
+#pragma warning(push, 4)
+
+// DT_XXXX values are the S_IFXXX node type bits shifted down into a single byte
+static_assert((UAPI_S_IFMT >> 12) <= 0xFF, "DirectoryEntryBuffer: S_IFMT >> 12 must fit in d_type");
+
+//-----------------------------------------------------------------------------
+// DirectoryEntryBuffer Constructor
+//
+// Arguments:
+//
+//	format		- Format of the directory entry records to be written
+//	buffer		- Output buffer
+//	length		- Length of the output buffer, in bytes
+
+DirectoryEntryBuffer::DirectoryEntryBuffer(VirtualMachine::DirectoryEntryFormat format, void* buffer, size_t length) : 
+	m_format(format), m_buffer(reinterpret_cast<uint8_t*>(buffer)), m_length(length), m_offset(0)
+{
+	if(buffer == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	if((format != VirtualMachine::DirectoryEntryFormat::Dirent) && (format != VirtualMachine::DirectoryEntryFormat::Dirent64))
+		throw LinuxException(UAPI_EINVAL);
+}
+
+//-----------------------------------------------------------------------------
+// DirectoryEntryBuffer::Append
+//
+// Appends a directory entry record; returns false if the record does not fit
+//
+// Arguments:
+//
+//	index		- Node index (inode number) of the entry
+//	mode		- Node type and permission flags of the entry
+//	name		- Name of the entry; need not be null terminated
+//	namelength	- Length of the entry name, in characters
+//	cookie		- Position at which the enumeration resumes after this entry
+
+bool DirectoryEntryBuffer::Append(int64_t index, uapi_mode_t mode, char_t const* name, size_t namelength, int64_t cookie)
+{
+	if(name == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	size_t reclen = RecordLength(m_format, namelength);
+	if(reclen > (m_length - m_offset)) return false;
+
+	uint8_t type = static_cast<uint8_t>((mode & UAPI_S_IFMT) >> 12);
+
+	// struct linux_dirent64 -- d_type precedes d_name and the record is 8-byte aligned
+	if(m_format == VirtualMachine::DirectoryEntryFormat::Dirent64) {
+
+		// Zero out the entire record to initialize the terminator and any padding
+		uapi_linux_dirent64* dirent = reinterpret_cast<uapi_linux_dirent64*>(&m_buffer[m_offset]);
+		memset(dirent, 0, reclen);
+
+		dirent->d_ino = static_cast<decltype(dirent->d_ino)>(index);
+		dirent->d_off = static_cast<decltype(dirent->d_off)>(cookie);
+		dirent->d_reclen = static_cast<decltype(dirent->d_reclen)>(reclen);
+		dirent->d_type = type;
+		memcpy(dirent->d_name, name, namelength);
+	}
+
+	// struct linux_dirent -- d_type is stored in the last byte of the record, which is long aligned
+	else {
+
+		uapi_linux_dirent* dirent = reinterpret_cast<uapi_linux_dirent*>(&m_buffer[m_offset]);
+
+		// The inode number and cookie must fit in an unsigned long for this format
+		if(static_cast<uint64_t>(index) > std::numeric_limits<decltype(dirent->d_ino)>::max()) throw LinuxException(UAPI_EOVERFLOW);
+		if(static_cast<uint64_t>(cookie) > std::numeric_limits<decltype(dirent->d_off)>::max()) throw LinuxException(UAPI_EOVERFLOW);
+
+		// Zero out the entire record to initialize the terminator and any padding
+		memset(dirent, 0, reclen);
+
+		dirent->d_ino = static_cast<decltype(dirent->d_ino)>(index);
+		dirent->d_off = static_cast<decltype(dirent->d_off)>(cookie);
+		dirent->d_reclen = static_cast<decltype(dirent->d_reclen)>(reclen);
+		memcpy(dirent->d_name, name, namelength);
+		m_buffer[m_offset + reclen - 1] = type;
+	}
+
+	m_offset += reclen;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// DirectoryEntryBuffer::getLength
+//
+// Gets the number of bytes written into the buffer
+
+size_t DirectoryEntryBuffer::getLength(void) const
+{
+	return m_offset;
+}
+
+//-----------------------------------------------------------------------------
+// DirectoryEntryBuffer::RecordLength (static)
+//
+// Calculates the length of a single record with the specified name length
+//
+// Arguments:
+//
+//	format		- Format of the directory entry record
+//	namelength	- Length of the entry name, in characters
+
+size_t DirectoryEntryBuffer::RecordLength(VirtualMachine::DirectoryEntryFormat format, size_t namelength)
+{
+	// struct linux_dirent64 -- d_name is followed by a null terminator
+	if(format == VirtualMachine::DirectoryEntryFormat::Dirent64)
+		return align::up(offsetof(uapi_linux_dirent64, d_name) + namelength + 1, alignof(uapi_linux_dirent64));
+
+	// struct linux_dirent -- d_name is followed by a null terminator and d_type
+	return align::up(offsetof(uapi_linux_dirent, d_name) + namelength + 2, alignof(uapi_linux_dirent));
+}
+
+//-----------------------------------------------------------------------------
+// DirectoryEntryBuffer::Rollback
+//
+// Discards all records appended after the specified length
+//
+// Arguments:
+//
+//	length		- Length previously returned by the Length property
+
+void DirectoryEntryBuffer::Rollback(size_t length)
+{
+	_ASSERTE(length <= m_offset);
+	if(length < m_offset) m_offset = length;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
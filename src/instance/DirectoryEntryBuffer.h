@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __DIRECTORYENTRYBUFFER_H_
+#define __DIRECTORYENTRYBUFFER_H_
+#pragma once
+
+#include "VirtualMachine.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// DirectoryEntryBuffer
+//
+// Writes packed and aligned linux_dirent or linux_dirent64 records directly into
+// a caller-provided buffer on behalf of DirectoryHandle::ReadEntries
+
+class DirectoryEntryBuffer
+{
+public:
+
+	// Instance Constructor
+	//
+	DirectoryEntryBuffer(VirtualMachine::DirectoryEntryFormat format, void* buffer, size_t length);
+
+	// Destructor
+	//
+	~DirectoryEntryBuffer()=default;
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Append
+	//
+	// Appends a directory entry record; returns false if the record does not fit
+	bool Append(int64_t index, uapi_mode_t mode, char_t const* name, size_t namelength, int64_t cookie);
+
+	// RecordLength (static)
+	//
+	// Calculates the length of a single record with the specified name length
+	static size_t RecordLength(VirtualMachine::DirectoryEntryFormat format, size_t namelength);
+
+	// Rollback
+	//
+	// Discards all records appended after the specified length
+	void Rollback(size_t length);
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// Length
+	//
+	// Gets the number of bytes written into the buffer
+	__declspec(property(get=getLength)) size_t Length;
+	size_t getLength(void) const;
+
+private:
+
+	DirectoryEntryBuffer(DirectoryEntryBuffer const&)=delete;
+	DirectoryEntryBuffer& operator=(DirectoryEntryBuffer const&)=delete;
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	VirtualMachine::DirectoryEntryFormat const	m_format;		// Record format
+	uint8_t* const								m_buffer;		// Output buffer
+	size_t const								m_length;		// Output buffer length
+	size_t										m_offset;		// Current buffer offset
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __DIRECTORYENTRYBUFFER_H_
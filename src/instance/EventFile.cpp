@@ -0,0 +1,239 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "EventFile.h"
+
+#include "LinuxException.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// EventFile Constructor
+//
+// Arguments:
+//
+//	initval		- Initial value of the event object counter
+//	flags		- EFD_XXXX flags
+
+EventFile::EventFile(uint32_t initval, int flags) : EventFile(std::make_shared<eventfd_t>(), 
+	UAPI_O_RDWR | (flags & (UAPI_EFD_CLOEXEC | UAPI_EFD_NONBLOCK)))
+{
+	if(flags & ~(UAPI_EFD_SEMAPHORE | UAPI_EFD_CLOEXEC | UAPI_EFD_NONBLOCK)) throw LinuxException(UAPI_EINVAL);
+
+	m_eventfd->count = initval;
+	m_eventfd->semaphore = ((flags & UAPI_EFD_SEMAPHORE) == UAPI_EFD_SEMAPHORE);
+}
+
+//-----------------------------------------------------------------------------
+// EventFile Constructor (private)
+//
+// Arguments:
+//
+//	eventfd		- Shared event object
+//	flags		- Handle-level flags
+
+EventFile::EventFile(std::shared_ptr<eventfd_t> const& eventfd, uint32_t flags) : m_eventfd(eventfd), m_flags(flags)
+{
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::Duplicate
+//
+// Duplicates this Handle instance
+//
+// Arguments:
+//
+//	flags		- Handle-level flags for the duplicate
+
+std::unique_ptr<VirtualMachine::Handle> EventFile::Duplicate(uint32_t flags) const
+{
+	return std::unique_ptr<EventFile>(new EventFile(m_eventfd, flags));
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::getFlags
+//
+// Gets the handle-level flags applied to this instance
+
+uint32_t EventFile::getFlags(void) const
+{
+	return m_flags;
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::Poll
+//
+// Gets the set of events (EPOLLIN, EPOLLOUT, ...) currently signaled
+//
+// Arguments:
+//
+//	NONE
+
+uint32_t EventFile::Poll(void) const
+{
+	uint32_t		events = 0;			// Signaled events
+
+	sync::critical_section::scoped_lock lock(m_eventfd->lock);
+
+	if(m_eventfd->count > 0) events |= UAPI_EPOLLIN | UAPI_EPOLLRDNORM;
+	if(m_eventfd->count < MAX_COUNT) events |= UAPI_EPOLLOUT | UAPI_EPOLLWRNORM;
+
+	return events;
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::Read
+//
+// Reads the 8-byte counter value from the event object
+//
+// Arguments:
+//
+//	buffer		- Destination buffer
+//	count		- Size of the destination buffer, in bytes
+
+size_t EventFile::Read(void* buffer, size_t count)
+{
+	uint64_t		value;				// Value read from the counter
+
+	if(buffer == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(count < sizeof(uint64_t)) throw LinuxException(UAPI_EINVAL);
+
+	while(true) {
+
+		// Capture the wait queue generation before checking the counter to avoid a lost wakeup
+		uint32_t generation = m_eventfd->waitqueue.Generation;
+
+		sync::critical_section::scoped_lock lock(m_eventfd->lock);
+
+		if(m_eventfd->count > 0) {
+
+			// EFD_SEMAPHORE reads decrement the counter by one, otherwise the counter is reset
+			value = (m_eventfd->semaphore) ? 1 : m_eventfd->count;
+			m_eventfd->count -= value;
+			lock.unlock();
+
+			// The wait queue must be notified without holding the event object lock
+			m_eventfd->waitqueue.Notify(UAPI_EPOLLOUT | UAPI_EPOLLWRNORM);
+			break;
+		}
+
+		lock.unlock();
+
+		if(m_flags & UAPI_O_NONBLOCK) throw LinuxException(UAPI_EAGAIN);
+		m_eventfd->waitqueue.Wait(generation, INFINITE);
+	}
+
+	*reinterpret_cast<uint64_t*>(buffer) = value;
+	return sizeof(uint64_t);
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::Seek
+//
+// Changes the file position
+//
+// Arguments:
+//
+//	offset		- Offset into the file
+//	whence		- Starting position for the offset
+
+size_t EventFile::Seek(ssize_t offset, int whence)
+{
+	UNREFERENCED_PARAMETER(offset);
+	UNREFERENCED_PARAMETER(whence);
+
+	throw LinuxException(UAPI_ESPIPE);
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::Sync
+//
+// Synchronizes all data associated with the file to storage, not metadata
+//
+// Arguments:
+//
+//	NONE
+
+void EventFile::Sync(void) const
+{
+	throw LinuxException(UAPI_EINVAL);
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::getWaitQueue
+//
+// Gets the wait queue that is notified when the signaled events change
+
+PollQueue* EventFile::getWaitQueue(void) const
+{
+	return &m_eventfd->waitqueue;
+}
+
+//-----------------------------------------------------------------------------
+// EventFile::Write
+//
+// Adds an 8-byte value to the event object counter
+//
+// Arguments:
+//
+//	buffer		- Source buffer
+//	count		- Size of the source buffer, in bytes
+
+size_t EventFile::Write(const void* buffer, size_t count)
+{
+	if(buffer == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(count < sizeof(uint64_t)) throw LinuxException(UAPI_EINVAL);
+
+	uint64_t value = *reinterpret_cast<uint64_t const*>(buffer);
+	if(value == UINT64_MAX) throw LinuxException(UAPI_EINVAL);
+
+	while(true) {
+
+		// Capture the wait queue generation before checking the counter to avoid a lost wakeup
+		uint32_t generation = m_eventfd->waitqueue.Generation;
+
+		sync::critical_section::scoped_lock lock(m_eventfd->lock);
+
+		// The write blocks if the counter would exceed the maximum value
+		if((MAX_COUNT - m_eventfd->count) >= value) {
+
+			m_eventfd->count += value;
+			lock.unlock();
+
+			// The wait queue must be notified without holding the event object lock
+			if(value > 0) m_eventfd->waitqueue.Notify(UAPI_EPOLLIN | UAPI_EPOLLRDNORM);
+			break;
+		}
+
+		lock.unlock();
+
+		if(m_flags & UAPI_O_NONBLOCK) throw LinuxException(UAPI_EAGAIN);
+		m_eventfd->waitqueue.Wait(generation, INFINITE);
+	}
+
+	return sizeof(uint64_t);
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,134 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __EVENTFILE_H_
+#define __EVENTFILE_H_
+#pragma once
+
+#include <memory>
+#include <sync.h>
+
+#include "PollQueue.h"
+#include "VirtualMachine.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// EventFile
+//
+// Implements an eventfd(2) event notification handle
+
+class EventFile : public VirtualMachine::PollableHandle
+{
+public:
+
+	// Instance Constructor
+	//
+	EventFile(uint32_t initval, int flags);
+
+	// Destructor
+	//
+	virtual ~EventFile()=default;
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Duplicate (VirtualMachine::Handle)
+	//
+	// Duplicates this Handle instance
+	virtual std::unique_ptr<VirtualMachine::Handle> Duplicate(uint32_t flags) const override;
+
+	// Poll (VirtualMachine::PollableHandle)
+	//
+	// Gets the set of events (EPOLLIN, EPOLLOUT, ...) currently signaled
+	virtual uint32_t Poll(void) const override;
+
+	// Read (VirtualMachine::Handle)
+	//
+	// Reads the 8-byte counter value from the event object
+	virtual size_t Read(void* buffer, size_t count) override;
+
+	// Seek (VirtualMachine::Handle)
+	//
+	// Changes the file position
+	virtual size_t Seek(ssize_t offset, int whence) override;
+
+	// Sync (VirtualMachine::Handle)
+	//
+	// Synchronizes all data associated with the file to storage, not metadata
+	virtual void Sync(void) const override;
+
+	// Write (VirtualMachine::Handle)
+	//
+	// Adds an 8-byte value to the event object counter
+	virtual size_t Write(const void* buffer, size_t count) override;
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// Flags (VirtualMachine::Handle)
+	//
+	// Gets the handle-level flags applied to this instance
+	virtual uint32_t getFlags(void) const override;
+
+	// WaitQueue (VirtualMachine::PollableHandle)
+	//
+	// Gets the wait queue that is notified when the signaled events change
+	virtual PollQueue* getWaitQueue(void) const override;
+
+private:
+
+	EventFile(EventFile const&)=delete;
+	EventFile& operator=(EventFile const&)=delete;
+
+	// MAX_COUNT
+	//
+	// Maximum value that the event object counter can hold
+	static uint64_t const MAX_COUNT = UINT64_MAX - 1;
+
+	// eventfd_t
+	//
+	// Event object shared among all handles
+	struct eventfd_t
+	{
+		sync::critical_section		lock;			// Synchronization object
+		uint64_t					count;			// Event counter
+		bool						semaphore;		// EFD_SEMAPHORE semantics
+		PollQueue					waitqueue;		// Wait queue
+	};
+
+	// Instance Constructor
+	//
+	EventFile(std::shared_ptr<eventfd_t> const& eventfd, uint32_t flags);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	std::shared_ptr<eventfd_t> const	m_eventfd;		// Shared event object
+	uint32_t const						m_flags;		// Handle-level flags
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __EVENTFILE_H_
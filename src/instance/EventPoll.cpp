@@ -0,0 +1,371 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "EventPoll.h"
+
+#include "LinuxException.h"
+
+#pragma comment(lib, "synchronization.lib")
+
+#pragma warning(push, 4)
+
+// EPOLL_PRIVATE_BITS
+//
+// Flags in the requested events mask that do not represent events
+static uint32_t const EPOLL_PRIVATE_BITS = UAPI_EPOLLWAKEUP | UAPI_EPOLLONESHOT | UAPI_EPOLLET | UAPI_EPOLLEXCLUSIVE;
+
+//-----------------------------------------------------------------------------
+// EventPoll Constructor
+//
+// Arguments:
+//
+//	NONE
+
+EventPoll::EventPoll() : m_readyhead(nullptr), m_readytail(nullptr), m_generation(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll Destructor
+
+EventPoll::~EventPoll()
+{
+	sync::critical_section::scoped_lock ctllock(m_ctllock);
+
+	// Every item needs to be removed from the wait queue it subscribed to
+	for(auto& iterator : m_items) iterator.second->handle->WaitQueue->Unsubscribe(iterator.second.get());
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::Add
+//
+// Registers a handle with the epoll instance (EPOLL_CTL_ADD)
+//
+// Arguments:
+//
+//	fd			- File descriptor associated with the handle
+//	handle		- Handle to be registered
+//	events		- Requested events mask
+//	data		- User data to return with the events
+
+void EventPoll::Add(int fd, VirtualMachine::PollableHandle const* handle, uint32_t events, uint64_t data)
+{
+	if(handle == nullptr) throw LinuxException(UAPI_EBADF);
+
+	sync::critical_section::scoped_lock ctllock(m_ctllock);
+
+	{
+		sync::critical_section::scoped_lock lock(m_lock);
+		if(m_items.find(fd) != m_items.end()) throw LinuxException(UAPI_EEXIST);
+	}
+
+	// The epoll instance holds its own reference to the file via a duplicate handle
+	auto duplicate = std::unique_ptr<VirtualMachine::PollableHandle>(dynamic_cast<VirtualMachine::PollableHandle*>(handle->Duplicate(handle->Flags).release()));
+	if(!duplicate) throw LinuxException(UAPI_EPERM);
+
+	auto item = std::make_unique<item_t>(this, std::move(duplicate), events, data);
+	item_t* added = item.get();
+
+	// Subscribe to the wait queue of the handle and add the item to the collection
+	added->handle->WaitQueue->Subscribe(added);
+
+	{
+		sync::critical_section::scoped_lock lock(m_lock);
+		m_items.emplace(fd, std::move(item));
+	}
+
+	// If the handle is already signaled, the item needs to start on the ready list
+	uint32_t signaled = added->handle->Poll();
+	if(signaled) added->Notify(signaled);
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::Modify
+//
+// Changes the events and data associated with a registered handle (EPOLL_CTL_MOD)
+//
+// Arguments:
+//
+//	fd			- File descriptor associated with the handle
+//	events		- Requested events mask
+//	data		- User data to return with the events
+
+void EventPoll::Modify(int fd, uint32_t events, uint64_t data)
+{
+	item_t*			item;				// Item being modified
+
+	// EPOLLEXCLUSIVE can only be specified when the item is added
+	if(events & UAPI_EPOLLEXCLUSIVE) throw LinuxException(UAPI_EINVAL);
+
+	sync::critical_section::scoped_lock ctllock(m_ctllock);
+
+	{
+		sync::critical_section::scoped_lock lock(m_lock);
+
+		auto found = m_items.find(fd);
+		if(found == m_items.end()) throw LinuxException(UAPI_ENOENT);
+		if(found->second->exclusive) throw LinuxException(UAPI_EINVAL);
+
+		item = found->second.get();
+		item->events = events;
+		item->data = data;
+	}
+
+	// Re-arm the item if the handle is already signaled for the new events
+	uint32_t signaled = item->handle->Poll();
+	if(signaled) item->Notify(signaled);
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::PopReady (private)
+//
+// Removes the item at the head of the ready list; lock must be held
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock (unused, ensures caller has one)
+
+EventPoll::item_t* EventPoll::PopReady(sync::critical_section::scoped_lock& lock)
+{
+	item_t* item = m_readyhead;
+	if(item) RemoveReady(lock, item);
+
+	return item;
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::PushReady (private)
+//
+// Adds an item to the tail of the ready list; lock must be held
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock (unused, ensures caller has one)
+//	item		- Item to be added to the ready list
+
+void EventPoll::PushReady(sync::critical_section::scoped_lock& lock, item_t* item)
+{
+	UNREFERENCED_PARAMETER(lock);		// This is just to ensure the caller has locked
+
+	if(item->ready) return;
+
+	item->readynext = nullptr;
+	item->readyprev = m_readytail;
+
+	if(m_readytail) m_readytail->readynext = item;
+	else m_readyhead = item;
+
+	m_readytail = item;
+	item->ready = true;
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::Remove
+//
+// Removes a handle from the epoll instance (EPOLL_CTL_DEL)
+//
+// Arguments:
+//
+//	fd			- File descriptor associated with the handle
+
+void EventPoll::Remove(int fd)
+{
+	std::unique_ptr<item_t>		item;		// Item being removed
+
+	sync::critical_section::scoped_lock ctllock(m_ctllock);
+
+	{
+		sync::critical_section::scoped_lock lock(m_lock);
+
+		auto found = m_items.find(fd);
+		if(found == m_items.end()) throw LinuxException(UAPI_ENOENT);
+
+		// Take ownership of the item and prevent it from being made ready again
+		item = std::move(found->second);
+		m_items.erase(found);
+
+		item->removed = true;
+		RemoveReady(lock, item.get());
+	}
+
+	// Once unsubscribed there can be no notifications in flight for the item
+	item->handle->WaitQueue->Unsubscribe(item.get());
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::RemoveReady (private)
+//
+// Removes an item from anywhere in the ready list; lock must be held
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock (unused, ensures caller has one)
+//	item		- Item to be removed from the ready list
+
+void EventPoll::RemoveReady(sync::critical_section::scoped_lock& lock, item_t* item)
+{
+	UNREFERENCED_PARAMETER(lock);		// This is just to ensure the caller has locked
+
+	if(!item->ready) return;
+
+	if(item->readyprev) item->readyprev->readynext = item->readynext;
+	else m_readyhead = item->readynext;
+
+	if(item->readynext) item->readynext->readyprev = item->readyprev;
+	else m_readytail = item->readyprev;
+
+	item->readyprev = item->readynext = nullptr;
+	item->ready = false;
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::Wait
+//
+// Waits for registered handles to become ready
+//
+// Arguments:
+//
+//	events		- Array to receive the ready events
+//	maxevents	- Maximum number of events to return
+//	timeout		- Timeout in milliseconds, INFINITE or zero to not wait
+
+int EventPoll::Wait(uapi_epoll_event* events, int maxevents, uint32_t timeout)
+{
+	if(events == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(maxevents <= 0) throw LinuxException(UAPI_EINVAL);
+
+	ULONGLONG start = GetTickCount64();
+
+	while(true) {
+
+		int					result = 0;					// Number of returned events
+		item_t*				relisthead = nullptr;		// Level-triggered items to relist
+		item_t*				relisttail = nullptr;		// Level-triggered items to relist
+
+		// Capture the generation before checking the ready list to avoid a lost wakeup
+		uint32_t generation = m_generation.load();
+
+		sync::critical_section::scoped_lock lock(m_lock);
+
+		while(result < maxevents) {
+
+			item_t* item = PopReady(lock);
+			if(item == nullptr) break;
+
+			// The signaled events may have been consumed since the item was made ready
+			uint32_t signaled = item->handle->Poll() & (item->events | UAPI_EPOLLERR | UAPI_EPOLLHUP);
+			if((item->events & ~EPOLL_PRIVATE_BITS) == 0) signaled = 0;
+			if(signaled == 0) continue;
+
+			events[result].events = signaled;
+			events[result].data = item->data;
+			result++;
+
+			// EPOLLONESHOT disables the item until it has been modified
+			if(item->events & UAPI_EPOLLONESHOT) item->events &= EPOLL_PRIVATE_BITS;
+
+			// Level-triggered items go back on the ready list after this pass
+			else if((item->events & UAPI_EPOLLET) == 0) {
+
+				item->readynext = nullptr;
+				if(relisttail) relisttail->readynext = item;
+				else relisthead = item;
+				relisttail = item;
+			}
+		}
+
+		while(relisthead) {
+
+			item_t* next = relisthead->readynext;
+			PushReady(lock, relisthead);
+			relisthead = next;
+		}
+
+		// If there are still items ready, let another waiter have a crack at them
+		bool wakeanother = (result > 0) && (m_readyhead != nullptr);
+		lock.unlock();
+
+		if(wakeanother) { m_generation.fetch_add(1); WakeByAddressSingle(&m_generation); }
+		if(result > 0) return result;
+
+		// Determine the amount of time remaining on the timeout, if any
+		DWORD remaining = INFINITE;
+		if(timeout != INFINITE) {
+
+			ULONGLONG elapsed = GetTickCount64() - start;
+			if(elapsed >= timeout) return 0;
+			remaining = static_cast<DWORD>(timeout - elapsed);
+		}
+
+		// Wait for the ready list generation to change
+		if(!WaitOnAddress(&m_generation, &generation, sizeof(uint32_t), remaining) && (GetLastError() != ERROR_TIMEOUT)) 
+			throw LinuxException(UAPI_EINTR);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::item_t Constructor
+//
+// Arguments:
+//
+//	owner		- Owning EventPoll instance
+//	handle		- Registered handle
+//	events		- Requested events mask
+//	data		- User data to return with the events
+
+EventPoll::item_t::item_t(EventPoll* owner, std::unique_ptr<VirtualMachine::PollableHandle>&& handle, uint32_t events, uint64_t data) : 
+	owner(owner), handle(std::move(handle)), events(events), data(data), ready(false), removed(false), readyprev(nullptr), readynext(nullptr)
+{
+	exclusive = ((events & UAPI_EPOLLEXCLUSIVE) == UAPI_EPOLLEXCLUSIVE);
+}
+
+//-----------------------------------------------------------------------------
+// EventPoll::item_t::Notify
+//
+// Invoked when the handle has signaled events
+//
+// Arguments:
+//
+//	signaled	- Set of events signaled by the handle
+
+bool EventPoll::item_t::Notify(uint32_t signaled)
+{
+	sync::critical_section::scoped_lock lock(owner->m_lock);
+
+	if(removed) return false;
+	if((signaled & (events | UAPI_EPOLLERR | UAPI_EPOLLHUP)) == 0) return false;
+	if((events & ~EPOLL_PRIVATE_BITS) == 0) return false;
+
+	owner->PushReady(lock, this);
+	lock.unlock();
+
+	// Wake a single waiter, it will wake another if there is more work left
+	owner->m_generation.fetch_add(1);
+	WakeByAddressSingle(&owner->m_generation);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
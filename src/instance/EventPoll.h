@@ -0,0 +1,149 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __EVENTPOLL_H_
+#define __EVENTPOLL_H_
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <sync.h>
+
+#include "PollQueue.h"
+#include "VirtualMachine.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// EventPoll
+//
+// Implements an epoll instance.  Each registered handle subscribes to the wait
+// queue of the underlying file and is placed on the ready list when that file
+// signals events, so the cost of Wait() is proportional to the number of ready
+// items rather than the number of registered items.  Level-triggered items are
+// returned to the ready list after being reported; edge-triggered (EPOLLET) and
+// one-shot (EPOLLONESHOT) items are not
+
+class EventPoll
+{
+public:
+
+	// Instance Constructor
+	//
+	EventPoll();
+
+	// Destructor
+	//
+	~EventPoll();
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Add
+	//
+	// Registers a handle with the epoll instance (EPOLL_CTL_ADD)
+	void Add(int fd, VirtualMachine::PollableHandle const* handle, uint32_t events, uint64_t data);
+
+	// Modify
+	//
+	// Changes the events and data associated with a registered handle (EPOLL_CTL_MOD)
+	void Modify(int fd, uint32_t events, uint64_t data);
+
+	// Remove
+	//
+	// Removes a handle from the epoll instance (EPOLL_CTL_DEL)
+	void Remove(int fd);
+
+	// Wait
+	//
+	// Waits for registered handles to become ready
+	int Wait(uapi_epoll_event* events, int maxevents, uint32_t timeout);
+
+private:
+
+	EventPoll(EventPoll const&)=delete;
+	EventPoll& operator=(EventPoll const&)=delete;
+
+	// item_t
+	//
+	// Registered handle; subscribes to the wait queue of the handle
+	struct item_t : public PollQueue::Entry
+	{
+		// Instance Constructor
+		//
+		item_t(EventPoll* owner, std::unique_ptr<VirtualMachine::PollableHandle>&& handle, uint32_t events, uint64_t data);
+
+		// Notify (PollQueue::Entry)
+		//
+		// Invoked when the handle has signaled events
+		virtual bool Notify(uint32_t signaled) override;
+
+		EventPoll* const									owner;		// Owning instance
+		std::unique_ptr<VirtualMachine::PollableHandle>		handle;		// Registered handle
+		uint32_t											events;		// Requested events
+		uint64_t											data;		// User data
+		bool												ready;		// On the ready list
+		bool												removed;	// Removed from instance
+		item_t*												readyprev;	// Previous ready item
+		item_t*												readynext;	// Next ready item
+	};
+
+	// itemmap_t
+	//
+	// Collection of registered items, keyed by file descriptor
+	using itemmap_t = std::unordered_map<int, std::unique_ptr<item_t>>;
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// PopReady
+	//
+	// Removes the item at the head of the ready list; lock must be held
+	item_t* PopReady(sync::critical_section::scoped_lock& lock);
+
+	// PushReady
+	//
+	// Adds an item to the tail of the ready list; lock must be held
+	void PushReady(sync::critical_section::scoped_lock& lock, item_t* item);
+
+	// RemoveReady
+	//
+	// Removes an item from anywhere in the ready list; lock must be held
+	void RemoveReady(sync::critical_section::scoped_lock& lock, item_t* item);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	sync::critical_section			m_ctllock;		// Serializes Add/Modify/Remove
+	sync::critical_section			m_lock;			// Synchronization object
+	itemmap_t						m_items;		// Registered items
+	item_t*							m_readyhead;	// First ready item
+	item_t*							m_readytail;	// Last ready item
+	std::atomic<uint32_t>			m_generation;	// Ready list generation
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __EVENTPOLL_H_
@@ -0,0 +1,523 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "Futex.h"
+
+#include <algorithm>
+#include <Win32Exception.h>
+
+#include "LinuxException.h"
+
+#pragma comment(lib, "synchronization.lib")
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// Futex Constructor
+//
+// Arguments:
+//
+//	NONE
+
+Futex::Futex() : m_shards(std::make_unique<shard_t[]>(SHARDS))
+{
+	for(size_t index = 0; index < SHARDS; index++) {
+
+		m_shards[index].waiters = 0;
+		m_shards[index].head = m_shards[index].tail = nullptr;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Dequeue (private, static)
+//
+// Removes a waiter from a shard; shard lock must be held
+//
+// Arguments:
+//
+//	shard		- Shard that currently owns the waiter
+//	waiter		- Waiter to be removed
+
+void Futex::Dequeue(shard_t* shard, waiter_t* waiter)
+{
+	if(waiter->prev) waiter->prev->next = waiter->next;
+	else shard->head = waiter->next;
+
+	if(waiter->next) waiter->next->prev = waiter->prev;
+	else shard->tail = waiter->prev;
+
+	waiter->prev = waiter->next = nullptr;
+	shard->waiters.fetch_sub(1);
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Enqueue (private, static)
+//
+// Adds a waiter to a shard; shard lock must be held
+//
+// Arguments:
+//
+//	shard		- Shard to take ownership of the waiter
+//	waiter		- Waiter to be added
+
+void Futex::Enqueue(shard_t* shard, waiter_t* waiter)
+{
+	waiter->shard = shard;
+	waiter->next = nullptr;
+	waiter->prev = shard->tail;
+
+	if(shard->tail) shard->tail->next = waiter;
+	else shard->head = waiter;
+
+	shard->tail = waiter;
+}
+
+//-----------------------------------------------------------------------------
+// Futex::GetShard (private)
+//
+// Gets the shard that a futex key hashes into
+//
+// Arguments:
+//
+//	key			- Futex key
+
+Futex::shard_t* Futex::GetShard(key_t const& key)
+{
+	// Multiplicative (fibonacci) hash of the address space and the address
+	uint64_t hash = (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key.space)) * 0x9E3779B97F4A7C15ui64) ^ 
+		static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key.address) >> 2);
+	hash *= 0x9E3779B97F4A7C15ui64;
+
+	return &m_shards[static_cast<size_t>(hash >> 32) & (SHARDS - 1)];
+}
+
+//-----------------------------------------------------------------------------
+// Futex::LockPI
+//
+// Acquires a priority-inheritance futex on behalf of a thread
+//
+// Arguments:
+//
+//	space		- Address space that contains the futex
+//	address		- Address of the futex word
+//	tid			- Thread identifier of the calling thread
+//	timeout		- Timeout in milliseconds or INFINITE
+
+void Futex::LockPI(void const* space, uint32_t volatile* address, uint32_t tid, uint32_t timeout)
+{
+	if(address == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	key_t key = { space, address };
+	LONG volatile* word = reinterpret_cast<LONG volatile*>(address);
+
+	while(true) {
+
+		// FAST PATH: the futex is not owned; take ownership and preserve the waiters bit
+		uint32_t value = *address;
+		if((value & UAPI_FUTEX_TID_MASK) == 0) {
+
+			if(static_cast<uint32_t>(InterlockedCompareExchange(word, tid | (value & UAPI_FUTEX_WAITERS), value)) == value) return;
+			continue;
+		}
+
+		if((value & UAPI_FUTEX_TID_MASK) == tid) throw LinuxException(UAPI_EDEADLK);
+
+		// SLOW PATH: the futex is owned by another thread, flag it as having waiters and block
+		shard_t* shard = GetShard(key);
+		sync::critical_section::scoped_lock lock(shard->lock);
+
+		value = *address;
+		if((value & UAPI_FUTEX_TID_MASK) == 0) continue;
+		if(((value & UAPI_FUTEX_WAITERS) == 0) && 
+			(static_cast<uint32_t>(InterlockedCompareExchange(word, value | UAPI_FUTEX_WAITERS, value)) != value)) continue;
+
+		waiter_t waiter = {};
+		waiter.key = key;
+		waiter.bitset = UAPI_FUTEX_BITSET_MATCH_ANY;
+		waiter.tid = tid;
+
+		shard->waiters.fetch_add(1);
+		Enqueue(shard, &waiter);
+		lock.unlock();
+
+		// UnlockPI hands ownership of the futex word directly to the woken waiter
+		if(!Sleep(&waiter, timeout)) throw LinuxException(UAPI_ETIMEDOUT);
+		return;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Requeue
+//
+// Wakes waiters on one futex and moves any remaining waiters to another
+//
+// Arguments:
+//
+//	space			- Address space that contains the futexes
+//	address			- Address of the source futex word
+//	wakecount		- Maximum number of waiters to wake
+//	requeuecount	- Maximum number of waiters to requeue
+//	target			- Address of the target futex word
+
+int Futex::Requeue(void const* space, uint32_t volatile* address, int wakecount, int requeuecount, uint32_t volatile* target)
+{
+	if(address == nullptr) throw LinuxException(UAPI_EFAULT);
+	return Requeue(space, address, wakecount, requeuecount, target, *address);
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Requeue
+//
+// Wakes waiters on one futex and moves any remaining waiters to another
+//
+// Arguments:
+//
+//	space			- Address space that contains the futexes
+//	address			- Address of the source futex word
+//	wakecount		- Maximum number of waiters to wake
+//	requeuecount	- Maximum number of waiters to requeue
+//	target			- Address of the target futex word
+//	expected		- Value expected to be contained in the source futex word
+
+int Futex::Requeue(void const* space, uint32_t volatile* address, int wakecount, int requeuecount, uint32_t volatile* target, uint32_t expected)
+{
+	int				result = 0;				// Number of woken and requeued waiters
+
+	if((address == nullptr) || (target == nullptr)) throw LinuxException(UAPI_EFAULT);
+	if((wakecount < 0) || (requeuecount < 0)) throw LinuxException(UAPI_EINVAL);
+
+	key_t source = { space, address };
+	key_t destination = { space, target };
+
+	shard_t* sourceshard = GetShard(source);
+	shard_t* destshard = GetShard(destination);
+
+	// Lock both shards in address order to prevent deadlocks with another requeue
+	shard_t* first = std::min(sourceshard, destshard);
+	shard_t* second = std::max(sourceshard, destshard);
+
+	sync::critical_section::scoped_lock firstlock(first->lock);
+	if(second != first) second->lock.lock();
+
+	try {
+
+		if(*address != expected) throw LinuxException(UAPI_EAGAIN);
+
+		waiter_t* waiter = sourceshard->head;
+		while((waiter != nullptr) && ((wakecount > 0) || (requeuecount > 0))) {
+
+			waiter_t* next = waiter->next;
+
+			if(waiter->key == source) {
+
+				Dequeue(sourceshard, waiter);
+
+				// Wake the first wakecount waiters
+				if(wakecount > 0) {
+
+					wakecount--;
+					waiter->woken = 1;
+					WakeByAddressSingle(&waiter->woken);
+				}
+
+				// Move the next requeuecount waiters over to the destination futex
+				else {
+
+					requeuecount--;
+					waiter->key = destination;
+					destshard->waiters.fetch_add(1);
+					Enqueue(destshard, waiter);
+				}
+
+				result++;
+			}
+
+			waiter = next;
+		}
+	}
+
+	catch(...) { if(second != first) second->lock.unlock(); throw; }
+
+	if(second != first) second->lock.unlock();
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Sleep (private, static)
+//
+// Blocks until the waiter has been woken or the timeout expires; a waiter that
+// was not woken is removed from its shard before this function returns
+//
+// Arguments:
+//
+//	waiter		- Waiter to be blocked
+//	timeout		- Timeout in milliseconds or INFINITE
+
+bool Futex::Sleep(waiter_t* waiter, uint32_t timeout)
+{
+	uint32_t unwoken = 0;				// Comparison value for WaitOnAddress
+	ULONGLONG start = GetTickCount64();
+
+	while(waiter->woken.load() == 0) {
+
+		// Determine the amount of time remaining on the timeout, if any
+		DWORD remaining = INFINITE;
+		if(timeout != INFINITE) {
+
+			ULONGLONG elapsed = GetTickCount64() - start;
+			if(elapsed >= timeout) return !Unwait(waiter);
+			remaining = static_cast<DWORD>(timeout - elapsed);
+		}
+
+		// WaitOnAddress can return spuriously; the woken flag is the source of truth
+		if(!WaitOnAddress(&waiter->woken, &unwoken, sizeof(uint32_t), remaining) && (GetLastError() != ERROR_TIMEOUT)) {
+
+			if(Unwait(waiter)) throw LinuxException(UAPI_EINTR, Win32Exception());
+			return true;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Futex::TryLockPI
+//
+// Attempts to acquire a priority-inheritance futex without waiting
+//
+// Arguments:
+//
+//	space		- Address space that contains the futex
+//	address		- Address of the futex word
+//	tid			- Thread identifier of the calling thread
+
+bool Futex::TryLockPI(void const* space, uint32_t volatile* address, uint32_t tid)
+{
+	UNREFERENCED_PARAMETER(space);
+
+	if(address == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	uint32_t value = *address;
+	if((value & UAPI_FUTEX_TID_MASK) == tid) throw LinuxException(UAPI_EDEADLK);
+	if((value & UAPI_FUTEX_TID_MASK) != 0) return false;
+
+	return (static_cast<uint32_t>(InterlockedCompareExchange(reinterpret_cast<LONG volatile*>(address), 
+		tid | (value & UAPI_FUTEX_WAITERS), value)) == value);
+}
+
+//-----------------------------------------------------------------------------
+// Futex::UnlockPI
+//
+// Releases a priority-inheritance futex, handing it off to a waiter
+//
+// Arguments:
+//
+//	space		- Address space that contains the futex
+//	address		- Address of the futex word
+//	tid			- Thread identifier of the calling thread
+
+void Futex::UnlockPI(void const* space, uint32_t volatile* address, uint32_t tid)
+{
+	if(address == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	key_t key = { space, address };
+	LONG volatile* word = reinterpret_cast<LONG volatile*>(address);
+
+	uint32_t value = *address;
+	if((value & UAPI_FUTEX_TID_MASK) != tid) throw LinuxException(UAPI_EPERM);
+
+	// FAST PATH: there are no waiters; just release the futex word
+	if(((value & UAPI_FUTEX_WAITERS) == 0) && (static_cast<uint32_t>(InterlockedCompareExchange(word, 0, value)) == value)) return;
+
+	shard_t* shard = GetShard(key);
+	sync::critical_section::scoped_lock lock(shard->lock);
+
+	// Locate the first waiter for this futex and determine if there are any more behind it
+	waiter_t* waiter = shard->head;
+	while((waiter != nullptr) && !(waiter->key == key)) waiter = waiter->next;
+
+	if(waiter == nullptr) { InterlockedExchange(word, 0); return; }
+
+	waiter_t* next = waiter->next;
+	while((next != nullptr) && !(next->key == key)) next = next->next;
+
+	// Transfer ownership of the futex word directly to the waiter being woken
+	Dequeue(shard, waiter);
+	InterlockedExchange(word, static_cast<LONG>(waiter->tid | ((next) ? UAPI_FUTEX_WAITERS : 0)));
+
+	waiter->woken = 1;
+	WakeByAddressSingle(&waiter->woken);
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Unwait (private, static)
+//
+// Removes a waiter that timed out; returns false if it was woken instead
+//
+// Arguments:
+//
+//	waiter		- Waiter to be removed from its shard
+
+bool Futex::Unwait(waiter_t* waiter)
+{
+	while(true) {
+
+		// The waiter may have been requeued into a different shard; make sure
+		// that the lock held belongs to the shard that currently owns it
+		shard_t* shard = waiter->shard.load();
+		sync::critical_section::scoped_lock lock(shard->lock);
+		if(waiter->shard.load() != shard) continue;
+
+		if(waiter->woken.load() != 0) return false;
+
+		Dequeue(shard, waiter);
+		return true;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Wait
+//
+// Waits on a futex if it contains the expected value
+//
+// Arguments:
+//
+//	space		- Address space that contains the futex
+//	address		- Address of the futex word
+//	expected	- Value expected to be contained in the futex word
+//	timeout		- Timeout in milliseconds or INFINITE
+
+void Futex::Wait(void const* space, uint32_t volatile* address, uint32_t expected, uint32_t timeout)
+{
+	Wait(space, address, expected, UAPI_FUTEX_BITSET_MATCH_ANY, timeout);
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Wait
+//
+// Waits on a futex if it contains the expected value
+//
+// Arguments:
+//
+//	space		- Address space that contains the futex
+//	address		- Address of the futex word
+//	expected	- Value expected to be contained in the futex word
+//	bitset		- Bitset to match against the bitset provided to Wake
+//	timeout		- Timeout in milliseconds or INFINITE
+
+void Futex::Wait(void const* space, uint32_t volatile* address, uint32_t expected, uint32_t bitset, uint32_t timeout)
+{
+	if(address == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(bitset == 0) throw LinuxException(UAPI_EINVAL);
+
+	// FAST PATH: the value has already changed, there is no need to touch the shard
+	if(*address != expected) throw LinuxException(UAPI_EAGAIN);
+
+	key_t key = { space, address };
+	shard_t* shard = GetShard(key);
+
+	waiter_t waiter = {};
+	waiter.key = key;
+	waiter.bitset = bitset;
+
+	sync::critical_section::scoped_lock lock(shard->lock);
+
+	// The waiter count must be incremented before the value is checked again so that
+	// a concurrent Wake() that changed the value cannot skip this shard
+	shard->waiters.fetch_add(1);
+	if(*address != expected) { shard->waiters.fetch_sub(1); throw LinuxException(UAPI_EAGAIN); }
+
+	Enqueue(shard, &waiter);
+	lock.unlock();
+
+	if(!Sleep(&waiter, timeout)) throw LinuxException(UAPI_ETIMEDOUT);
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Wake
+//
+// Wakes threads waiting on a futex
+//
+// Arguments:
+//
+//	space		- Address space that contains the futex
+//	address		- Address of the futex word
+//	count		- Maximum number of waiters to wake
+
+int Futex::Wake(void const* space, uint32_t volatile* address, int count)
+{
+	return Wake(space, address, count, UAPI_FUTEX_BITSET_MATCH_ANY);
+}
+
+//-----------------------------------------------------------------------------
+// Futex::Wake
+//
+// Wakes threads waiting on a futex
+//
+// Arguments:
+//
+//	space		- Address space that contains the futex
+//	address		- Address of the futex word
+//	count		- Maximum number of waiters to wake
+//	bitset		- Bitset to match against the waiter bitsets
+
+int Futex::Wake(void const* space, uint32_t volatile* address, int count, uint32_t bitset)
+{
+	int				result = 0;				// Number of woken waiters
+
+	if(address == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(bitset == 0) throw LinuxException(UAPI_EINVAL);
+
+	key_t key = { space, address };
+	shard_t* shard = GetShard(key);
+
+	// FAST PATH: if there are no waiters in the shard there is nothing to wake; the
+	// fence orders the caller's change to the futex word before the waiter count check
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(shard->waiters.load() == 0) return 0;
+
+	sync::critical_section::scoped_lock lock(shard->lock);
+
+	waiter_t* waiter = shard->head;
+	while((waiter != nullptr) && (result < count)) {
+
+		// The waiter may be released as soon as it's woken; grab the next one first
+		waiter_t* next = waiter->next;
+
+		if((waiter->key == key) && ((waiter->bitset & bitset) != 0)) {
+
+			Dequeue(shard, waiter);
+			waiter->woken = 1;
+			WakeByAddressSingle(&waiter->woken);
+			result++;
+		}
+
+		waiter = next;
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
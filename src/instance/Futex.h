@@ -0,0 +1,181 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __FUTEX_H_
+#define __FUTEX_H_
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <sync.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// Futex
+//
+// Implements the wait queues behind the futex(2) system call.  Waiters are kept
+// in a sharded hash table keyed by (address space, address) so that unrelated
+// futexes rarely contend on the same lock.  The futex word itself lives in guest
+// memory that has been mapped into the calling process; operations that find no
+// waiters in the shard never acquire the shard lock
+//
+// Priority inheritance (LockPI/UnlockPI) implements the linux ownership protocol
+// for the futex word (owner TID | FUTEX_WAITERS) but does not boost priorities
+
+class Futex
+{
+public:
+
+	// Instance Constructor
+	//
+	Futex();
+
+	// Destructor
+	//
+	~Futex()=default;
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// LockPI
+	//
+	// Acquires a priority-inheritance futex on behalf of a thread
+	void LockPI(void const* space, uint32_t volatile* address, uint32_t tid, uint32_t timeout);
+
+	// Requeue
+	//
+	// Wakes waiters on one futex and moves any remaining waiters to another
+	int Requeue(void const* space, uint32_t volatile* address, int wakecount, int requeuecount, uint32_t volatile* target);
+	int Requeue(void const* space, uint32_t volatile* address, int wakecount, int requeuecount, uint32_t volatile* target, uint32_t expected);
+
+	// TryLockPI
+	//
+	// Attempts to acquire a priority-inheritance futex without waiting
+	bool TryLockPI(void const* space, uint32_t volatile* address, uint32_t tid);
+
+	// UnlockPI
+	//
+	// Releases a priority-inheritance futex, handing it off to a waiter
+	void UnlockPI(void const* space, uint32_t volatile* address, uint32_t tid);
+
+	// Wait
+	//
+	// Waits on a futex if it contains the expected value
+	void Wait(void const* space, uint32_t volatile* address, uint32_t expected, uint32_t timeout);
+	void Wait(void const* space, uint32_t volatile* address, uint32_t expected, uint32_t bitset, uint32_t timeout);
+
+	// Wake
+	//
+	// Wakes threads waiting on a futex
+	int Wake(void const* space, uint32_t volatile* address, int count);
+	int Wake(void const* space, uint32_t volatile* address, int count, uint32_t bitset);
+
+private:
+
+	Futex(Futex const&)=delete;
+	Futex& operator=(Futex const&)=delete;
+
+	// forward declarations
+	//
+	struct shard_t;
+
+	// key_t
+	//
+	// Futex key; the address space and the address of the futex word
+	struct key_t
+	{
+		bool operator==(key_t const& rhs) const { return (space == rhs.space) && (address == rhs.address); }
+
+		void const*					space;			// Address space
+		uint32_t volatile*			address;		// Futex word address
+	};
+
+	// waiter_t
+	//
+	// Represents a single waiting thread; allocated on the stack of the waiter
+	struct waiter_t
+	{
+		key_t						key;			// Futex key
+		uint32_t					bitset;			// Wake bitset
+		uint32_t					tid;			// Thread id (PI futexes)
+		std::atomic<shard_t*>		shard;			// Owning shard
+		std::atomic<uint32_t>		woken;			// Set when waiter is woken
+		waiter_t*					prev;			// Previous waiter in shard
+		waiter_t*					next;			// Next waiter in shard
+	};
+
+	// shard_t
+	//
+	// Single shard of the waiter hash table
+	struct alignas(64) shard_t
+	{
+		sync::critical_section		lock;			// Shard synchronization
+		std::atomic<size_t>			waiters;		// Number of waiters
+		waiter_t*					head;			// First waiter
+		waiter_t*					tail;			// Last waiter
+	};
+
+	// SHARDS
+	//
+	// Number of shards in the waiter hash table (must be a power of two)
+	static size_t const SHARDS = 256;
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// Dequeue (static)
+	//
+	// Removes a waiter from a shard; shard lock must be held
+	static void Dequeue(shard_t* shard, waiter_t* waiter);
+
+	// Enqueue (static)
+	//
+	// Adds a waiter to a shard; shard lock must be held
+	static void Enqueue(shard_t* shard, waiter_t* waiter);
+
+	// GetShard
+	//
+	// Gets the shard that a futex key hashes into
+	shard_t* GetShard(key_t const& key);
+
+	// Sleep (static)
+	//
+	// Blocks until the waiter has been woken or the timeout expires (dequeues on timeout)
+	static bool Sleep(waiter_t* waiter, uint32_t timeout);
+
+	// Unwait
+	//
+	// Removes a waiter that timed out; returns false if it was woken instead
+	static bool Unwait(waiter_t* waiter);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	std::unique_ptr<shard_t[]>		m_shards;		// Waiter hash table
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __FUTEX_H_
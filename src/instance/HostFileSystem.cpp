@@ -28,12 +28,29 @@
 #include <NtApi.h>
 #include <StructuredException.h>
 
+#include "DirectoryEntryBuffer.h"
 #include "LinuxException.h"
 #include "MountOptions.h"
+#include "Tracepoint.h"
 #include "Win32Exception.h"
 
 #pragma warning(push, 4)
 
+//-----------------------------------------------------------------------------
+// Tracepoints
+//
+// Fired on entry to the file handle operations (handle, offset, count); operations
+// against the current file position report an offset of UINT64_MAX
+//-----------------------------------------------------------------------------
+
+static Tracepoint s_hostfsread{ "hostfs:read" };
+static Tracepoint s_hostfsreadasync{ "hostfs:read_async" };
+static Tracepoint s_hostfssetlength{ "hostfs:set_length" };
+static Tracepoint s_hostfssync{ "hostfs:sync" };
+static Tracepoint s_hostfssyncasync{ "hostfs:sync_async" };
+static Tracepoint s_hostfswrite{ "hostfs:write" };
+static Tracepoint s_hostfswriteasync{ "hostfs:write_async" };
+
 // Invariants
 //
 static_assert(FILE_BEGIN == UAPI_SEEK_SET,		"HostFileSystem: FILE_BEGIN must be the same value as UAPI_SEEK_SET");
@@ -63,6 +80,9 @@ static LinuxException MapHostException(DWORD code)
 		case ERROR_INVALID_PARAMETER:	linuxcode = UAPI_EINVAL; break;
 		case ERROR_ALREADY_EXISTS:		linuxcode = UAPI_EEXIST; break;
 		case ERROR_NOT_ENOUGH_MEMORY:	linuxcode = UAPI_ENOMEM; break;
+		case ERROR_NOT_SAME_DEVICE:		linuxcode = UAPI_EXDEV; break;
+		case ERROR_DIR_NOT_EMPTY:		linuxcode = UAPI_ENOTEMPTY; break;
+		case ERROR_OPERATION_ABORTED:	linuxcode = UAPI_ECANCELED; break;
 	}
 
 	// Generate a LinuxException with the mapped code and provide the underlying Win32
@@ -300,6 +320,7 @@ std::unique_ptr<VirtualMachine::Node> HostFileSystem::Directory::CreateDirectory
 	auto path = m_node->path.append(name);
 
 	if(!::CreateDirectory(path, nullptr)) throw MapHostException(GetLastError());
+	mount->Statistics->RecordCreate();
 
 	// Wrap the path to the object into a node_t and return it as a Directory node
 	return std::make_unique<Directory>(std::make_shared<node_t>(m_node->fs, std::move(path)));
@@ -336,6 +357,7 @@ std::unique_ptr<VirtualMachine::Node> HostFileSystem::Directory::CreateFile(Virt
 	if(oshandle == INVALID_HANDLE_VALUE) throw MapHostException(GetLastError());
 
 	CloseHandle(oshandle);					// Always close the handle
+	mount->Statistics->RecordCreate();
 
 	// Wrap the path to the object into a node_t and return it as a File node
 	return std::make_unique<File>(std::make_shared<node_t>(m_node->fs, std::move(path)));
@@ -518,6 +540,8 @@ std::unique_ptr<VirtualMachine::Node> HostFileSystem::Directory::Lookup(VirtualM
 	if(name == nullptr) throw LinuxException(UAPI_EFAULT);
 	auto path = m_node->path.append(name);
 
+	mount->Statistics->RecordLookup();
+
 	// Determine if the object exists and what kind of node needs to be created
 	DWORD attributes = GetFileAttributes(path);
 	if(attributes == INVALID_FILE_ATTRIBUTES) throw LinuxException(UAPI_ENOENT);
@@ -528,6 +552,45 @@ std::unique_ptr<VirtualMachine::Node> HostFileSystem::Directory::Lookup(VirtualM
 	else return std::make_unique<File>(node);
 }
 
+//---------------------------------------------------------------------------
+// HostFileSystem::Directory::Rename
+//
+// Atomically renames a child node of this directory
+//
+// Arguments:
+//
+//	mount		- Mount point on which to perform the operation
+//	oldname		- Name of the child node to be renamed
+//	newdir		- Directory in which the node will be placed
+//	newname		- New name to assign to the child node
+//	flags		- RENAME_NOREPLACE
+
+void HostFileSystem::Directory::Rename(VirtualMachine::Mount const* mount, char_t const* oldname, VirtualMachine::Directory const* newdir, char_t const* newname, uint32_t flags)
+{
+	if(mount == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(mount->FileSystem != m_node->fs.get()) throw LinuxException(UAPI_EXDEV);
+	if((mount->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
+
+	// RENAME_EXCHANGE cannot be performed atomically by the host, only RENAME_NOREPLACE is supported
+	if(flags & ~UAPI_RENAME_NOREPLACE) throw LinuxException(UAPI_EINVAL);
+
+	// The target directory must also be part of this file system
+	if(newdir == nullptr) throw LinuxException(UAPI_EFAULT);
+	Directory const* target = dynamic_cast<Directory const*>(newdir);
+	if((target == nullptr) || (target->m_node->fs != m_node->fs)) throw LinuxException(UAPI_EXDEV);
+
+	// Create the paths to the old and new child nodes based on the directory paths
+	if(oldname == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(newname == nullptr) throw LinuxException(UAPI_EFAULT);
+	auto oldpath = m_node->path.append(oldname);
+	auto newpath = target->m_node->path.append(newname);
+
+	// The host performs the rename as a single operation; without MOVEFILE_COPY_ALLOWED
+	// it will fail rather than degrade into a non-atomic copy and delete
+	DWORD moveflags = ((flags & UAPI_RENAME_NOREPLACE) == UAPI_RENAME_NOREPLACE) ? 0 : MOVEFILE_REPLACE_EXISTING;
+	if(!MoveFileEx(oldpath, newpath, moveflags)) throw MapHostException(GetLastError());
+}
+
 //---------------------------------------------------------------------------
 // HostFileSystem::Directory::SetMode
 //
@@ -649,6 +712,8 @@ void HostFileSystem::Directory::Unlink(VirtualMachine::Mount const* mount, char_
 	// Call RemoveDirectory or DeleteFile as appropriate to unlink the target node
 	result = ((attributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) ? RemoveDirectory(path) : DeleteFile(path);
 	if(!result) throw MapHostException(GetLastError());
+
+	mount->Statistics->RecordUnlink();
 }
 
 //
@@ -665,12 +730,113 @@ void HostFileSystem::Directory::Unlink(VirtualMachine::Mount const* mount, char_
 //	flags		- Handle instance flags
 
 HostFileSystem::DirectoryHandle::DirectoryHandle(std::shared_ptr<directory_handle_t> const& handle, HANDLE oshandle, uint32_t flags) : 
-	Handle(oshandle, flags), m_handle(handle)
+	Handle(oshandle, flags), m_handle(handle), m_cursoroffset(CURSOR_END), m_cursorindex(0), m_cursorvalid(false),
+	m_cursorlock("HostFileSystem::DirectoryHandle::m_cursorlock")
 {
 	_ASSERTE(m_handle);
 	_ASSERTE((m_handle->node->attributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
 }
 
+//-----------------------------------------------------------------------------
+// HostFileSystem::DirectoryHandle::CursorEntry (private)
+//
+// Gets the host directory entry at the cursor, or nullptr at the end
+//
+// Arguments:
+//
+//	lock		- Reference to the held cursor lock
+
+void const* HostFileSystem::DirectoryHandle::CursorEntry(sync::critical_section::scoped_lock& lock) const
+{
+	UNREFERENCED_PARAMETER(lock);
+
+	_ASSERTE(m_cursorvalid);
+	return (m_cursoroffset == CURSOR_END) ? nullptr : &m_cursor[m_cursoroffset];
+}
+
+//-----------------------------------------------------------------------------
+// HostFileSystem::DirectoryHandle::CursorMoveNext (private)
+//
+// Advances the host directory cursor to the next entry
+//
+// Arguments:
+//
+//	lock		- Reference to the held cursor lock
+
+void HostFileSystem::DirectoryHandle::CursorMoveNext(sync::critical_section::scoped_lock& lock)
+{
+	_ASSERTE(m_cursorvalid);
+	if(m_cursoroffset == CURSOR_END) return;
+
+	auto dirinfo = reinterpret_cast<NtApi::PFILE_ID_FULL_DIR_INFORMATION>(&m_cursor[m_cursoroffset]);
+	++m_cursorindex;
+
+	// Move to the next entry in the current buffer or read the next block of entries
+	if(dirinfo->NextEntryOffset) m_cursoroffset += dirinfo->NextEntryOffset;
+	else CursorQuery(lock, false);
+}
+
+//-----------------------------------------------------------------------------
+// HostFileSystem::DirectoryHandle::CursorMoveTo (private)
+//
+// Positions the host directory cursor at the specified entry index
+//
+// Arguments:
+//
+//	lock		- Reference to the held cursor lock
+//	index		- Index of the entry to position the cursor at
+
+void HostFileSystem::DirectoryHandle::CursorMoveTo(sync::critical_section::scoped_lock& lock, size_t index)
+{
+	// The host cursor can only move forward; start over if the requested index is behind it.
+	// Sequential enumeration resumes exactly where the cursor was left and doesn't rescan
+	if((!m_cursorvalid) || (index < m_cursorindex)) {
+
+		m_cursorindex = 0;
+		CursorQuery(lock, true);
+	}
+
+	while((m_cursoroffset != CURSOR_END) && (m_cursorindex < index)) CursorMoveNext(lock);
+}
+
+//-----------------------------------------------------------------------------
+// HostFileSystem::DirectoryHandle::CursorQuery (private)
+//
+// Reads the next block of host directory entries into the cursor buffer
+//
+// Arguments:
+//
+//	lock		- Reference to the held cursor lock
+//	restart		- Flag to restart the enumeration from the first entry
+
+void HostFileSystem::DirectoryHandle::CursorQuery(sync::critical_section::scoped_lock& lock, bool restart)
+{
+	IO_STATUS_BLOCK				iosb;			// I/O operation status block
+
+	UNREFERENCED_PARAMETER(lock);
+
+	//
+	// This is an unfortunate case where using a low-level NTAPI function is required; there is no way
+	// that I can find to reset the pointer set by GetFileInformationByHandleEx(FileIdFullDirectoryInfo),
+	// making it impossible to enumerate the directory more than once without opening a new handle.
+	// Zw/NtQueryDirectoryFile() provides for a BOOLEAN flag that starts over.  Also there seems
+	// to be no valid way to assign the seek pointer, so entries just have to be skipped as necessary.
+	//
+
+	if(!m_cursor) m_cursor = std::make_unique<uint8_t[]>(CURSOR_BUFFER_SIZE);
+
+	// The cursor is invalid until the query completes successfully
+	m_cursorvalid = false;
+	m_cursoroffset = CURSOR_END;
+
+	NTSTATUS result = NtApi::NtQueryDirectoryFile(m_oshandle, nullptr, nullptr, nullptr, &iosb, &m_cursor[0], CURSOR_BUFFER_SIZE, 
+		NtApi::FileIdFullDirectoryInformation, FALSE, nullptr, (restart) ? TRUE : FALSE);
+	if((result != NtApi::STATUS_SUCCESS) && (result != NtApi::STATUS_NO_MORE_FILES)) throw StructuredException(result);
+
+	if(result == NtApi::STATUS_SUCCESS) m_cursoroffset = 0;
+	m_cursorvalid = true;
+}
+
 //-----------------------------------------------------------------------------
 // HostFileSystem::DirectoryHandle::Duplicate
 //
@@ -720,67 +886,81 @@ std::unique_ptr<VirtualMachine::Handle> HostFileSystem::DirectoryHandle::Duplica
 
 void HostFileSystem::DirectoryHandle::Enumerate(std::function<bool(VirtualMachine::DirectoryEntry const&)> func)
 {
-	IO_STATUS_BLOCK				iosb;			// I/O operation status block
-	size_t						index = 0;		// Current enumeration index value
-
 	if(func == nullptr) throw LinuxException(UAPI_EFAULT);
 
-	//
-	// This is an unfortunate case where using a low-level NTAPI function is required; there is no way
-	// that I can find to reset the pointer set by GetFileInformationByHandleEx(FileIdFullDirectoryInfo),
-	// making it impossible to enumerate the directory more than once without opening a new handle.
-	// Zw/NtQueryDirectoryFile() provides for a BOOLEAN flag that starts over.  Also there seems
-	// to be no valid way to assign the seek pointer, so entries just have to be skipped as necessary.
-	//
+	sync::critical_section::scoped_lock cs(m_cursorlock);
 
-	auto buffer = std::make_unique<uint8_t[]>(4 KiB);		// 4KiB buffer
-	size_t pos = m_handle->position;						// Copy the current position
+	// Position the host directory cursor at the current fake file position
+	CursorMoveTo(cs, m_handle->position);
 
-	// ProcessDirectoryEntry (local)
-	//
-	// Processes a single directory entry and invokes the provided callback function
-	auto ProcessDirectoryEntry = [&](NtApi::PFILE_ID_FULL_DIR_INFORMATION dirinfo) -> bool
-	{
-		// Skip entries up to the current fake file position
-		if(pos > index++) return true;
+	while(void const* entry = CursorEntry(cs)) {
+
+		auto dirinfo = reinterpret_cast<NtApi::FILE_ID_FULL_DIR_INFORMATION const*>(entry);
 
 		// Convert the unicode file name into an ANSI file name to pass into the callback
-		std::string filename = std::to_string(dirinfo->FileName, dirinfo->FileNameLength);
+		std::string filename = std::to_string(dirinfo->FileName, static_cast<int>(dirinfo->FileNameLength / sizeof(wchar_t)));
 
 		// Only directory and regular files are currently supported by HostFileSystem
 		uapi_mode_t mode = ((dirinfo->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? UAPI_S_IFDIR : UAPI_S_IFREG) | 0777;
 
-		// Invoke the caller-supplied function with a new VirtualMachine::DirectoryEntry structure
-		return func({ dirinfo->FileId.QuadPart, mode, filename.c_str() });
-	};
+		// The entry is consumed regardless of the result from the callback function
+		bool more = func({ dirinfo->FileId.QuadPart, mode, filename.c_str() });
+		CursorMoveNext(cs);
 
-	// Query the information about the first block of files in the directory
-	NTSTATUS result = NtApi::NtQueryDirectoryFile(m_oshandle, nullptr, nullptr, nullptr, &iosb, &buffer[0], 4 KiB, 
-		NtApi::FileIdFullDirectoryInformation, FALSE, nullptr, TRUE);
-	if((result != NtApi::STATUS_SUCCESS) && (result != NtApi::STATUS_NO_MORE_FILES)) throw StructuredException(result);
+		if(!more) break;
+	}
+
+	// Move the fake seek pointer to the index of the next entry
+	m_handle->position = m_cursorindex;
+}
+
+//---------------------------------------------------------------------------
+// HostFileSystem::DirectoryHandle::ReadEntries
+//
+// Writes directory entry records into a buffer, resuming from the current position
+//
+// Arguments:
+//
+//	format		- Format of the directory entry records to be written
+//	buffer		- Output buffer
+//	length		- Length of the output buffer, in bytes
+
+size_t HostFileSystem::DirectoryHandle::ReadEntries(VirtualMachine::DirectoryEntryFormat format, void* buffer, size_t length)
+{
+	// O_PATH handles cannot be used for this operation
+	if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
+
+	DirectoryEntryBuffer output(format, buffer, length);
+	sync::critical_section::scoped_lock cs(m_cursorlock);
+
+	// Position the host directory cursor at the current fake file position; the cookie
+	// for each entry is the index of the entry that follows it
+	CursorMoveTo(cs, m_handle->position);
 
-	// Keep going until all entries are processed or the callback function breaks out
-	while(result != NtApi::STATUS_NO_MORE_FILES) {
+	while(void const* entry = CursorEntry(cs)) {
 
-		// Process the first entry returned from NtQueryDirectoryFile; break if callback returns false
-		NtApi::PFILE_ID_FULL_DIR_INFORMATION dirinfo = reinterpret_cast<NtApi::PFILE_ID_FULL_DIR_INFORMATION>(&buffer[0]);
-		if(!ProcessDirectoryEntry(dirinfo)) { m_handle->position = std::max(index, pos); return; }
+		auto dirinfo = reinterpret_cast<NtApi::FILE_ID_FULL_DIR_INFORMATION const*>(entry);
 
-		// Process all subsequent entries contained in the current data buffer; break if callback returns false
-		while(dirinfo->NextEntryOffset) {
+		// Convert the unicode file name into an ANSI file name
+		std::string filename = std::to_string(dirinfo->FileName, static_cast<int>(dirinfo->FileNameLength / sizeof(wchar_t)));
 
-			dirinfo = reinterpret_cast<NtApi::PFILE_ID_FULL_DIR_INFORMATION>(reinterpret_cast<uint8_t*>(dirinfo) + dirinfo->NextEntryOffset);
-			if(!ProcessDirectoryEntry(dirinfo)) { m_handle->position = std::max(index, pos); return; }
+		// Only directory and regular files are currently supported by HostFileSystem
+		uapi_mode_t mode = ((dirinfo->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? UAPI_S_IFDIR : UAPI_S_IFREG) | 0777;
+
+		// Stop when the buffer is full; if nothing fit into the buffer it's too small
+		if(!output.Append(dirinfo->FileId.QuadPart, mode, filename.data(), filename.length(), static_cast<int64_t>(m_cursorindex + 1))) {
+
+			if(output.Length == 0) throw LinuxException(UAPI_EINVAL);
+			break;
 		}
 
-		// Query the information about the next block of files in the directory
-		result = NtApi::NtQueryDirectoryFile(m_oshandle, nullptr, nullptr, nullptr, &iosb, &buffer[0], 8192, 
-			NtApi::FileIdFullDirectoryInformation, FALSE, nullptr, FALSE);
-		if((result != NtApi::STATUS_SUCCESS) && (result != NtApi::STATUS_NO_MORE_FILES)) throw StructuredException(result);
+		CursorMoveNext(cs);
 	}
 
-	// Move the fake seek pointer to the higher of the last entry index or original position
-	m_handle->position = std::max(index, pos);
+	// Move the fake seek pointer to the index of the next entry
+	m_handle->position = m_cursorindex;
+
+	return output.Length;
 }
 
 //---------------------------------------------------------------------------
@@ -893,7 +1073,8 @@ std::unique_ptr<VirtualMachine::FileHandle> HostFileSystem::File::CreateFileHand
 	// to the mount specific flags, only file system level flags
 	if((mount->Flags & UAPI_MS_NOATIME) == UAPI_MS_NOATIME) flags |= UAPI_O_NOATIME;
 
-	return std::make_unique<FileHandle>(std::make_shared<file_handle_t>(m_node), OpenHandle(flags), flags);
+	// The handle shares the mount statistics so that it can outlive the mount instance
+	return std::make_unique<FileHandle>(std::make_shared<file_handle_t>(m_node), OpenHandle(flags), flags, static_cast<HostFileSystem::Mount const*>(mount)->m_stats);
 }
 		
 //---------------------------------------------------------------------------
@@ -1101,14 +1282,146 @@ void HostFileSystem::File::Stat(VirtualMachine::Mount const* mount, uapi_stat326
 //	handle		- Shared handle_t instance
 //	handle		- Native object handle
 //	flags		- Handle instance flags
+//	stats		- Statistics for the mount the handle was opened on
 
-HostFileSystem::FileHandle::FileHandle(std::shared_ptr<file_handle_t> const& handle, HANDLE oshandle, uint32_t flags) : 
-	Handle(oshandle, flags), m_handle(handle)
+HostFileSystem::FileHandle::FileHandle(std::shared_ptr<file_handle_t> const& handle, HANDLE oshandle, uint32_t flags, std::shared_ptr<MountStatistics> const& stats) : 
+	Handle(oshandle, flags), m_handle(handle), m_stats(stats), m_asynchandle(INVALID_HANDLE_VALUE), m_asyncio(nullptr),
+	m_asynclock("HostFileSystem::FileHandle::m_asynclock")
 {
 	_ASSERTE(m_handle);
+	_ASSERTE(m_stats);
 	_ASSERTE((m_handle->node->attributes & FILE_ATTRIBUTE_DIRECTORY) == 0);
 }
 
+//-----------------------------------------------------------------------------
+// HostFileSystem::FileHandle Destructor
+
+HostFileSystem::FileHandle::~FileHandle()
+{
+	// Cancel any outstanding overlapped operations and wait for their completion
+	// callbacks to run before the thread pool I/O object is released
+	if(m_asyncio) {
+
+		CancelIoEx(m_asynchandle, nullptr);
+		WaitForThreadpoolIoCallbacks(m_asyncio, FALSE);
+		CloseThreadpoolIo(m_asyncio);
+	}
+
+	if(m_asynchandle != INVALID_HANDLE_VALUE) CloseHandle(m_asynchandle);
+}
+
+//-----------------------------------------------------------------------------
+// HostFileSystem::FileHandle::AsyncIo (private)
+//
+// Gets (creating if necessary) the thread pool I/O object for the handle
+//
+// Arguments:
+//
+//	NONE
+
+PTP_IO HostFileSystem::FileHandle::AsyncIo(void)
+{
+	DWORD		access = 0;											// Access rights for the handle
+	DWORD		attributes = FILE_FLAG_POSIX_SEMANTICS | FILE_FLAG_OVERLAPPED;
+
+	sync::critical_section::scoped_lock cs{ m_asynclock };
+
+	// The overlapped handle and thread pool I/O object are created on first use
+	if(m_asyncio) return m_asyncio;
+
+	switch(m_flags & UAPI_O_ACCMODE) {
+
+		case UAPI_O_RDONLY: access = GENERIC_READ; break;
+		case UAPI_O_WRONLY: access = GENERIC_WRITE; break;
+		case UAPI_O_RDWR: access = GENERIC_READ | GENERIC_WRITE; break;
+
+		default: throw LinuxException(UAPI_EINVAL);
+	}
+
+	// O_DIRECT, O_DSYNC, O_SYNC -- A write-through handle is a reasonable approximation for these
+	if((m_flags & UAPI_O_DIRECT) == UAPI_O_DIRECT) attributes |= FILE_FLAG_WRITE_THROUGH;
+	if((m_flags & UAPI_O_DSYNC) == UAPI_O_DSYNC) attributes |= FILE_FLAG_WRITE_THROUGH;
+	if((m_flags & UAPI_O_SYNC) == UAPI_O_SYNC) attributes |= FILE_FLAG_WRITE_THROUGH;
+
+	// Reopen the native handle for overlapped I/O; the original handle remains synchronous
+	HANDLE oshandle = ReOpenFile(m_oshandle, access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, attributes);
+	if(oshandle == INVALID_HANDLE_VALUE) throw MapHostException(GetLastError());
+
+	// Bind the overlapped handle to the process thread pool
+	PTP_IO io = CreateThreadpoolIo(oshandle, AsyncIoCallback, nullptr, nullptr);
+	if(io == nullptr) { DWORD result = GetLastError(); CloseHandle(oshandle); throw MapHostException(result); }
+
+	m_asynchandle = oshandle;
+	m_asyncio = io;
+
+	return m_asyncio;
+}
+
+//-----------------------------------------------------------------------------
+// HostFileSystem::FileHandle::AsyncIoCallback (private, static)
+//
+// Thread pool completion callback for overlapped I/O operations
+//
+// Arguments:
+//
+//	instance		- Thread pool callback instance
+//	context			- Context pointer provided to CreateThreadpoolIo
+//	overlapped		- Pointer to the OVERLAPPED structure for the operation
+//	result			- Win32 result code for the operation
+//	transferred		- Number of bytes transferred by the operation
+//	io				- Thread pool I/O object
+
+void CALLBACK HostFileSystem::FileHandle::AsyncIoCallback(PTP_CALLBACK_INSTANCE instance, void* context, void* overlapped, ULONG result, ULONG_PTR transferred, PTP_IO io)
+{
+	std::exception_ptr		exception;				// Exception to provide to the completion
+
+	UNREFERENCED_PARAMETER(instance);
+	UNREFERENCED_PARAMETER(context);
+	UNREFERENCED_PARAMETER(io);
+
+	// The OVERLAPPED structure is the first member of the async_io_t context
+	std::unique_ptr<async_io_t> asyncio(reinterpret_cast<async_io_t*>(overlapped));
+	_ASSERTE(asyncio);
+
+	// ERROR_HANDLE_EOF is not an error condition, the operation transferred zero bytes
+	if((result != NO_ERROR) && (result != ERROR_HANDLE_EOF)) exception = std::make_exception_ptr(MapHostException(result));
+
+	asyncio->stats->RecordTransfer(asyncio->direction, static_cast<size_t>(transferred), MountStatistics::Timestamp() - asyncio->start, (exception != nullptr));
+
+	// Exceptions cannot be allowed to propagate back into the thread pool
+	try { asyncio->completion(static_cast<size_t>(transferred), exception); }
+	catch(...) { /* DO NOTHING */ }
+}
+
+//-----------------------------------------------------------------------------
+// HostFileSystem::FileHandle::AsyncSyncCallback (private, static)
+//
+// Thread pool work callback for asynchronous sync operations
+//
+// Arguments:
+//
+//	instance		- Thread pool callback instance
+//	context			- Context pointer provided to TrySubmitThreadpoolCallback
+
+void CALLBACK HostFileSystem::FileHandle::AsyncSyncCallback(PTP_CALLBACK_INSTANCE instance, void* context)
+{
+	std::exception_ptr		exception;				// Exception to provide to the completion
+
+	UNREFERENCED_PARAMETER(instance);
+
+	std::unique_ptr<async_sync_t> asyncsync(reinterpret_cast<async_sync_t*>(context));
+	_ASSERTE(asyncsync);
+
+	if(!FlushFileBuffers(asyncsync->oshandle)) exception = std::make_exception_ptr(MapHostException(GetLastError()));
+	CloseHandle(asyncsync->oshandle);
+
+	asyncsync->stats->RecordSync();
+
+	// Exceptions cannot be allowed to propagate back into the thread pool
+	try { asyncsync->completion(0, exception); }
+	catch(...) { /* DO NOTHING */ }
+}
+
 //-----------------------------------------------------------------------------
 // HostFileSystem::FileHandle::Duplicate
 //
@@ -1158,7 +1471,7 @@ std::unique_ptr<VirtualMachine::Handle> HostFileSystem::FileHandle::Duplicate(ui
 		SetFileTime(oshandle, nullptr, &noatime, nullptr);
 	}
 
-	return std::make_unique<FileHandle>(m_handle, oshandle, flags);
+	return std::make_unique<FileHandle>(m_handle, oshandle, flags, m_stats);
 }
 
 //---------------------------------------------------------------------------
@@ -1173,6 +1486,10 @@ std::unique_ptr<VirtualMachine::Handle> HostFileSystem::FileHandle::Duplicate(ui
 
 size_t HostFileSystem::FileHandle::Read(void* buffer, size_t count)
 {
+	s_hostfsread.Fire(reinterpret_cast<uintptr_t>(this), UINT64_MAX, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Read);
+
 	if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
 
 	// O_PATH handles cannot be used for this operation
@@ -1182,7 +1499,7 @@ size_t HostFileSystem::FileHandle::Read(void* buffer, size_t count)
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	// If no data is being requested there is no reason to bother
-	if(count == 0) return 0;
+	if(count == 0) return transfer.Complete(0);
 
 	// ReadFile() can only read up to MAXDWORD bytes from the underlying file
 	if(count >= MAXDWORD) throw LinuxException(UAPI_EINVAL);
@@ -1191,7 +1508,7 @@ size_t HostFileSystem::FileHandle::Read(void* buffer, size_t count)
 	DWORD read = static_cast<DWORD>(count);
 	if(!ReadFile(m_oshandle, buffer, read, &read, nullptr)) throw MapHostException(GetLastError());
 
-	return static_cast<size_t>(read);
+	return transfer.Complete(static_cast<size_t>(read));
 }
 
 //---------------------------------------------------------------------------
@@ -1207,6 +1524,10 @@ size_t HostFileSystem::FileHandle::Read(void* buffer, size_t count)
 
 size_t HostFileSystem::FileHandle::ReadAt(size_t offset, void* buffer, size_t count)
 {
+	s_hostfsread.Fire(reinterpret_cast<uintptr_t>(this), offset, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Read);
+
 	if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
 
 	// O_PATH handles cannot be used for this operation
@@ -1216,7 +1537,7 @@ size_t HostFileSystem::FileHandle::ReadAt(size_t offset, void* buffer, size_t co
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	// If no data is being requested there is no reason to bother
-	if(count == 0) return 0;
+	if(count == 0) return transfer.Complete(0);
 
 	// ReadFile() can only read up to MAXDWORD bytes from the underlying file
 	if(count >= MAXDWORD) throw LinuxException(UAPI_EINVAL);
@@ -1234,7 +1555,73 @@ size_t HostFileSystem::FileHandle::ReadAt(size_t offset, void* buffer, size_t co
 	DWORD read = static_cast<DWORD>(count);
 	if(!ReadFile(m_oshandle, buffer, read, &read, &overlapped)) throw MapHostException(GetLastError());
 
-	return static_cast<size_t>(read);
+	return transfer.Complete(static_cast<size_t>(read));
+}
+
+//---------------------------------------------------------------------------
+// HostFileSystem::FileHandle::ReadAtAsync
+//
+// Asynchronously reads data from the underlying node into a buffer
+//
+// Arguments:
+//
+//	offset		- Offset within the file to begin reading
+//	buffer		- Destination data buffer
+//	count		- Maximum number of bytes to read into the buffer
+//	completion	- Function to invoke when the operation has completed
+
+void HostFileSystem::FileHandle::ReadAtAsync(size_t offset, void* buffer, size_t count, VirtualMachine::IoCompletion const& completion)
+{
+	s_hostfsreadasync.Fire(reinterpret_cast<uintptr_t>(this), offset, count);
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try {
+
+		if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
+
+		// O_PATH handles cannot be used for this operation
+		if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
+
+		// Ensure that the handle was not opened in write-only mode
+		if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
+
+		// ReadFile() can only read up to MAXDWORD bytes from the underlying file
+		if(count >= MAXDWORD) throw LinuxException(UAPI_EINVAL);
+
+		// If data is being requested, start the overlapped operation against the file
+		if(count > 0) {
+
+			PTP_IO io = AsyncIo();
+
+			// The completion callback takes ownership of the context when the operation is pending
+			std::unique_ptr<async_io_t> asyncio(new async_io_t{ OVERLAPPED{ 0 }, completion, m_stats, MountStatistics::Direction::Read, MountStatistics::Timestamp() });
+			asyncio->overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+#ifdef _M_X64
+			asyncio->overlapped.OffsetHigh = (offset >> 32);
+#else
+			asyncio->overlapped.OffsetHigh = 0;
+#endif
+
+			StartThreadpoolIo(io);
+			if(ReadFile(m_asynchandle, buffer, static_cast<DWORD>(count), nullptr, &asyncio->overlapped) || (GetLastError() == ERROR_IO_PENDING)) {
+
+				asyncio.release();
+				return;
+			}
+
+			// The operation failed immediately; no completion will be queued to the thread pool
+			DWORD result = GetLastError();
+			CancelThreadpoolIo(io);
+
+			if(result != ERROR_HANDLE_EOF) throw MapHostException(result);
+		}
+	}
+
+	catch(...) { return completion(0, std::current_exception()); }
+
+	// Zero-length reads and reads at the end of the file complete immediately
+	completion(0, nullptr);
 }
 
 //---------------------------------------------------------------------------
@@ -1270,6 +1657,8 @@ size_t HostFileSystem::FileHandle::Seek(ssize_t offset, int whence)
 
 size_t HostFileSystem::FileHandle::SetLength(size_t length)
 {
+	s_hostfssetlength.Fire(reinterpret_cast<uintptr_t>(this), 0, length);
+
 	LARGE_INTEGER current, delta;
 	current.QuadPart = delta.QuadPart = 0;
 
@@ -1303,6 +1692,8 @@ size_t HostFileSystem::FileHandle::SetLength(size_t length)
 
 void HostFileSystem::FileHandle::Sync(void) const
 {
+	s_hostfssync.Fire(reinterpret_cast<uintptr_t>(this));
+
 	// O_PATH handles cannot be used for this operation
 	if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
 
@@ -1311,6 +1702,50 @@ void HostFileSystem::FileHandle::Sync(void) const
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	FlushFileBuffers(m_oshandle);
+	m_stats->RecordSync();
+}
+
+//---------------------------------------------------------------------------
+// HostFileSystem::FileHandle::SyncAsync
+//
+// Asynchronously synchronizes all data associated with the file to storage
+//
+// Arguments:
+//
+//	completion	- Function to invoke when the operation has completed
+
+void HostFileSystem::FileHandle::SyncAsync(VirtualMachine::IoCompletion const& completion) const
+{
+	HANDLE				oshandle;				// Duplicated native handle
+
+	s_hostfssyncasync.Fire(reinterpret_cast<uintptr_t>(this));
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try {
+
+		// O_PATH handles cannot be used for this operation
+		if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
+
+		// Ensure that the file system isn't read-only
+		if((m_handle->node->fs->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
+
+		// The work item may outlive this instance, flush against a duplicate of the native handle
+		if(!DuplicateHandle(GetCurrentProcess(), m_oshandle, GetCurrentProcess(), &oshandle, 0, FALSE, DUPLICATE_SAME_ACCESS))
+			throw MapHostException(GetLastError());
+
+		std::unique_ptr<async_sync_t> asyncsync(new async_sync_t{ oshandle, completion, m_stats });
+		if(!TrySubmitThreadpoolCallback(AsyncSyncCallback, asyncsync.get(), nullptr)) {
+
+			DWORD result = GetLastError();
+			CloseHandle(oshandle);
+			throw MapHostException(result);
+		}
+
+		asyncsync.release();
+	}
+
+	catch(...) { completion(0, std::current_exception()); }
 }
 
 //---------------------------------------------------------------------------
@@ -1326,6 +1761,10 @@ void HostFileSystem::FileHandle::Sync(void) const
 
 size_t HostFileSystem::FileHandle::Write(const void* buffer, size_t count)
 {
+	s_hostfswrite.Fire(reinterpret_cast<uintptr_t>(this), UINT64_MAX, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Write);
+
 	if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
 
 	// O_PATH handles cannot be used for this operation
@@ -1336,7 +1775,7 @@ size_t HostFileSystem::FileHandle::Write(const void* buffer, size_t count)
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	// If no data is being written, there is no reason to bother calling WriteFile
-	if(count == 0) return 0;
+	if(count == 0) return transfer.Complete(0);
 
 	// WriteFile() can only write up to MAXDWORD bytes from the underlying file
 	if(count >= MAXDWORD) throw LinuxException(UAPI_EINVAL);
@@ -1348,7 +1787,7 @@ size_t HostFileSystem::FileHandle::Write(const void* buffer, size_t count)
 	DWORD written = static_cast<DWORD>(count);
 	if(!WriteFile(m_oshandle, buffer, written, &written, nullptr)) throw MapHostException(GetLastError());
 
-	return static_cast<size_t>(written);
+	return transfer.Complete(static_cast<size_t>(written));
 }
 
 //---------------------------------------------------------------------------
@@ -1364,6 +1803,10 @@ size_t HostFileSystem::FileHandle::Write(const void* buffer, size_t count)
 
 size_t HostFileSystem::FileHandle::WriteAt(size_t offset, const void* buffer, size_t count)
 {
+	s_hostfswrite.Fire(reinterpret_cast<uintptr_t>(this), offset, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Write);
+
 	if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
 
 	// O_PATH handles cannot be used for this operation
@@ -1374,7 +1817,7 @@ size_t HostFileSystem::FileHandle::WriteAt(size_t offset, const void* buffer, si
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	// If no data is being written, there is no reason to bother calling WriteFile
-	if(count == 0) return 0;
+	if(count == 0) return transfer.Complete(0);
 
 	// WriteFile() can only write up to MAXDWORD bytes from the underlying file
 	if(count >= MAXDWORD) throw LinuxException(UAPI_EINVAL);
@@ -1392,7 +1835,74 @@ size_t HostFileSystem::FileHandle::WriteAt(size_t offset, const void* buffer, si
 	DWORD written = static_cast<DWORD>(count);
 	if(!WriteFile(m_oshandle, buffer, written, &written, &overlapped)) throw MapHostException(GetLastError());
 
-	return static_cast<size_t>(written);
+	return transfer.Complete(static_cast<size_t>(written));
+}
+
+//---------------------------------------------------------------------------
+// HostFileSystem::FileHandle::WriteAtAsync
+//
+// Asynchronously writes data from a buffer to the underlying node
+//
+// Arguments:
+//
+//	offset		- Offset within the file to begin writing
+//	buffer		- Source data buffer
+//	count		- Maximum number of bytes to write from the buffer
+//	completion	- Function to invoke when the operation has completed
+
+void HostFileSystem::FileHandle::WriteAtAsync(size_t offset, const void* buffer, size_t count, VirtualMachine::IoCompletion const& completion)
+{
+	s_hostfswriteasync.Fire(reinterpret_cast<uintptr_t>(this), offset, count);
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try {
+
+		if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
+
+		// O_PATH handles cannot be used for this operation
+		if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
+
+		// Ensure that the file system isn't read-only and the handle isn't read-only
+		if((m_handle->node->fs->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
+		if((m_flags & UAPI_O_ACCMODE) == UAPI_O_RDONLY) throw LinuxException(UAPI_EBADF);
+
+		// WriteFile() can only write up to MAXDWORD bytes from the underlying file
+		if(count >= MAXDWORD) throw LinuxException(UAPI_EINVAL);
+
+		// If data is being written, start the overlapped operation against the file
+		if(count > 0) {
+
+			PTP_IO io = AsyncIo();
+
+			// The completion callback takes ownership of the context when the operation is pending
+			std::unique_ptr<async_io_t> asyncio(new async_io_t{ OVERLAPPED{ 0 }, completion, m_stats, MountStatistics::Direction::Write, MountStatistics::Timestamp() });
+			asyncio->overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+#ifdef _M_X64
+			asyncio->overlapped.OffsetHigh = (offset >> 32);
+#else
+			asyncio->overlapped.OffsetHigh = 0;
+#endif
+
+			StartThreadpoolIo(io);
+			if(WriteFile(m_asynchandle, buffer, static_cast<DWORD>(count), nullptr, &asyncio->overlapped) || (GetLastError() == ERROR_IO_PENDING)) {
+
+				asyncio.release();
+				return;
+			}
+
+			// The operation failed immediately; no completion will be queued to the thread pool
+			DWORD result = GetLastError();
+			CancelThreadpoolIo(io);
+
+			throw MapHostException(result);
+		}
+	}
+
+	catch(...) { return completion(0, std::current_exception()); }
+
+	// Zero-length writes complete immediately
+	completion(0, nullptr);
 }
 
 //
@@ -1510,7 +2020,7 @@ size_t HostFileSystem::Handle<_interface>::Write(const void* buffer, size_t coun
 //	flags		- Mount-specific flags
 
 HostFileSystem::Mount::Mount(std::shared_ptr<HostFileSystem> const& fs, std::unique_ptr<Directory>&& rootdir, uint32_t flags) : 
-	m_fs(fs), m_rootdir(std::move(rootdir)), m_flags(flags)
+	m_fs(fs), m_rootdir(std::move(rootdir)), m_flags(flags), m_stats(std::make_shared<MountStatistics>())
 {
 	_ASSERTE(m_fs);
 	_ASSERTE(m_rootdir);
@@ -1527,7 +2037,8 @@ HostFileSystem::Mount::Mount(std::shared_ptr<HostFileSystem> const& fs, std::uni
 //
 //	rhs		- Existing Mount instance to create a copy of
 
-HostFileSystem::Mount::Mount(Mount const& rhs) : m_fs(rhs.m_fs), m_rootdir(rhs.m_rootdir), m_flags(static_cast<uint32_t>(rhs.m_flags))
+HostFileSystem::Mount::Mount(Mount const& rhs) : m_fs(rhs.m_fs), m_rootdir(rhs.m_rootdir), m_flags(static_cast<uint32_t>(rhs.m_flags)), 
+	m_stats(rhs.m_stats)
 {
 	_ASSERTE(m_fs);
 	_ASSERTE(m_rootdir);
@@ -1582,6 +2093,16 @@ VirtualMachine::Node* HostFileSystem::Mount::getRootNode(void) const
 	return m_rootdir.get();
 }
 
+//---------------------------------------------------------------------------
+// HostFileSystem::Mount::getStatistics
+//
+// Gets a pointer to the mount point operation statistics
+
+MountStatistics* HostFileSystem::Mount::getStatistics(void) const
+{
+	return m_stats.get();
+}
+
 //
 // HOSTFILESYSTEM::NODE IMPLEMENTATION
 //
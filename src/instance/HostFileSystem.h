@@ -25,11 +25,13 @@
 #pragma once
 
 #include <atomic>
+#include <freelist.h>
 #include <memory>
 #include <path.h>
 #include <text.h>
 #include <sync.h>
 
+#include "MountStatistics.h"
 #include "VirtualMachine.h"
 
 #pragma warning(push, 4)
@@ -249,6 +251,16 @@ private:
 		//-------------------------------------------------------------------
 		// Member Functions
 
+		// operator new (static)
+		//
+		// Allocates node instances from the file system free list
+		static void* operator new(size_t size) { return freelist<HostFileSystem>::allocate(size); }
+
+		// operator delete (static)
+		//
+		// Releases node instances back into the file system free list
+		static void operator delete(void* ptr, size_t size) { freelist<HostFileSystem>::release(ptr, size); }
+
 		// SetAccessTime (VirtualMachine::Node)
 		//
 		// Changes the access time of this node
@@ -459,6 +471,11 @@ private:
 		// Looks up a child node of this directory by name
 		virtual std::unique_ptr<VirtualMachine::Node> Lookup(VirtualMachine::Mount const* mount, char_t const* name) override;
 
+		// Rename (VirtualMachine::Directory)
+		//
+		// Atomically renames a child node of this directory
+		virtual void Rename(VirtualMachine::Mount const* mount, char_t const* oldname, VirtualMachine::Directory const* newdir, char_t const* newname, uint32_t flags) override;
+
 		// SetMode (VirtualMachine::Node)
 		//
 		// Changes the mode flags for this node
@@ -527,6 +544,11 @@ private:
 		// Enumerates all of the children of this node
 		virtual void Enumerate(std::function<bool(VirtualMachine::DirectoryEntry const&)> func) override;
 
+		// ReadEntries (VirtualMachine::DirectoryHandle)
+		//
+		// Writes directory entry records into a buffer, resuming from the current position
+		virtual size_t ReadEntries(VirtualMachine::DirectoryEntryFormat format, void* buffer, size_t length) override;
+
 		// Seek (VirtualMachine::Handle)
 		//
 		// Changes the file position
@@ -542,10 +564,49 @@ private:
 		DirectoryHandle(DirectoryHandle const&)=delete;
 		DirectoryHandle& operator=(DirectoryHandle const&)=delete;
 
+		// CURSOR_BUFFER_SIZE
+		//
+		// Size of the buffer used to read host directory entries
+		static const size_t CURSOR_BUFFER_SIZE = 4 KiB;
+
+		// CURSOR_END
+		//
+		// Cursor buffer offset indicating that there are no more entries
+		static const size_t CURSOR_END = SIZE_MAX;
+
+		//-------------------------------------------------------------------
+		// Private Member Functions
+
+		// CursorEntry
+		//
+		// Gets the host directory entry at the cursor, or nullptr at the end
+		void const* CursorEntry(sync::critical_section::scoped_lock& lock) const;
+
+		// CursorMoveNext
+		//
+		// Advances the host directory cursor to the next entry
+		void CursorMoveNext(sync::critical_section::scoped_lock& lock);
+
+		// CursorMoveTo
+		//
+		// Positions the host directory cursor at the specified entry index
+		void CursorMoveTo(sync::critical_section::scoped_lock& lock, size_t index);
+
+		// CursorQuery
+		//
+		// Reads the next block of host directory entries into the cursor buffer
+		void CursorQuery(sync::critical_section::scoped_lock& lock, bool restart);
+
 		//-------------------------------------------------------------------
 		// Protected Member Variables
 
 		std::shared_ptr<directory_handle_t>		m_handle;	// Shared handle_t instance
+
+		std::unique_ptr<uint8_t[]>				m_cursor;		// Host directory cursor buffer
+		size_t									m_cursoroffset;	// Offset of the current entry
+		size_t									m_cursorindex;	// Index of the current entry
+		bool									m_cursorvalid;	// Flag if the cursor is valid
+		sync::critical_section					m_cursorlock;	// Cursor synchronization object
 	};
 
 	// File
@@ -625,11 +686,11 @@ private:
 
 		// Instance Constructor
 		//
-		FileHandle(std::shared_ptr<file_handle_t> const& handle, HANDLE oshandle, uint32_t flags);
+		FileHandle(std::shared_ptr<file_handle_t> const& handle, HANDLE oshandle, uint32_t flags, std::shared_ptr<MountStatistics> const& stats);
 
 		// Destructor
 		//
-		virtual ~FileHandle()=default;
+		virtual ~FileHandle();
 
 		//-------------------------------------------------------------------
 		// Member Functions
@@ -649,6 +710,11 @@ private:
 		// Synchronously reads data from the underlying node into a buffer
 		virtual size_t ReadAt(size_t offset, void* buffer, size_t count) override;
 
+		// ReadAtAsync (VirtualMachine::FileHandle)
+		//
+		// Asynchronously reads data from the underlying node into a buffer
+		virtual void ReadAtAsync(size_t offset, void* buffer, size_t count, VirtualMachine::IoCompletion const& completion) override;
+
 		// Seek (VirtualMachine::Handle)
 		//
 		// Changes the file position
@@ -664,6 +730,11 @@ private:
 		// Synchronizes all data associated with the file to storage, not metadata
 		virtual void Sync(void) const override;
 
+		// SyncAsync (VirtualMachine::Handle)
+		//
+		// Asynchronously synchronizes all data associated with the file to storage
+		virtual void SyncAsync(VirtualMachine::IoCompletion const& completion) const override;
+
 		// Write (VirtualMachine::Handle)
 		//
 		// Synchronously writes data from a buffer to the underlying node
@@ -674,15 +745,64 @@ private:
 		// Synchronously writes data from a buffer to the underlying node
 		virtual size_t WriteAt(size_t offset, const void* buffer, size_t count) override;
 
+		// WriteAtAsync (VirtualMachine::FileHandle)
+		//
+		// Asynchronously writes data from a buffer to the underlying node
+		virtual void WriteAtAsync(size_t offset, const void* buffer, size_t count, VirtualMachine::IoCompletion const& completion) override;
+
 	private:
 
 		FileHandle(FileHandle const&)=delete;
 		FileHandle& operator=(FileHandle const&)=delete;
 
+		// async_io_t
+		//
+		// Context for an outstanding overlapped I/O operation
+		struct async_io_t
+		{
+			OVERLAPPED							overlapped;		// Overlapped I/O structure
+			VirtualMachine::IoCompletion		completion;		// Completion function
+			std::shared_ptr<MountStatistics>	stats;			// Mount statistics
+			MountStatistics::Direction			direction;		// Transfer direction
+			int64_t								start;			// Starting timestamp
+		};
+
+		// async_sync_t
+		//
+		// Context for an outstanding asynchronous sync operation
+		struct async_sync_t
+		{
+			HANDLE								oshandle;		// Duplicated OS handle
+			VirtualMachine::IoCompletion		completion;		// Completion function
+			std::shared_ptr<MountStatistics>	stats;			// Mount statistics
+		};
+
+		//-------------------------------------------------------------------
+		// Private Member Functions
+
+		// AsyncIo
+		//
+		// Gets (creating if necessary) the thread pool I/O object for the handle
+		PTP_IO AsyncIo(void);
+
+		// AsyncIoCallback (static)
+		//
+		// Thread pool completion callback for overlapped I/O operations
+		static void CALLBACK AsyncIoCallback(PTP_CALLBACK_INSTANCE instance, void* context, void* overlapped, ULONG result, ULONG_PTR transferred, PTP_IO io);
+
+		// AsyncSyncCallback (static)
+		//
+		// Thread pool work callback for asynchronous sync operations
+		static void CALLBACK AsyncSyncCallback(PTP_CALLBACK_INSTANCE instance, void* context);
+
 		//-------------------------------------------------------------------
 		// Protected Member Variables
 
-		std::shared_ptr<file_handle_t>	m_handle;	// Shared handle_t instance
+		std::shared_ptr<file_handle_t>		m_handle;		// Shared handle_t instance
+		std::shared_ptr<MountStatistics>	m_stats;		// Mount statistics
+		HANDLE								m_asynchandle;	// Overlapped OS handle
+		PTP_IO								m_asyncio;		// Thread pool I/O object
+		sync::critical_section				m_asynclock;	// Async I/O synchronization object
 	};
 
 	// Mount
@@ -690,6 +810,7 @@ private:
 	// Implements VirtualMachine::Mount
 	class Mount : public VirtualMachine::Mount
 	{
+	friend class File;
 	public:
 
 		// Instance Constructors
@@ -730,6 +851,12 @@ private:
 		__declspec(property(get=getRootNode)) VirtualMachine::Node* RootNode;
 		virtual VirtualMachine::Node* getRootNode(void) const override;
 
+		// Statistics (VirtualMachine::Mount)
+		//
+		// Gets a pointer to the mount point operation statistics
+		__declspec(property(get=getStatistics)) MountStatistics* Statistics;
+		virtual MountStatistics* getStatistics(void) const override;
+
 	private:
 
 		Mount& operator=(Mount const&)=delete;
@@ -740,6 +867,7 @@ private:
 		std::shared_ptr<HostFileSystem>		m_fs;			// File system instance
 		std::shared_ptr<Directory>			m_rootdir;		// Root node instance
 		std::atomic<uint32_t>				m_flags;		// Mount-specific flags
+		std::shared_ptr<MountStatistics>	m_stats;		// Mount statistics
 	};
 };
 
@@ -24,24 +24,32 @@
 #include "InstanceService.h"
 
 #include <algorithm>
+#include <coarseclock.h>
 #include <convert.h>
 #include <iomanip>
 #include <messages.h>
 #include <path.h>
+#include <sync.h>
 
 #include <Exception.h>
+#include <MemoryStreamReader.h>
 #include <RpcObject.h>
 #include <Win32Exception.h>
 
+#include "BootTrace.h"
 #include "CompressedFileReader.h"
 #include "CpioArchive.h"
 #include "Executable.h"
 #include "HostFileSystem.h"
 #include "LinuxException.h"
+#include "MountStatistics.h"
 #include "Process.h"
+#include "SystemCallStatistics.h"
 #include "SystemInformation.h"
 #include "SystemLog.h"
 #include "TempFileSystem.h"
+#include "TimerWheel.h"
+#include "Tracepoint.h"
 
 #pragma warning(push, 4)
 
@@ -79,19 +87,79 @@ InstanceService::InstanceService()
 }
 
 //---------------------------------------------------------------------------
-// InstanceService::ExtractInitialRamFileSystem
+// InstanceService::DecompressInitialRamFileSystem (private)
 //
-// Extracts the contents of a CPIO archive file into a destination directory
+// Decompresses the contents of an initramfs archive file into memory.  This
+// only depends on the archive path and is executed concurrently with the
+// remaining initialization phases; it cannot write to the system log
 //
 // Arguments:
 //
+//	cpioarchive		- Path to the CPIO archive to be decompressed
+
+std::unique_ptr<InstanceService::initramfs_t> InstanceService::DecompressInitialRamFileSystem(std::tstring const& cpioarchive)
+{
+	LARGE_INTEGER						start, end, freq;	// Decompression timing
+
+	BootTrace::Span span(m_boottrace.get(), "boot", "DecompressInitialRamFileSystem");
+	QueryPerformanceCounter(&start);
+
+	auto initramfs = std::make_unique<initramfs_t>();
+	initramfs->path = cpioarchive;
+
+	// The CPIO archive may be compressed via a variety of different mechanisms; wrap in a CompressedStreamReader
+	CompressedFileReader reader(cpioarchive.c_str());
+
+	initramfs->format = "none";
+	switch(reader.Format) {
+
+		case CompressedFileReader::CompressionFormat::BZip2: initramfs->format = "bzip2"; break;
+		case CompressedFileReader::CompressionFormat::GZip: initramfs->format = "gzip"; break;
+		case CompressedFileReader::CompressionFormat::Lz4: initramfs->format = "lz4"; break;
+		case CompressedFileReader::CompressionFormat::Lzma: initramfs->format = "lzma"; break;
+		case CompressedFileReader::CompressionFormat::Xz: initramfs->format = "xz"; break;
+	}
+
+	initramfs->compressed = reader.CompressedLength;
+
+	// Decompress the entire archive into memory; each chunk is traced separately
+	size_t const chunk = SystemInformation::PageSize << 4;
+	while(true) {
+
+		size_t offset = initramfs->data.size();
+		initramfs->data.resize(offset + chunk);
+
+		BootTrace::Span readspan(m_boottrace.get(), "decompress", "Read");
+		size_t read = reader.Read(&initramfs->data[offset], chunk);
+		readspan.End();
+
+		initramfs->data.resize(offset + read);
+		if(read == 0) break;
+	}
+
+	QueryPerformanceCounter(&end);
+	QueryPerformanceFrequency(&freq);
+
+	initramfs->decompressus = static_cast<uint64_t>(((end.QuadPart - start.QuadPart) * 1000000) / freq.QuadPart);
+	return initramfs;
+}
+
+//---------------------------------------------------------------------------
+// InstanceService::ExtractInitialRamFileSystem (private)
+//
+// Extracts the contents of a decompressed CPIO archive into a destination directory
+//
+// Arguments:
+//
+//	ns				- Namespace in which to perform the extraction
 //	destination		- Destination directory Path instance
-//	cpioarchive		- Path to the CPIO archive to be extracted
-//	initramfs		- Path to the initramfs file to be loaded
+//	initramfs		- Decompressed initramfs archive to be extracted
 
-void InstanceService::ExtractInitialRamFileSystem(Namespace const* ns, Namespace::Path const* destination, std::tstring const& cpioarchive)
+void InstanceService::ExtractInitialRamFileSystem(Namespace const* ns, Namespace::Path const* destination, initramfs_t const& initramfs)
 {
 	std::map<uint32_t, std::string>		links;				// Collection of established node links
+	size_t								entries = 0;		// Number of archive entries processed
+	LARGE_INTEGER						start, end, freq;	// Extraction timing
 
 	if(ns == nullptr) throw LinuxException(UAPI_EFAULT);
 	if(destination == nullptr) throw LinuxException(UAPI_EFAULT);
@@ -99,7 +167,7 @@ void InstanceService::ExtractInitialRamFileSystem(Namespace const* ns, Namespace
 	// WriteFileNode (local)
 	//
 	// Writes the contents of a CpioFile data stream into a file system File node instance
-	auto WriteFileNode = [](VirtualMachine::Mount const* mount, VirtualMachine::File* node, CpioFile const& file) -> void 
+	auto WriteFileNode = [&](VirtualMachine::Mount const* mount, VirtualMachine::File* node, CpioFile const& file) -> void 
 	{ 
 		std::vector<uint8_t> buffer(SystemInformation::PageSize << 2);
 
@@ -112,10 +180,14 @@ void InstanceService::ExtractInitialRamFileSystem(Namespace const* ns, Namespace
 		node->SetModificationTime(mount, uapi_timespec{ static_cast<uapi___kernel_time_t>(file.ModificationTime), 0 });
 	};
 
-	LogMessage(VirtualMachine::LogLevel::Informational, TEXT("Extracting initramfs archive "), cpioarchive.c_str());
+	LogMessage(VirtualMachine::LogLevel::Informational, TEXT("Extracting initramfs archive "), initramfs.path.c_str());
+	QueryPerformanceCounter(&start);
 
-	// The CPIO archive may be compressed via a variety of different mechanisms; wrap in a CompressedStreamReader
-	CpioArchive::EnumerateFiles(CompressedFileReader(cpioarchive.c_str()), [&](CpioFile const& file) -> void {
+	// The archive has already been decompressed into memory
+	CpioArchive::EnumerateFiles(MemoryStreamReader(initramfs.data.data(), initramfs.data.size()), [&](CpioFile const& file) -> void {
+
+		BootTrace::Span filespan(m_boottrace.get(), "initramfs", file.Path);
+		++entries;
 
 		// Convert the file path into a posix_path to access the branch and leaf separately
 		posix_path filepath(file.Path);
@@ -200,6 +272,20 @@ void InstanceService::ExtractInitialRamFileSystem(Namespace const* ns, Namespace
 		// Store at least one valid path for every inode number that was created for making hard links
 		links.emplace(file.INode, file.Path);
 	});
+
+	QueryPerformanceCounter(&end);
+	QueryPerformanceFrequency(&freq);
+
+	// Report the archive format, decompression throughput and extraction throughput to allow comparison 
+	// of the compression formats
+	uint64_t decompressus = std::max<uint64_t>(1, initramfs.decompressus);
+	uint64_t extractus = std::max<uint64_t>(1, static_cast<uint64_t>(((end.QuadPart - start.QuadPart) * 1000000) / freq.QuadPart));
+
+	std::stringstream message;
+	message << "initramfs: format=" << initramfs.format << " compressed=" << initramfs.compressed << " uncompressed=" << initramfs.data.size() << 
+		" entries=" << entries << " decompress=" << decompressus << "us (" << (((static_cast<uint64_t>(initramfs.data.size()) * 1000000) / decompressus) / (1 MiB)) << 
+		"MiB/s) extract=" << extractus << "us (" << ((entries * 1000000ui64) / extractus) << " entries/s)";
+	LogMessage(VirtualMachine::LogLevel::Notice, message);
 }
 	
 //---------------------------------------------------------------------------
@@ -218,12 +304,19 @@ void InstanceService::OnStart(int argc, LPTSTR* argv)
 	std::vector<tchar_t const*>			initenv;		// Environment variables passed to init
 	std::vector<tchar_t const*>			invalidargs;	// Invalid parameter arguments
 
+	// The boot trace is always collected; it is only written out if boot_trace= was specified
+	m_boottrace = std::make_unique<BootTrace>();
+
 	try {
 
+		BootTrace::Span bootspan(m_boottrace.get(), "boot", "OnStart");
+
 		//
 		// PROCESS COMMAND LINE ARGUMENTS
 		//
 
+		BootTrace::Span argsspan(m_boottrace.get(), "boot", "ProcessArguments");
+
 		// argv[0] is the service name; start at argv[1]
 		int index = 1;
 
@@ -268,10 +361,24 @@ void InstanceService::OnStart(int argc, LPTSTR* argv)
 		// Any remaining arguments not processed above are passed into init
 		while(index < argc) { initargs.push_back(argv[index++]); }
 
+		argsspan.End();
+
+		//
+		// BEGIN INITRAMFS ARCHIVE DECOMPRESSION
+		//
+
+		// Decompression of the initramfs archive only depends on the archive path; start it now so that it
+		// runs concurrently with the remaining initialization phases.  If initialization fails before the
+		// archive is extracted, the future's destructor waits for the decompression to finish
+		std::future<std::unique_ptr<initramfs_t>> initramfs;
+		if(param_initrd) initramfs = std::async(std::launch::async, &InstanceService::DecompressInitialRamFileSystem, this, std::tstring(param_initrd));
+
 		//
 		// INITIALIZE SYSTEM LOG
 		//
 
+		BootTrace::Span syslogspan(m_boottrace.get(), "boot", "CreateSystemLog");
+
 		// Create the system log instance, enforce a minimum size of 128KiB
 		param_log_buf_len = std::max<size_t>(128 KiB, param_log_buf_len);
 		try { m_syslog = std::make_unique<SystemLog>(param_log_buf_len, param_loglevel); }
@@ -280,13 +387,42 @@ void InstanceService::OnStart(int argc, LPTSTR* argv)
 		// Dump the arguments that couldn't be parsed as warnings into the system log
 		for(auto p : invalidargs) LogMessage(VirtualMachine::LogLevel::Warning, TEXT("Failed to parse parameter: "), p);
 
+		// Enable the requested static tracepoints; they are enabled after the system log has been
+		// created so that the syslog:write tracepoint captures the complete log
+		if(param_trace_event) {
+
+			std::string events = std::to_string(param_trace_event);
+			if(Tracepoint::Enable(events.c_str(), true) == 0) 
+				LogMessage(VirtualMachine::LogLevel::Warning, TEXT("No tracepoints matched trace_event: "), events.c_str());
+		}
+
+		syslogspan.End();
+
 		//
 		// INITIALIZE JOB OBJECT
 		//
 
+		BootTrace::Span jobspan(m_boottrace.get(), "boot", "CreateJobObject");
+
 		m_job = CreateJobObject(nullptr, nullptr);
 		if(m_job == nullptr) throw CreateJobObjectException(GetLastError(), Win32Exception(GetLastError()));
 
+		jobspan.End();
+
+		//
+		// INITIALIZE TIMER WHEEL
+		//
+
+		BootTrace::Span timerspan(m_boottrace.get(), "boot", "CreateTimers");
+
+		// The timer wheel services nanosleep, timerfd and interval timers for the instance
+		m_timers = std::make_unique<TimerWheel>();
+
+		// The coarse clock provides the timestamps for file system operations
+		m_coarseclock = std::make_unique<coarseclock>(timespan::milliseconds(static_cast<uint32_t>(std::max<size_t>(1, param_coarseclock_ms))));
+
+		timerspan.End();
+
 		//
 		// INITIALIZE FILE SYSTEM TYPES
 		//
@@ -299,15 +435,21 @@ void InstanceService::OnStart(int argc, LPTSTR* argv)
 		// REGISTER SYSTEM CALL INTERFACES
 		//
 
+		BootTrace::Span rpcspan(m_boottrace.get(), "boot", "RegisterSystemCalls");
+
 		m_syscalls_x86 = std::make_unique<RpcObject>(syscalls_x86_v1_0_s_ifspec, RPC_IF_AUTOLISTEN | RPC_IF_ALLOW_SECURE_ONLY);
 #ifdef _M_X64
 		m_syscalls_x64 = std::make_unique<RpcObject>(syscalls_x64_v1_0_s_ifspec, RPC_IF_AUTOLISTEN | RPC_IF_ALLOW_SECURE_ONLY);
 #endif
 
+		rpcspan.End();
+
 		//
 		// CREATE AND MOUNT ROOT FILE SYSTEM
 		//
 
+		BootTrace::Span rootmountspan(m_boottrace.get(), "boot", "MountRootFileSystem");
+
 		std::unique_ptr<VirtualMachine::Mount> rootmount;
 
 		try {
@@ -330,33 +472,64 @@ void InstanceService::OnStart(int argc, LPTSTR* argv)
 
 		catch(std::exception& ex) { throw MountRootFileSystemException(ex.what()); }
 
+		rootmountspan.End();
+
 		//
 		// INITIALIZE ROOT NAMESPACE
 		//
 
+		BootTrace::Span namespacespan(m_boottrace.get(), "boot", "CreateRootNamespace");
+
 		try { m_rootns = std::make_unique<Namespace>(std::move(rootmount)); }
 		catch(std::exception& ex) { throw CreateRootNamespaceException(ex.what()); }
 
 		// Get a pointer to the namespace root path for lookups
 		auto rootpath = m_rootns->GetRootPath();
 
+		namespacespan.End();
+
 		//
 		// EXTRACT INITRAMFS ARCHIVE INTO ROOT FILE SYSTEM
 		//
 
 		if(param_initrd) {
 
+			BootTrace::Span initrdspan(m_boottrace.get(), "boot", "ExtractInitialRamFileSystem");
+
 			std::tstring initrd = param_initrd;				// Pull out the param_initrd string
 
-			// Attempt to extract the contents of the initramfs archive into the root file system
-			try { ExtractInitialRamFileSystem(m_rootns.get(), rootpath.get(), initrd); }
+			// Wait for the decompression to complete and extract the contents of the archive into the root file system;
+			// exceptions thrown during decompression are rethrown by the future
+			try { ExtractInitialRamFileSystem(m_rootns.get(), rootpath.get(), *initramfs.get()); }
 			catch(std::exception& ex) { throw InitialRamFileSystemException(initrd.c_str(), ex.what()); }
+
+			// Seal the requested directory subtrees now that they have been populated; a directory that
+			// cannot be sealed only loses the faster lookups so this is not treated as a boot failure
+			if(param_initrd_seal) {
+
+				BootTrace::Span sealspan(m_boottrace.get(), "boot", "SealInitialRamFileSystem");
+
+				for(auto const& sealpath : std::split<std::string>(std::to_string(param_initrd_seal), ',')) {
+
+					try {
+
+						auto path = m_rootns->LookupPath(rootpath.get(), sealpath.c_str(), 0);
+						size_t sealed = SealTempFileSystem(path->Mount, path->Node);
+
+						LogMessage(VirtualMachine::LogLevel::Informational, "Sealed initramfs directory ", sealpath.c_str(), " (", sealed, " directories)");
+					}
+
+					catch(std::exception& ex) { LogMessage(VirtualMachine::LogLevel::Warning, "Failed to seal initramfs directory ", sealpath.c_str(), ": ", ex.what()); }
+				}
+			}
 		}
 
 		//
 		// LAUNCH INIT PROCESS
 		//
 
+		BootTrace::Span initspan(m_boottrace.get(), "boot", "LaunchInit");
+
 		// The path to the init executable is always simply "init" when an initramfs archive has been used
 		std::string initpath = (param_initrd) ? "init" : std::to_string(param_init);
 
@@ -367,10 +540,19 @@ void InstanceService::OnStart(int argc, LPTSTR* argv)
 		}
 
 		catch(std::exception& ex) { throw LaunchInitException(initpath.c_str(), ex.what()); }
+
+		initspan.End();
+		bootspan.End();
+
+		WriteBootTrace();
 	}
 
 	catch(std::exception& ex) {
 
+		// Write out the partial boot trace; the spans that were interrupted by the exception
+		// have been recorded as they were unwound
+		WriteBootTrace();
+
 		PanicDuringInitializationException panic(ex.what());
 		LogMessage(VirtualMachine::LogLevel::Emergency, panic.what());
 
@@ -398,6 +580,117 @@ void InstanceService::OnStop(void)
 	m_syscalls_x64.reset();
 #endif
 	m_syscalls_x86.reset();
+
+	// Stop the timer wheel service thread and the coarse clock
+	m_timers.reset();
+	m_coarseclock.reset();
+
+	// ExportStatistics (local)
+	//
+	// Writes the collected system call statistics for an interface into the system log
+	auto ExportStatistics = [&](char_t const* arch, SystemCallStatistics const& stats) -> void {
+
+		stats.Enumerate([&](size_t number, SystemCallStatistics::Snapshot const& snapshot) -> void {
+
+			std::stringstream message;
+			message << arch << " " << number << " " << ((snapshot.name) ? snapshot.name : "?") << ": calls=" << snapshot.calls << 
+				" errors=" << snapshot.errors << " avg=" << (snapshot.totalns / snapshot.calls) << "ns p50=" << 
+				SystemCallStatistics::Percentile(snapshot, 50.0) << "ns p99=" << SystemCallStatistics::Percentile(snapshot, 99.0) << 
+				"ns max=" << snapshot.maxns << "ns";
+			LogMessage(VirtualMachine::LogLevel::Notice, message);
+		});
+	};
+
+	// Export the system call statistics collected during the lifetime of the instance
+#ifdef _M_X64
+	ExportStatistics("x64", SystemCallStatistics::X64);
+#endif
+	ExportStatistics("x86", SystemCallStatistics::X86);
+
+	// Export the path name lookup statistics collected for the root namespace
+	if(m_rootns) {
+
+		auto lookups = m_rootns->Statistics;
+
+		std::stringstream message;
+		message << "namespace lookups=" << lookups.lookups << " failures=" << lookups.failures << " negative=" << lookups.negative << 
+			" components=" << lookups.components << " symlinks=" << lookups.symlinks << " mounts=" << lookups.mounts << " avg=" << 
+			((lookups.lookups) ? lookups.totalns / lookups.lookups : 0) << "ns max=" << lookups.maxns << "ns";
+		LogMessage(VirtualMachine::LogLevel::Notice, message);
+	}
+
+	// Export the operation statistics collected for each mount point in the root namespace
+	if(m_rootns) {
+
+		m_rootns->EnumerateMounts([&](std::string const& path, VirtualMachine::Mount const* mount) -> void {
+
+			auto stats = mount->Statistics->Aggregate();
+
+			std::stringstream message;
+			message << "mount " << path << ": lookups=" << stats.lookups << " creates=" << stats.creates << " unlinks=" << stats.unlinks << 
+				" syncs=" << stats.syncs << " reads=" << stats.reads.operations << " read=" << stats.reads.bytes << "B read_p50=" << 
+				MountStatistics::Percentile(stats.reads, 50.0) << "ns read_p99=" << MountStatistics::Percentile(stats.reads, 99.0) << 
+				"ns writes=" << stats.writes.operations << " written=" << stats.writes.bytes << "B write_p50=" << 
+				MountStatistics::Percentile(stats.writes, 50.0) << "ns write_p99=" << MountStatistics::Percentile(stats.writes, 99.0) << "ns";
+			LogMessage(VirtualMachine::LogLevel::Notice, message);
+		});
+	}
+
+	// Drain the events collected by any enabled tracepoints out to the specified file
+	if(param_trace_file) {
+
+		std::tstring path = param_trace_file;
+
+		try {
+
+			std::stringstream message;
+			message << "tracepoints: " << Tracepoint::Drain(path.c_str()) << " events written";
+			LogMessage(VirtualMachine::LogLevel::Notice, message);
+		}
+
+		catch(std::exception& ex) { LogMessage(VirtualMachine::LogLevel::Warning, TEXT("Failed to write tracepoint events: "), ex.what()); }
+	}
+
+#ifdef SYNC_LOCK_PROFILING
+	// Export the lock contention statistics collected during the lifetime of the instance
+	sync::lock_profile::enumerate([&](sync::lock_profile::snapshot_t const& snapshot) -> void {
+
+		std::stringstream message;
+		message << "lock " << snapshot.name << ": acquisitions=" << snapshot.acquisitions << " contended=" << snapshot.contentions << 
+			" wait=" << snapshot.waitns << "ns maxhold=" << snapshot.maxholdns << "ns";
+
+		// Each non-empty wait time histogram bucket is reported by its upper bound
+		for(size_t index = 0; index < sync::lock_profile::HISTOGRAM_BUCKETS; index++)
+			if(snapshot.histogram[index]) message << " <" << (1ui64 << index) << "ns=" << snapshot.histogram[index];
+
+		LogMessage(VirtualMachine::LogLevel::Notice, message);
+	});
+#endif
+}
+
+//---------------------------------------------------------------------------
+// InstanceService::WriteBootTrace (private)
+//
+// Writes and releases the boot timeline trace
+//
+// Arguments:
+//
+//	NONE
+
+void InstanceService::WriteBootTrace(void)
+{
+	if(!m_boottrace) return;
+
+	// Write the collected spans out to the specified file as Chrome trace-event JSON
+	if(param_boot_trace) {
+
+		std::tstring path = param_boot_trace;
+
+		try { m_boottrace->Write(path.c_str()); }
+		catch(std::exception& ex) { LogMessage(VirtualMachine::LogLevel::Warning, TEXT("Failed to write boot trace: "), ex.what()); }
+	}
+
+	m_boottrace.reset();
 }
 
 //---------------------------------------------------------------------------
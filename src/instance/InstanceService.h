@@ -24,6 +24,7 @@
 #define __INSTANCESERVICE_H_
 #pragma once
 
+#include <future>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -37,9 +38,12 @@
 
 // FORWARD DECLARATIONS
 //
+class BootTrace;
 class Process;
 class RpcObject;
 class SystemLog;
+class TimerWheel;
+class coarseclock;
 
 // PARAMETER_MAP
 //
@@ -92,8 +96,11 @@ private:
 	// Parameter Map
 	//
 	BEGIN_PARAMETER_MAP(m_params)
+		PARAMETER_ENTRY(TEXT("boot_trace"), param_boot_trace)
+		PARAMETER_ENTRY(TEXT("coarseclock_ms"), param_coarseclock_ms)
 		PARAMETER_ENTRY(TEXT("init"), param_init)
 		PARAMETER_ENTRY(TEXT("initrd"), param_initrd)
+		PARAMETER_ENTRY(TEXT("initrd_seal"), param_initrd_seal)
 		PARAMETER_ENTRY(TEXT("log_buf_len"), param_log_buf_len)
 		PARAMETER_ENTRY(TEXT("loglevel"), param_loglevel)
 		PARAMETER_ENTRY(TEXT("ro"), param_ro)
@@ -101,6 +108,8 @@ private:
 		PARAMETER_ENTRY(TEXT("rootflags"), param_rootflags)
 		PARAMETER_ENTRY(TEXT("rootfstype"), param_rootfstype)
 		PARAMETER_ENTRY(TEXT("rw"), param_rw)
+		PARAMETER_ENTRY(TEXT("trace_event"), param_trace_event)
+		PARAMETER_ENTRY(TEXT("trace_file"), param_trace_file)
 	END_PARAMETER_MAP()
 
 	// filesystemtype_map_t
@@ -108,6 +117,18 @@ private:
 	// Collection of available file systems (name, create function)
 	using filesystemtype_map_t = std::unordered_map<std::tstring, VirtualMachine::MountFileSystem>;
 
+	// initramfs_t
+	//
+	// Decompressed initramfs archive
+	struct initramfs_t
+	{
+		std::tstring			path;			// Path to the archive file
+		char const*				format;			// Archive compression format
+		size_t					compressed;		// Length of the compressed archive
+		uint64_t				decompressus;	// Decompression time (microseconds)
+		std::vector<uint8_t>	data;			// Decompressed archive data
+	};
+
 	// ProcFileSystem
 	//
 	// Implements the procfs file system
@@ -137,10 +158,15 @@ private:
 	//-------------------------------------------------------------------------
 	// Private Member Functions
 
+	// DecompressInitialRamFileSystem
+	//
+	// Decompresses the contents of an initramfs archive file into memory
+	std::unique_ptr<initramfs_t> DecompressInitialRamFileSystem(std::tstring const& cpioarchive);
+
 	// ExtractInitialRamFileSystem
 	//
-	// Extracts the contents of an initramfs archive file into a destination directory
-	void ExtractInitialRamFileSystem(Namespace const* ns, Namespace::Path const* destination, std::tstring const& cpioarchive);
+	// Extracts the contents of a decompressed initramfs archive into a destination directory
+	void ExtractInitialRamFileSystem(Namespace const* ns, Namespace::Path const* destination, initramfs_t const& initramfs);
 	
 	// OnStart (Service)
 	//
@@ -152,6 +178,11 @@ private:
 	// Invoked when the service is stopped
 	void OnStop(void);
 
+	// WriteBootTrace
+	//
+	// Writes and releases the boot timeline trace
+	void WriteBootTrace(void);
+
 	//-------------------------------------------------------------------------
 	// Member Variables
 
@@ -159,6 +190,9 @@ private:
 	std::unique_ptr<Namespace>		m_rootns;			// Root Namespace instance
 	HANDLE							m_job;				// Process job object
 	std::unique_ptr<Process>		m_initprocess;		// Init process instance
+	std::unique_ptr<TimerWheel>		m_timers;			// Instance timer wheel
+	std::unique_ptr<coarseclock>	m_coarseclock;		// Coarse date/time clock
+	std::unique_ptr<BootTrace>		m_boottrace;		// Boot timeline trace
 	
 	// File System
 	//
@@ -173,8 +207,11 @@ private:
 
 	// Parameters
 	//
+	Parameter<std::tstring>				param_boot_trace;
+	Parameter<size_t>					param_coarseclock_ms	= 4;
 	Parameter<std::tstring>				param_init			= TEXT("/sbin/init");
 	Parameter<std::tstring>				param_initrd;
+	Parameter<std::tstring>				param_initrd_seal;
 	Parameter<size_t>					param_log_buf_len	= 2 MiB;
 	Parameter<VirtualMachine::LogLevel>	param_loglevel		= VirtualMachine::LogLevel::Warning;
 	Parameter<void>						param_ro;
@@ -182,6 +219,8 @@ private:
 	Parameter<std::tstring>				param_rootflags;
 	Parameter<std::tstring>				param_rootfstype	= TEXT("tmpfs");
 	Parameter<void>						param_rw;
+	Parameter<std::tstring>				param_trace_event;
+	Parameter<std::tstring>				param_trace_file;
 };
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,316 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "MountStatistics.h"
+
+#include <algorithm>
+#include <Win32Exception.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// GetTimestampFrequency (local)
+//
+// Gets the number of nanoseconds represented by a single performance counter tick
+//
+// Arguments:
+//
+//	NONE
+
+static double GetTimestampFrequency(void)
+{
+	LARGE_INTEGER				qpcfreq;		// QueryPerformanceCounter frequency
+
+	if(!QueryPerformanceFrequency(&qpcfreq)) throw Win32Exception{ GetLastError() };
+	return 1000000000.0 / static_cast<double>(qpcfreq.QuadPart);
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics Constructor
+//
+// Arguments:
+//
+//	NONE
+
+MountStatistics::MountStatistics() : m_tsfreq(GetTimestampFrequency())
+{
+	// Allocate and zero-initialize a statistics block for every active processor
+	DWORD processors = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+	for(DWORD index = 0; index < processors; index++) m_processors.push_back(std::make_unique<processor_t>());
+
+	Reset();
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::Aggregate
+//
+// Aggregates the per-processor statistics into a snapshot
+//
+// Arguments:
+//
+//	NONE
+
+MountStatistics::Snapshot MountStatistics::Aggregate(void) const
+{
+	Snapshot snapshot = {};
+
+	// Aggregates the statistics for a single transfer direction
+	auto AggregateTransfer = [](TransferSnapshot& aggregate, transfer_t const& transfer) -> void {
+
+		aggregate.operations += transfer.operations.load(std::memory_order_relaxed);
+		aggregate.errors += transfer.errors.load(std::memory_order_relaxed);
+		aggregate.bytes += transfer.bytes.load(std::memory_order_relaxed);
+		aggregate.totalns += transfer.totalns.load(std::memory_order_relaxed);
+		aggregate.maxns = std::max(aggregate.maxns, transfer.maxns.load(std::memory_order_relaxed));
+
+		for(size_t index = 0; index < HistogramBuckets; index++)
+			aggregate.histogram[index] += transfer.histogram[index].load(std::memory_order_relaxed);
+	};
+
+	for(auto const& processor : m_processors) {
+
+		snapshot.lookups += processor->lookups.load(std::memory_order_relaxed);
+		snapshot.creates += processor->creates.load(std::memory_order_relaxed);
+		snapshot.unlinks += processor->unlinks.load(std::memory_order_relaxed);
+		snapshot.syncs += processor->syncs.load(std::memory_order_relaxed);
+
+		AggregateTransfer(snapshot.reads, processor->transfers[static_cast<size_t>(Direction::Read)]);
+		AggregateTransfer(snapshot.writes, processor->transfers[static_cast<size_t>(Direction::Write)]);
+	}
+
+	return snapshot;
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::GetProcessor (private)
+//
+// Gets the statistics for the current processor
+//
+// Arguments:
+//
+//	NONE
+
+MountStatistics::processor_t* MountStatistics::GetProcessor(void) const
+{
+	// The thread may migrate to another processor after this, which is harmless
+	// since all of the counters are atomic
+	return m_processors[GetCurrentProcessorNumber() % m_processors.size()].get();
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::Percentile (static)
+//
+// Calculates an approximate latency percentile (ns) from a snapshot histogram
+//
+// Arguments:
+//
+//	snapshot	- Aggregated transfer statistics
+//	percentile	- Percentile to calculate (0.0 - 100.0)
+
+uint64_t MountStatistics::Percentile(TransferSnapshot const& snapshot, double percentile)
+{
+	if(snapshot.operations == 0) return 0;
+
+	// Determine how many samples need to be at or below the returned value
+	uint64_t threshold = static_cast<uint64_t>((std::min(std::max(percentile, 0.0), 100.0) / 100.0) * snapshot.operations);
+	uint64_t accumulated = 0;
+
+	for(size_t index = 0; index < HistogramBuckets; index++) {
+
+		accumulated += snapshot.histogram[index];
+		if((accumulated > 0) && (accumulated >= threshold)) return SystemCallStatistics::BucketLowerBound(index);
+	}
+
+	return snapshot.maxns;
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::RecordCreate
+//
+// Records the creation of a node
+//
+// Arguments:
+//
+//	NONE
+
+void MountStatistics::RecordCreate(void)
+{
+	GetProcessor()->creates.fetch_add(1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::RecordLookup
+//
+// Records a node lookup operation
+//
+// Arguments:
+//
+//	NONE
+
+void MountStatistics::RecordLookup(void)
+{
+	GetProcessor()->lookups.fetch_add(1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::RecordSync
+//
+// Records a sync operation
+//
+// Arguments:
+//
+//	NONE
+
+void MountStatistics::RecordSync(void)
+{
+	GetProcessor()->syncs.fetch_add(1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::RecordTransfer
+//
+// Records a completed data transfer operation
+//
+// Arguments:
+//
+//	direction	- Direction of the data transfer
+//	transferred	- Number of bytes transferred by the operation
+//	elapsed		- Elapsed performance counter ticks
+//	error		- Flag indicating if the operation failed
+
+void MountStatistics::RecordTransfer(Direction direction, size_t transferred, int64_t elapsed, bool error)
+{
+	transfer_t& transfer = GetProcessor()->transfers[static_cast<size_t>(direction)];
+	uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(elapsed, 0) * m_tsfreq);
+
+	transfer.operations.fetch_add(1, std::memory_order_relaxed);
+	if(error) transfer.errors.fetch_add(1, std::memory_order_relaxed);
+	transfer.bytes.fetch_add(transferred, std::memory_order_relaxed);
+	transfer.totalns.fetch_add(ns, std::memory_order_relaxed);
+	transfer.histogram[SystemCallStatistics::BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+
+	// Update the maximum observed latency
+	uint64_t maxns = transfer.maxns.load(std::memory_order_relaxed);
+	while((ns > maxns) && !transfer.maxns.compare_exchange_weak(maxns, ns, std::memory_order_relaxed)) {}
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::RecordUnlink
+//
+// Records the unlinking of a node
+//
+// Arguments:
+//
+//	NONE
+
+void MountStatistics::RecordUnlink(void)
+{
+	GetProcessor()->unlinks.fetch_add(1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::Reset
+//
+// Resets all of the collected statistics
+//
+// Arguments:
+//
+//	NONE
+
+void MountStatistics::Reset(void)
+{
+	for(auto& processor : m_processors) {
+
+		processor->lookups = processor->creates = processor->unlinks = processor->syncs = 0;
+
+		for(auto& transfer : processor->transfers) {
+
+			transfer.operations = transfer.errors = transfer.bytes = transfer.totalns = transfer.maxns = 0;
+			for(auto& bucket : transfer.histogram) bucket = 0;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::Timestamp (static)
+//
+// Gets the current performance counter value
+//
+// Arguments:
+//
+//	NONE
+
+int64_t MountStatistics::Timestamp(void)
+{
+	LARGE_INTEGER				qpc;			// QueryPerformanceCounter value
+
+	QueryPerformanceCounter(&qpc);
+	return qpc.QuadPart;
+}
+
+//
+// MOUNTSTATISTICS::TRANSFER IMPLEMENTATION
+//
+
+//-----------------------------------------------------------------------------
+// MountStatistics::Transfer Constructor
+//
+// Arguments:
+//
+//	stats		- MountStatistics instance to record the operation against
+//	direction	- Direction of the data transfer
+
+MountStatistics::Transfer::Transfer(MountStatistics* stats, Direction direction) : m_stats(stats), m_direction(direction), 
+	m_start(MountStatistics::Timestamp())
+{
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::Transfer Destructor
+
+MountStatistics::Transfer::~Transfer()
+{
+	// An operation that was not completed (typically due to an exception) is a failure
+	if(m_stats) m_stats->RecordTransfer(m_direction, 0, MountStatistics::Timestamp() - m_start, true);
+}
+
+//-----------------------------------------------------------------------------
+// MountStatistics::Transfer::Complete
+//
+// Records the successful completion of the operation
+//
+// Arguments:
+//
+//	transferred		- Number of bytes transferred by the operation
+
+size_t MountStatistics::Transfer::Complete(size_t transferred)
+{
+	if(m_stats) m_stats->RecordTransfer(m_direction, transferred, MountStatistics::Timestamp() - m_start, false);
+	m_stats = nullptr;
+
+	return transferred;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,236 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __MOUNTSTATISTICS_H_
+#define __MOUNTSTATISTICS_H_
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "SystemCallStatistics.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// MountStatistics
+//
+// Collects per-mount operation counters and read/write latency histograms.  An
+// instance is shared among all copies of a mount and any file handles opened
+// through it; counters are maintained per-processor and are only aggregated when
+// a snapshot is requested.  The histograms use the same bucket layout as the
+// system call statistics
+
+class MountStatistics
+{
+public:
+
+	// Instance Constructor
+	//
+	MountStatistics();
+
+	// Destructor
+	//
+	~MountStatistics()=default;
+
+	//-------------------------------------------------------------------------
+	// Fields
+
+	// HistogramBuckets
+	//
+	// Number of latency histogram buckets maintained per transfer direction
+	static size_t const HistogramBuckets = SystemCallStatistics::HistogramBuckets;
+
+	//-------------------------------------------------------------------------
+	// Data Types
+
+	// Direction
+	//
+	// Direction of a data transfer operation
+	enum class Direction
+	{
+		Read		= 0,
+		Write,
+	};
+
+	// TransferSnapshot
+	//
+	// Aggregated statistics for a single transfer direction
+	struct TransferSnapshot
+	{
+		uint64_t								operations;		// Number of operations
+		uint64_t								errors;			// Number of failed operations
+		uint64_t								bytes;			// Number of bytes transferred
+		uint64_t								totalns;		// Total latency (ns)
+		uint64_t								maxns;			// Maximum latency (ns)
+		std::array<uint64_t, HistogramBuckets>	histogram;		// Latency histogram
+	};
+
+	// Snapshot
+	//
+	// Aggregated statistics for the mount
+	struct Snapshot
+	{
+		uint64_t								lookups;		// Number of lookups
+		uint64_t								creates;		// Number of created nodes
+		uint64_t								unlinks;		// Number of unlinked nodes
+		uint64_t								syncs;			// Number of sync operations
+		TransferSnapshot						reads;			// Read statistics
+		TransferSnapshot						writes;			// Write statistics
+	};
+
+	// Transfer
+	//
+	// Measures a single synchronous data transfer operation; if the operation
+	// is not completed before destruction it is recorded as a failure
+	class Transfer
+	{
+	public:
+
+		// Instance Constructor
+		//
+		Transfer(MountStatistics* stats, Direction direction);
+
+		// Destructor
+		//
+		~Transfer();
+
+		//---------------------------------------------------------------------
+		// Member Functions
+
+		// Complete
+		//
+		// Records the successful completion of the operation
+		size_t Complete(size_t transferred);
+
+	private:
+
+		Transfer(Transfer const&)=delete;
+		Transfer& operator=(Transfer const&)=delete;
+
+		//---------------------------------------------------------------------
+		// Member Variables
+
+		MountStatistics*			m_stats;		// Statistics instance
+		Direction const				m_direction;	// Transfer direction
+		int64_t const				m_start;		// Starting timestamp
+	};
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Aggregate
+	//
+	// Aggregates the per-processor statistics into a snapshot
+	Snapshot Aggregate(void) const;
+
+	// Percentile (static)
+	//
+	// Calculates an approximate latency percentile (ns) from a snapshot histogram
+	static uint64_t Percentile(TransferSnapshot const& snapshot, double percentile);
+
+	// RecordCreate
+	//
+	// Records the creation of a node
+	void RecordCreate(void);
+
+	// RecordLookup
+	//
+	// Records a node lookup operation
+	void RecordLookup(void);
+
+	// RecordSync
+	//
+	// Records a sync operation
+	void RecordSync(void);
+
+	// RecordTransfer
+	//
+	// Records a completed data transfer operation
+	void RecordTransfer(Direction direction, size_t transferred, int64_t elapsed, bool error);
+
+	// RecordUnlink
+	//
+	// Records the unlinking of a node
+	void RecordUnlink(void);
+
+	// Reset
+	//
+	// Resets all of the collected statistics
+	void Reset(void);
+
+	// Timestamp (static)
+	//
+	// Gets the current performance counter value
+	static int64_t Timestamp(void);
+
+private:
+
+	MountStatistics(MountStatistics const&)=delete;
+	MountStatistics& operator=(MountStatistics const&)=delete;
+
+	// transfer_t
+	//
+	// Per-processor statistics for a single transfer direction
+	struct transfer_t
+	{
+		std::atomic<uint64_t>		operations;						// Number of operations
+		std::atomic<uint64_t>		errors;							// Number of failed operations
+		std::atomic<uint64_t>		bytes;							// Number of bytes transferred
+		std::atomic<uint64_t>		totalns;						// Total latency (ns)
+		std::atomic<uint64_t>		maxns;							// Maximum latency (ns)
+		std::atomic<uint64_t>		histogram[HistogramBuckets];	// Latency histogram
+	};
+
+	// processor_t
+	//
+	// Per-processor mount statistics
+	struct alignas(64) processor_t
+	{
+		std::atomic<uint64_t>		lookups;						// Number of lookups
+		std::atomic<uint64_t>		creates;						// Number of created nodes
+		std::atomic<uint64_t>		unlinks;						// Number of unlinked nodes
+		std::atomic<uint64_t>		syncs;							// Number of sync operations
+		transfer_t					transfers[2];					// Indexed by Direction
+	};
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// GetProcessor
+	//
+	// Gets the statistics for the current processor
+	processor_t* GetProcessor(void) const;
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	double const								m_tsfreq;		// Nanoseconds per tick
+	std::vector<std::unique_ptr<processor_t>>	m_processors;	// Per-processor statistics
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __MOUNTSTATISTICS_H_
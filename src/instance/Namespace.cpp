@@ -26,9 +26,15 @@
 #include <path.h>
 #include <vector>
 #include "LinuxException.h"
+#include "Tracepoint.h"
 
 #pragma warning(push, 4)
 
+// s_lookuppath (local)
+//
+// Fired on completion of a path name lookup (ns, components, mounts, error)
+static Tracepoint s_lookuppath{ "vfs:lookup_path" };
+
 //---------------------------------------------------------------------------
 // Namespace Constructor
 //
@@ -36,7 +42,7 @@
 //
 //	rootmount		- The namespace root mount
 
-Namespace::Namespace(std::unique_ptr<VirtualMachine::Mount>&& rootmount)
+Namespace::Namespace(std::unique_ptr<VirtualMachine::Mount>&& rootmount) : m_mountslock("Namespace::m_mountslock")
 {
 	// Convert the provided root mount instance into a shared_ptr<>
 	std::shared_ptr<VirtualMachine::Mount> mountpoint(std::move(rootmount));
@@ -64,7 +70,7 @@ Namespace::Namespace(std::unique_ptr<VirtualMachine::Mount>&& rootmount)
 //	rhs			- Source namespace from which to clone internals
 //	flags		- Flags defining which internals to clone
 
-Namespace::Namespace(Namespace const* rhs, uint32_t flags)
+Namespace::Namespace(Namespace const* rhs, uint32_t flags) : m_mountslock("Namespace::m_mountslock")
 {
 	UNREFERENCED_PARAMETER(rhs);
 	UNREFERENCED_PARAMETER(flags);
@@ -95,7 +101,7 @@ std::unique_ptr<Namespace::Path> Namespace::AddMount(std::unique_ptr<VirtualMach
 	mountpath->parent = path->m_path->parent;
 
 	// Acquire an exclusive lock against the mount collection
-	sync::reader_writer_lock::scoped_lock_write writer(m_mountslock);
+	sync::distributed_reader_writer_lock::scoped_lock_write writer(m_mountslock);
 
 	// Insert the mount point into the collection using the ORIGINAL path instance, this way
 	// way whenever that ORIGINAL path instance is discovered it can be replaced with the mount
@@ -107,6 +113,30 @@ std::unique_ptr<Namespace::Path> Namespace::AddMount(std::unique_ptr<VirtualMach
 	return std::unique_ptr<Path>(new Path(mountpath));
 }
 
+//---------------------------------------------------------------------------
+// Namespace::EnumerateMounts
+//
+// Enumerates all of the mount points in the namespace
+//
+// Arguments:
+//
+//	func		- Function to invoke for each mount point; invoked with the lock held
+
+void Namespace::EnumerateMounts(std::function<void(std::string const& path, VirtualMachine::Mount const* mount)> func) const
+{
+	sync::distributed_reader_writer_lock::scoped_lock_read reader(m_mountslock);
+
+	for(auto const& iterator : m_mounts) {
+
+		std::string path;
+
+		// Reconstruct the absolute path of the mount point by walking the parent chain, the
+		// root mount point is keyed with a null path_t
+		for(auto current = iterator.first; current && current->parent; current = current->parent) path.insert(0, "/" + current->name);
+		func(path.empty() ? "/" : path, iterator.second.get());
+	}
+}
+
 //---------------------------------------------------------------------------
 // Namespace::GetRootPath
 //
@@ -118,10 +148,31 @@ std::unique_ptr<Namespace::Path> Namespace::AddMount(std::unique_ptr<VirtualMach
 
 std::unique_ptr<Namespace::Path> Namespace::GetRootPath(void) const
 {
-	sync::reader_writer_lock::scoped_lock_read reader(m_mountslock);
+	sync::distributed_reader_writer_lock::scoped_lock_read reader(m_mountslock);
 	return std::unique_ptr<Path>(new Path(m_rootpath));
 }
 
+//---------------------------------------------------------------------------
+// Namespace::getStatistics
+//
+// Gets a snapshot of the path name lookup statistics
+
+Namespace::LookupStatistics Namespace::getStatistics(void) const
+{
+	LookupStatistics snapshot;
+
+	snapshot.lookups = m_stats.lookups;
+	snapshot.failures = m_stats.failures;
+	snapshot.negative = m_stats.negative;
+	snapshot.components = m_stats.components;
+	snapshot.symlinks = m_stats.symlinks;
+	snapshot.mounts = m_stats.mounts;
+	snapshot.totalns = m_stats.totalns;
+	snapshot.maxns = m_stats.maxns;
+
+	return snapshot;
+}
+
 //---------------------------------------------------------------------------
 // Namespace::LookupPath
 //
@@ -135,15 +186,27 @@ std::unique_ptr<Namespace::Path> Namespace::GetRootPath(void) const
 
 std::unique_ptr<Namespace::Path> Namespace::LookupPath(Path const* working, char_t const* path, uint32_t flags) const
 {
-	int numlinks = 0;							// Number of encountered symbolic links
+	lookupstate_t		state{ 0, 0, 0 };		// Lookup operation state
+	LARGE_INTEGER		start;					// Lookup start timestamp
 
 	if(working == nullptr) throw LinuxException(UAPI_EFAULT);
 	if(path == nullptr) throw LinuxException(UAPI_EFAULT);
 
-	sync::reader_writer_lock::scoped_lock_read reader(m_mountslock);
+	sync::distributed_reader_writer_lock::scoped_lock_read reader(m_mountslock);
+
+	QueryPerformanceCounter(&start);
+
+	try {
+
+		// Hit the internal version of LookupPath that accepts shared_ptr<path_t>
+		auto result = LookupPath(reader, working->m_path, path, flags, &state);
+		RecordLookup(start.QuadPart, state, 0);
 
-	// Hit the internal version of LookupPath that accepts shared_ptr<path_t>
-	return std::unique_ptr<Path>(new Path(LookupPath(reader, working->m_path, path, flags, &numlinks)));
+		return std::unique_ptr<Path>(new Path(result));
+	}
+
+	catch(LinuxException const& ex) { RecordLookup(start.QuadPart, state, ex.Code); throw; }
+	catch(...) { RecordLookup(start.QuadPart, state, UAPI_EIO); throw; }
 }
 
 //---------------------------------------------------------------------------
@@ -158,10 +221,10 @@ std::unique_ptr<Namespace::Path> Namespace::LookupPath(Path const* working, char
 //	current		- Reference to the current path_t
 //	path		- Remaining path to be looked up
 //	flags		- Lookup operation flags (O_DIRECTORY, O_NOFOLLOW, etc)
-//	numlinks	- Running count of symbolic links encountered
+//	state		- Running lookup operation state
 
-std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_lock::scoped_lock& lock, std::shared_ptr<path_t> const& working, 
-	char_t const* path, uint32_t flags, int* numlinks) const
+std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::distributed_reader_writer_lock::scoped_lock& lock, std::shared_ptr<path_t> const& working, 
+	char_t const* path, uint32_t flags, lookupstate_t* state) const
 {
 	mountmap_t::const_iterator		mountpoint;			// Mount collection iterator
 	posix_path						lookuppath(path);	// Convert into a posix_path
@@ -169,19 +232,20 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 	UNREFERENCED_PARAMETER(lock);		// Unused; ensures the caller holds a scoped_lock
 
 	if(path == nullptr) throw LinuxException(UAPI_EFAULT);
-	if(numlinks == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(state == nullptr) throw LinuxException(UAPI_EFAULT);
 
-	// Clone either the working path_t or the namespace root path_t as the starting point
-	auto current = std::make_shared<path_t>((lookuppath.absolute()) ? m_rootpath : working);
+	// Start from either the working path_t or the namespace root path_t; path_t instances
+	// are never modified once created so these can be shared rather than cloned
+	std::shared_ptr<path_t> current = (lookuppath.absolute()) ? m_rootpath : working;
 
 	// Handle any mount points stacked on top of the starting node by switching the mount and
 	// node pointers appropriately; this does not change the name or the parent pointer
 	mountpoint = m_mounts.find(current);
 	while(mountpoint != m_mounts.end()) { 
 
-		current->mount = mountpoint->second;
-		current->node = mountpoint->second->RootNode->Duplicate();
+		current = MountPath(current, mountpoint->second);
 		mountpoint = m_mounts.find(current);
+		++state->mounts;
 	}
 
 	// Iterate over each component of the lookup path and build out the resultant path_t
@@ -199,7 +263,7 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 		// DIRECTORY LOOKUP
 		else if((current->node->Mode & UAPI_S_IFMT) == UAPI_S_IFDIR) {
 
-			auto directory = std::dynamic_pointer_cast<VirtualMachine::Directory>(current->node);
+			auto directory = dynamic_cast<VirtualMachine::Directory*>(current->node.get());
 			if(directory == nullptr) throw LinuxException(UAPI_ENOTDIR);
 
 			// Create a new path_t for the child that uses the directory as its parent
@@ -208,6 +272,7 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 			child->parent = current;
 			child->name = iterator;
 			child->node = directory->Lookup(current->mount.get(), iterator);
+			++state->components;
 
 			current = child;			// move to the child node
 		}
@@ -215,11 +280,11 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 		// FOLLOW SYMBOLIC LINK
 		else if((current->node->Mode & UAPI_S_IFMT) == UAPI_S_IFLNK) {
 		
-			auto symlink = std::dynamic_pointer_cast<VirtualMachine::SymbolicLink>(current->node);
+			auto symlink = dynamic_cast<VirtualMachine::SymbolicLink*>(current->node.get());
 			if(symlink == nullptr) throw LinuxException(UAPI_ENOTDIR);
 
 			// Ensure that the maximum number of symbolic links has not been reached
-			if(++(*numlinks) > VirtualMachine::MaxSymbolicLinks) throw LinuxException(UAPI_ELOOP);
+			if(++state->numlinks > VirtualMachine::MaxSymbolicLinks) throw LinuxException(UAPI_ELOOP);
 
 			// Read the symbolic link target (changed to a method to allow for access time updates)
 			size_t length = symlink->Length;
@@ -230,7 +295,7 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 			// Move current to the target of the symbolic link; note that the lookup is
 			// relative to the symbolic link's parent, not the symbolic link itself
 			_ASSERTE(current->parent);
-			current = LookupPath(lock, current->parent, &target[0], flags, numlinks);
+			current = LookupPath(lock, current->parent, &target[0], flags, state);
 		}
 
 		// LOOKUP ERROR
@@ -240,20 +305,20 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 		mountpoint = m_mounts.find(current);
 		while(mountpoint != m_mounts.end()) { 
 
-			current->mount = mountpoint->second;
-			current->node = mountpoint->second->RootNode->Duplicate();
+			current = MountPath(current, mountpoint->second);
 			mountpoint = m_mounts.find(current);
+			++state->mounts;
 		}
 	}
 
 	// If the final node is a symbolic link, follow it unless O_NOFOLLOW was specified
 	if(((current->node->Mode & UAPI_S_IFMT) == UAPI_S_IFLNK) && ((flags & UAPI_O_NOFOLLOW) == 0)) {
 
-		auto symlink = std::dynamic_pointer_cast<VirtualMachine::SymbolicLink>(current->node);
+		auto symlink = dynamic_cast<VirtualMachine::SymbolicLink*>(current->node.get());
 		if(symlink == nullptr) throw LinuxException(UAPI_ENOTDIR);
 
 		// Ensure that the maximum number of symbolic links has not been reached
-		if(++(*numlinks) > VirtualMachine::MaxSymbolicLinks) throw LinuxException(UAPI_ELOOP);
+		if(++state->numlinks > VirtualMachine::MaxSymbolicLinks) throw LinuxException(UAPI_ELOOP);
 
 		// Read the symbolic link target (changed to a method to allow for access time updates)
 		size_t length = symlink->Length;
@@ -264,7 +329,7 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 		// Move current to the target of the symbolic link; note that the lookup is
 		// relative to the symbolic link's parent, not the symbolic link itself
 		_ASSERTE(current->parent);
-		current = LookupPath(lock, current->parent, &target[0], flags, numlinks);
+		current = LookupPath(lock, current->parent, &target[0], flags, state);
 	}
 
 	// If O_DIRECTORY has been specified the final path component must be a directory node
@@ -276,10 +341,75 @@ std::shared_ptr<Namespace::path_t> Namespace::LookupPath(sync::reader_writer_loc
 	return current;
 }
 
+//---------------------------------------------------------------------------
+// Namespace::MountPath (private, static)
+//
+// Creates a path_t that refers to the root of a mount stacked on top of a path_t
+//
+// Arguments:
+//
+//	path		- Path on which the mount is stacked
+//	mount		- Mount stacked on top of the path
+
+std::shared_ptr<Namespace::path_t> Namespace::MountPath(std::shared_ptr<path_t> const& path, std::shared_ptr<VirtualMachine::Mount> const& mount)
+{
+	// The mounted path_t switches the mount and node pointers; this does not change
+	// the name or the parent pointer of the original path
+	auto mounted = std::make_shared<path_t>();
+	mounted->mount = mount;
+	mounted->name = path->name;
+	mounted->node = mount->RootNode->Duplicate();
+	mounted->parent = path->parent;
+
+	return mounted;
+}
+
 //
 // NAMESPACE::PATH IMPLEMENTATION
 //
 
+//---------------------------------------------------------------------------
+// Namespace::RecordLookup (private)
+//
+// Records the statistics for a completed path name lookup operation
+//
+// Arguments:
+//
+//	start		- Performance counter value at the start of the lookup
+//	state		- Final lookup operation state
+//	error		- Linux error code if the lookup failed, otherwise zero
+
+void Namespace::RecordLookup(int64_t start, lookupstate_t const& state, int error) const
+{
+	LARGE_INTEGER		end;					// Lookup end timestamp
+
+	static uint64_t const frequency = []() -> uint64_t {
+
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return static_cast<uint64_t>(frequency.QuadPart);
+	}();
+
+	QueryPerformanceCounter(&end);
+
+	uint64_t ticks = static_cast<uint64_t>(end.QuadPart - start);
+	uint64_t ns = ((ticks / frequency) * 1000000000ui64) + (((ticks % frequency) * 1000000000ui64) / frequency);
+
+	++m_stats.lookups;
+	if(error != 0) ++m_stats.failures;
+	if(error == UAPI_ENOENT) ++m_stats.negative;
+
+	m_stats.components += state.components;
+	m_stats.symlinks += static_cast<uint64_t>(state.numlinks);
+	m_stats.mounts += state.mounts;
+	m_stats.totalns += ns;
+
+	uint64_t current = m_stats.maxns;
+	while((ns > current) && (!m_stats.maxns.compare_exchange_weak(current, ns))) { /* spin */ }
+
+	s_lookuppath.Fire(ns, state.components, state.mounts, static_cast<uint64_t>(error));
+}
+
 //---------------------------------------------------------------------------
 // Namespace::Path Constructor (private)
 //
@@ -335,21 +465,6 @@ std::unique_ptr<VirtualMachine::Handle> Namespace::Path::Open(uint32_t flags) co
 	return m_path->node->CreateHandle(m_path->mount.get(), flags);
 }
 
-//
-// NAMESPACE::PATH_T IMPLEMENTATION
-//
-
-//---------------------------------------------------------------------------
-// Namespace::path_t Constructor
-//
-// Arguments:
-//
-//	rhs		- Right-hand shared_ptr<path_t> to clone into this path_t
-
-Namespace::path_t::path_t(std::shared_ptr<path_t> const& rhs) : mount(rhs->mount), name(rhs->name), node(rhs->node), parent(rhs->parent)
-{
-}
-
 //
 // NAMESPACE::EQUALSPATH_T IMPLEMENTATION
 //
@@ -24,6 +24,7 @@
 #define __NAMESPACE_H_
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <sync.h>
@@ -124,6 +125,21 @@ public:
 		std::unique_ptr<VirtualMachine::Node>	m_node;		// Node instance
 	};
 
+	// LookupStatistics
+	//
+	// Aggregated path name lookup statistics for the namespace
+	struct LookupStatistics
+	{
+		uint64_t		lookups;		// Number of lookups
+		uint64_t		failures;		// Number of failed lookups
+		uint64_t		negative;		// Number of lookups that failed with ENOENT
+		uint64_t		components;		// Number of path components traversed
+		uint64_t		symlinks;		// Number of symbolic links followed
+		uint64_t		mounts;			// Number of mount points crossed
+		uint64_t		totalns;		// Total lookup time (ns)
+		uint64_t		maxns;			// Maximum lookup time (ns)
+	};
+
 	//-------------------------------------------------------------------------
 	// Member Functions
 
@@ -132,6 +148,11 @@ public:
 	// Adds a new mount point to the namespace
 	std::unique_ptr<Path> AddMount(std::unique_ptr<VirtualMachine::Mount>&& mount, Path const* path);
 
+	// EnumerateMounts
+	//
+	// Enumerates all of the mount points in the namespace
+	void EnumerateMounts(std::function<void(std::string const& path, VirtualMachine::Mount const* mount)> func) const;
+
 	// GetRootPath
 	//
 	// Gets the namespace root path
@@ -142,6 +163,15 @@ public:
 	// Performs a path name lookup operation
 	std::unique_ptr<Path> LookupPath(Path const* working, char_t const* path, uint32_t flags) const;
 
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// Statistics
+	//
+	// Gets a snapshot of the path name lookup statistics
+	__declspec(property(get=getStatistics)) LookupStatistics Statistics;
+	LookupStatistics getStatistics(void) const;
+
 private:
 
 	Namespace(Namespace const&)=delete;
@@ -156,10 +186,6 @@ private:
 		//
 		path_t()=default;
 
-		// converting constructor
-		//
-		path_t(std::shared_ptr<path_t> const& rhs);
-
 		// mount
 		//
 		// Pointer to the mount point for this path
@@ -172,8 +198,9 @@ private:
 
 		// node
 		//
-		// Pointer to the node that the path references
-		std::shared_ptr<VirtualMachine::Node> node;
+		// Pointer to the node that the path references; the path_t is itself shared
+		// so the node instance is owned exclusively to avoid a separate control block
+		std::unique_ptr<VirtualMachine::Node> node;
 
 		// parent
 		//
@@ -197,26 +224,62 @@ private:
 		size_t operator()(std::shared_ptr<path_t> const& key) const;
 	};
 
+	// lookupstate_t
+	//
+	// State accumulated over a single path name lookup operation
+	struct lookupstate_t
+	{
+		int				numlinks;		// Number of encountered symbolic links
+		uint64_t		components;		// Number of path components traversed
+		uint64_t		mounts;			// Number of mount points crossed
+	};
+
 	// mountmap_t
 	//
 	// Type defintion for an unordered_map<> collection of mount points
 	using mountmap_t = std::unordered_map<std::shared_ptr<path_t>, std::shared_ptr<VirtualMachine::Mount>, hash_path_t, equals_path_t>;
 
+	// stats_t
+	//
+	// Path name lookup statistics counters
+	struct stats_t
+	{
+		std::atomic<uint64_t>	lookups = 0;		// Number of lookups
+		std::atomic<uint64_t>	failures = 0;		// Number of failed lookups
+		std::atomic<uint64_t>	negative = 0;		// Number of lookups that failed with ENOENT
+		std::atomic<uint64_t>	components = 0;		// Number of path components traversed
+		std::atomic<uint64_t>	symlinks = 0;		// Number of symbolic links followed
+		std::atomic<uint64_t>	mounts = 0;			// Number of mount points crossed
+		std::atomic<uint64_t>	totalns = 0;		// Total lookup time (ns)
+		std::atomic<uint64_t>	maxns = 0;			// Maximum lookup time (ns)
+	};
+
 	//-------------------------------------------------------------------------
 	// Private Member Functions
 
 	// LookupPath
 	//
 	// Performs a path name lookup operation
-	std::shared_ptr<path_t> LookupPath(sync::reader_writer_lock::scoped_lock& lock, std::shared_ptr<path_t> const& working, 
-		char_t const* path, uint32_t flags, int* numlinks) const;
+	std::shared_ptr<path_t> LookupPath(sync::distributed_reader_writer_lock::scoped_lock& lock, std::shared_ptr<path_t> const& working, 
+		char_t const* path, uint32_t flags, lookupstate_t* state) const;
+
+	// MountPath (static)
+	//
+	// Creates a path_t that refers to the root of a mount stacked on top of a path_t
+	static std::shared_ptr<path_t> MountPath(std::shared_ptr<path_t> const& path, std::shared_ptr<VirtualMachine::Mount> const& mount);
+
+	// RecordLookup
+	//
+	// Records the statistics for a completed path name lookup operation
+	void RecordLookup(int64_t start, lookupstate_t const& state, int error) const;
 
 	//-------------------------------------------------------------------------
 	// Member Variables
 
-	std::shared_ptr<path_t>				m_rootpath;		// Namespace root path
-	mountmap_t							m_mounts;		// Collection of mount points
-	mutable sync::reader_writer_lock	m_mountslock;	// Synchronization object
+	std::shared_ptr<path_t>							m_rootpath;		// Namespace root path
+	mountmap_t										m_mounts;		// Collection of mount points
+	mutable sync::distributed_reader_writer_lock	m_mountslock;	// Synchronization object
+	mutable stats_t									m_stats;		// Lookup statistics
 };
 
 //-----------------------------------------------------------------------------
@@ -30,6 +30,8 @@
 #include <SystemInformation.h>
 #include <Win32Exception.h>
 
+#include "Tracepoint.h"
+
 #pragma warning(push, 4)
 
 // SectionFlags
@@ -42,6 +44,23 @@ using SectionFlags = ULONG;
 // Alias for ULONG, used with convert<> template
 using SectionProtection = ULONG;
 
+//-----------------------------------------------------------------------------
+// Tracepoints
+//
+// Fired on entry to the memory operations (pid, address, length, protection)
+//-----------------------------------------------------------------------------
+
+static Tracepoint s_mmallocate{ "mm:allocate" };
+static Tracepoint s_mmlock{ "mm:lock" };
+static Tracepoint s_mmmap{ "mm:map" };
+static Tracepoint s_mmprotect{ "mm:protect" };
+static Tracepoint s_mmread{ "mm:read" };
+static Tracepoint s_mmrelease{ "mm:release" };
+static Tracepoint s_mmreserve{ "mm:reserve" };
+static Tracepoint s_mmunlock{ "mm:unlock" };
+static Tracepoint s_mmunmap{ "mm:unmap" };
+static Tracepoint s_mmwrite{ "mm:write" };
+
 //-----------------------------------------------------------------------------
 // Conversions
 //-----------------------------------------------------------------------------
@@ -113,7 +132,8 @@ NativeProcess::NativeProcess(tchar_t const* path, tchar_t const* arguments) : Na
 //	handles		- Optional array of inheritable handle objects
 //	numhandles	- Number of elements in the handles array
 
-NativeProcess::NativeProcess(tchar_t const* path, tchar_t const* arguments, HANDLE handles[], size_t numhandles)
+NativeProcess::NativeProcess(tchar_t const* path, tchar_t const* arguments, HANDLE handles[], size_t numhandles) : 
+	m_sectionslock("NativeProcess::m_sectionslock")
 {
 	memset(&m_procinfo, 0, sizeof(PROCESS_INFORMATION));
 
@@ -210,6 +230,8 @@ uintptr_t NativeProcess::AllocateMemory(size_t length, VirtualMachine::Protectio
 {
 	ULONG				previous;					// Previous memory protection flags
 
+	s_mmallocate.Fire(m_procinfo.dwProcessId, 0, length, convert<SectionProtection>(protection));
+
 	sync::reader_writer_lock::scoped_lock_write writer(m_sectionslock);
 
 	// Emplace a new section into the section collection, aligning the length up to the allocation granularity
@@ -241,6 +263,8 @@ uintptr_t NativeProcess::AllocateMemory(size_t length, VirtualMachine::Protectio
 
 uintptr_t NativeProcess::AllocateMemory(uintptr_t address, size_t length, VirtualMachine::ProtectionFlags protection)
 {
+	s_mmallocate.Fire(m_procinfo.dwProcessId, address, length, convert<SectionProtection>(protection));
+
 	// This operation is different when the caller doesn't care what the base address is
 	if(address == 0) return AllocateMemory(length, protection, VirtualMachine::AllocationFlags::None);
 
@@ -437,6 +461,8 @@ void NativeProcess::IterateRange(sync::reader_writer_lock::scoped_lock& lock, ui
 
 void NativeProcess::LockMemory(uintptr_t address, size_t length) const
 {
+	s_mmlock.Fire(m_procinfo.dwProcessId, address, length);
+
 	sync::reader_writer_lock::scoped_lock_read reader(m_sectionslock);
 
 	// Attempt to unlock all pages within the specified address range
@@ -471,6 +497,8 @@ void* NativeProcess::MapMemory(uintptr_t address, size_t length, VirtualMachine:
 	void*						nextmapping = nullptr;		// Address of the next mapping
 	void*						returnptr = nullptr;		// Pointer to return to the caller
 
+	s_mmmap.Fire(m_procinfo.dwProcessId, address, length, convert<SectionProtection>(protection));
+
 	// Guard pages cannot be specified as the protection for this function
 	if(protection & VirtualMachine::ProtectionFlags::Guard) throw Exception(E_INVALIDARG);
 
@@ -533,6 +561,8 @@ DWORD NativeProcess::getProcessId(void) const
 
 void NativeProcess::ProtectMemory(uintptr_t address, size_t length, VirtualMachine::ProtectionFlags protection) const
 {
+	s_mmprotect.Fire(m_procinfo.dwProcessId, address, length, convert<SectionProtection>(protection));
+
 	sync::reader_writer_lock::scoped_lock_read reader(m_sectionslock);
 
 	// Set the protection for all of the pages in the specified range
@@ -562,6 +592,8 @@ size_t NativeProcess::ReadMemory(uintptr_t address, void* buffer, size_t length)
 {
 	size_t					total = 0;				// Number of bytes read from the process
 
+	s_mmread.Fire(m_procinfo.dwProcessId, address, length);
+
 	sync::reader_writer_lock::scoped_lock_read reader(m_sectionslock);
 
 	// Execute the read operation in multiple steps as necessary to ensure all addresses are "allocated"
@@ -594,6 +626,8 @@ size_t NativeProcess::ReadMemory(uintptr_t address, void* buffer, size_t length)
 
 void NativeProcess::ReleaseMemory(uintptr_t address, size_t length)
 {
+	s_mmrelease.Fire(m_procinfo.dwProcessId, address, length);
+
 	sync::reader_writer_lock::scoped_lock_write writer(m_sectionslock);
 
 	// Release all of the pages in the specified range
@@ -686,6 +720,8 @@ uintptr_t NativeProcess::ReserveMemory(size_t length)
 
 uintptr_t NativeProcess::ReserveMemory(size_t length, VirtualMachine::AllocationFlags flags)
 {
+	s_mmreserve.Fire(m_procinfo.dwProcessId, 0, length);
+
 	sync::reader_writer_lock::scoped_lock_write writer(m_sectionslock);
 
 	// Emplace a new section into the section collection, aligning the length up to the allocation granularity
@@ -707,6 +743,8 @@ uintptr_t NativeProcess::ReserveMemory(size_t length, VirtualMachine::Allocation
 
 uintptr_t NativeProcess::ReserveMemory(uintptr_t address, size_t length)
 {
+	s_mmreserve.Fire(m_procinfo.dwProcessId, address, length);
+
 	// This operation is different when the caller doesn't care what the base address is
 	if(address == 0) return ReserveMemory(length, VirtualMachine::AllocationFlags::None);
 
@@ -828,6 +866,8 @@ void NativeProcess::Terminate(uint32_t exitcode, bool wait) const
 
 void NativeProcess::UnlockMemory(uintptr_t address, size_t length) const
 {
+	s_mmunlock.Fire(m_procinfo.dwProcessId, address, length);
+
 	sync::reader_writer_lock::scoped_lock_read reader(m_sectionslock);
 
 	// Attempt to unlock all pages within the specified address range
@@ -852,6 +892,8 @@ void NativeProcess::UnlockMemory(uintptr_t address, size_t length) const
 
 void NativeProcess::UnmapMemory(void const* mapping)
 {
+	s_mmunmap.Fire(m_procinfo.dwProcessId, reinterpret_cast<uintptr_t>(mapping));
+
 	sync::reader_writer_lock::scoped_lock_write writer(m_sectionslock);
 
 	// Locate the mapping address in the local mappings collection
@@ -880,6 +922,8 @@ size_t NativeProcess::WriteMemory(uintptr_t address, void const* buffer, size_t
 {
 	size_t					total = 0;				// Number of bytes read from the process
 
+	s_mmwrite.Fire(m_procinfo.dwProcessId, address, length);
+
 	sync::reader_writer_lock::scoped_lock_read reader(m_sectionslock);
 
 	// Execute the write operation in multiple steps as necessary to ensure all addresses are "allocated"
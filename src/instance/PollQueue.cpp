@@ -0,0 +1,150 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "PollQueue.h"
+
+#pragma comment(lib, "synchronization.lib")
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// PollQueue Constructor
+//
+// Arguments:
+//
+//	NONE
+
+PollQueue::PollQueue() : m_head(nullptr), m_tail(nullptr), m_generation(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+// PollQueue::getGeneration
+//
+// Gets the current notification generation
+
+uint32_t PollQueue::getGeneration(void) const
+{
+	return m_generation.load();
+}
+
+//-----------------------------------------------------------------------------
+// PollQueue::Notify
+//
+// Notifies subscribers and blocked waiters that events have been signaled
+//
+// Arguments:
+//
+//	events		- Set of events that have been signaled
+
+void PollQueue::Notify(uint32_t events)
+{
+	bool		exclusive = false;			// Flag if an exclusive entry was notified
+
+	// Wake up any threads blocked in Wait() for this queue
+	m_generation.fetch_add(1);
+	WakeByAddressAll(&m_generation);
+
+	sync::critical_section::scoped_lock lock(m_lock);
+
+	for(Entry* entry = m_head; entry != nullptr; entry = entry->next) {
+
+		// Only the first exclusive entry that accepts the events is notified
+		if(entry->exclusive) {
+
+			if(!exclusive) exclusive = entry->Notify(events);
+		}
+
+		else entry->Notify(events);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// PollQueue::Subscribe
+//
+// Adds an entry to the wait queue
+//
+// Arguments:
+//
+//	entry		- Entry to be added to the queue
+
+void PollQueue::Subscribe(Entry* entry)
+{
+	_ASSERTE(entry);
+
+	sync::critical_section::scoped_lock lock(m_lock);
+
+	entry->next = nullptr;
+	entry->prev = m_tail;
+
+	if(m_tail) m_tail->next = entry;
+	else m_head = entry;
+
+	m_tail = entry;
+}
+
+//-----------------------------------------------------------------------------
+// PollQueue::Unsubscribe
+//
+// Removes an entry from the wait queue
+//
+// Arguments:
+//
+//	entry		- Entry to be removed from the queue
+
+void PollQueue::Unsubscribe(Entry* entry)
+{
+	_ASSERTE(entry);
+
+	sync::critical_section::scoped_lock lock(m_lock);
+
+	if(entry->prev) entry->prev->next = entry->next;
+	else m_head = entry->next;
+
+	if(entry->next) entry->next->prev = entry->prev;
+	else m_tail = entry->prev;
+
+	entry->prev = entry->next = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// PollQueue::Wait
+//
+// Waits for the generation of the queue to change
+//
+// Arguments:
+//
+//	generation	- Generation previously obtained from the Generation property
+//	timeout		- Timeout in milliseconds or INFINITE
+
+bool PollQueue::Wait(uint32_t generation, uint32_t timeout) const
+{
+	// WaitOnAddress can return spuriously; the caller is expected to retry its
+	// operation and wait again if necessary after this returns
+	if(m_generation.load() != generation) return true;
+	return (WaitOnAddress(const_cast<std::atomic<uint32_t>*>(&m_generation), &generation, sizeof(uint32_t), timeout) == TRUE);
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,125 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __POLLQUEUE_H_
+#define __POLLQUEUE_H_
+#pragma once
+
+#include <atomic>
+#include <sync.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// PollQueue
+//
+// Per-file wait queue; notifies subscribed entries (epoll items) when the set of
+// signaled events for the file changes, and allows blocking operations against
+// the file to wait for a change without polling.  Only one exclusive entry is
+// notified for each event (EPOLLEXCLUSIVE), non-exclusive entries are always
+// notified
+
+class PollQueue
+{
+public:
+
+	// Instance Constructor
+	//
+	PollQueue();
+
+	// Destructor
+	//
+	~PollQueue()=default;
+
+	//-------------------------------------------------------------------------
+	// Data Types
+
+	// Entry
+	//
+	// Subscriber to the wait queue
+	struct Entry
+	{
+		// Destructor
+		//
+		virtual ~Entry()=default;
+
+		// Notify
+		//
+		// Invoked when events have been signaled; returns true if the events were accepted
+		virtual bool Notify(uint32_t events) = 0;
+
+		bool			exclusive = false;		// EPOLLEXCLUSIVE entry
+		Entry*			prev = nullptr;			// Previous subscriber
+		Entry*			next = nullptr;			// Next subscriber
+	};
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Notify
+	//
+	// Notifies subscribers and blocked waiters that events have been signaled
+	void Notify(uint32_t events);
+
+	// Subscribe
+	//
+	// Adds an entry to the wait queue
+	void Subscribe(Entry* entry);
+
+	// Unsubscribe
+	//
+	// Removes an entry from the wait queue
+	void Unsubscribe(Entry* entry);
+
+	// Wait
+	//
+	// Waits for the generation of the queue to change
+	bool Wait(uint32_t generation, uint32_t timeout) const;
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// Generation
+	//
+	// Gets the current notification generation
+	__declspec(property(get=getGeneration)) uint32_t Generation;
+	uint32_t getGeneration(void) const;
+
+private:
+
+	PollQueue(PollQueue const&)=delete;
+	PollQueue& operator=(PollQueue const&)=delete;
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	mutable sync::critical_section		m_lock;			// Synchronization object
+	Entry*								m_head;			// First subscriber
+	Entry*								m_tail;			// Last subscriber
+	std::atomic<uint32_t>				m_generation;	// Notification generation
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __POLLQUEUE_H_
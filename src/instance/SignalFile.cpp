@@ -0,0 +1,263 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "SignalFile.h"
+
+#include "LinuxException.h"
+
+#pragma warning(push, 4)
+
+// SIGNAL_MASK
+//
+// Converts a signal number into a signal mask bit
+#define SIGNAL_MASK(__signo) (1ui64 << ((__signo) - 1))
+
+// UNBLOCKABLE_SIGNALS
+//
+// SIGKILL and SIGSTOP cannot be accepted by a signalfd handle
+static uint64_t const UNBLOCKABLE_SIGNALS = SIGNAL_MASK(9) | SIGNAL_MASK(19);
+
+//-----------------------------------------------------------------------------
+// SignalFile Constructor
+//
+// Arguments:
+//
+//	mask		- Set of signals accepted by the handle
+//	flags		- SFD_XXXX flags
+
+SignalFile::SignalFile(uint64_t mask, int flags) : SignalFile(std::make_shared<signalfd_t>(), 
+	UAPI_O_RDONLY | (flags & (UAPI_SFD_CLOEXEC | UAPI_SFD_NONBLOCK)))
+{
+	if(flags & ~(UAPI_SFD_CLOEXEC | UAPI_SFD_NONBLOCK)) throw LinuxException(UAPI_EINVAL);
+
+	m_signalfd->mask = mask & ~UNBLOCKABLE_SIGNALS;
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile Constructor (private)
+//
+// Arguments:
+//
+//	signalfd	- Shared signal object
+//	flags		- Handle-level flags
+
+SignalFile::SignalFile(std::shared_ptr<signalfd_t> const& signalfd, uint32_t flags) : m_signalfd(signalfd), m_flags(flags)
+{
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::Duplicate
+//
+// Duplicates this Handle instance
+//
+// Arguments:
+//
+//	flags		- Handle-level flags for the duplicate
+
+std::unique_ptr<VirtualMachine::Handle> SignalFile::Duplicate(uint32_t flags) const
+{
+	return std::unique_ptr<SignalFile>(new SignalFile(m_signalfd, flags));
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::getFlags
+//
+// Gets the handle-level flags applied to this instance
+
+uint32_t SignalFile::getFlags(void) const
+{
+	return m_flags;
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::getMask
+//
+// Gets the set of signals accepted by the handle
+
+uint64_t SignalFile::getMask(void) const
+{
+	sync::critical_section::scoped_lock lock(m_signalfd->lock);
+	return m_signalfd->mask;
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::Poll
+//
+// Gets the set of events (EPOLLIN, EPOLLOUT, ...) currently signaled
+//
+// Arguments:
+//
+//	NONE
+
+uint32_t SignalFile::Poll(void) const
+{
+	sync::critical_section::scoped_lock lock(m_signalfd->lock);
+	return (m_signalfd->pending.empty()) ? 0 : UAPI_EPOLLIN | UAPI_EPOLLRDNORM;
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::Read
+//
+// Reads queued signalfd_siginfo structures from the handle
+//
+// Arguments:
+//
+//	buffer		- Destination buffer
+//	count		- Size of the destination buffer, in bytes
+
+size_t SignalFile::Read(void* buffer, size_t count)
+{
+	size_t			result = 0;			// Number of bytes read
+
+	if(buffer == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(count < sizeof(uapi_signalfd_siginfo)) throw LinuxException(UAPI_EINVAL);
+
+	uapi_signalfd_siginfo* siginfo = reinterpret_cast<uapi_signalfd_siginfo*>(buffer);
+
+	while(true) {
+
+		// Capture the wait queue generation before checking the queue to avoid a lost wakeup
+		uint32_t generation = m_signalfd->waitqueue.Generation;
+
+		sync::critical_section::scoped_lock lock(m_signalfd->lock);
+
+		// Return as many queued signals as will fit in the destination buffer
+		while(!m_signalfd->pending.empty() && ((count - result) >= sizeof(uapi_signalfd_siginfo))) {
+
+			*siginfo++ = m_signalfd->pending.front();
+			m_signalfd->pending.pop_front();
+			result += sizeof(uapi_signalfd_siginfo);
+		}
+
+		if(result > 0) return result;
+
+		lock.unlock();
+
+		if(m_flags & UAPI_O_NONBLOCK) throw LinuxException(UAPI_EAGAIN);
+		m_signalfd->waitqueue.Wait(generation, INFINITE);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::Seek
+//
+// Changes the file position
+//
+// Arguments:
+//
+//	offset		- Offset into the file
+//	whence		- Starting position for the offset
+
+size_t SignalFile::Seek(ssize_t offset, int whence)
+{
+	UNREFERENCED_PARAMETER(offset);
+	UNREFERENCED_PARAMETER(whence);
+
+	throw LinuxException(UAPI_ESPIPE);
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::SetMask
+//
+// Changes the set of signals accepted by the handle
+//
+// Arguments:
+//
+//	mask		- Set of signals accepted by the handle
+
+void SignalFile::SetMask(uint64_t mask)
+{
+	sync::critical_section::scoped_lock lock(m_signalfd->lock);
+	m_signalfd->mask = mask & ~UNBLOCKABLE_SIGNALS;
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::Signal
+//
+// Queues a signal to the handle if it is included in the mask
+//
+// Arguments:
+//
+//	siginfo		- Information about the signal being queued
+
+bool SignalFile::Signal(uapi_signalfd_siginfo const& siginfo)
+{
+	if((siginfo.ssi_signo == 0) || (siginfo.ssi_signo > 64)) throw LinuxException(UAPI_EINVAL);
+
+	sync::critical_section::scoped_lock lock(m_signalfd->lock);
+
+	if((m_signalfd->mask & SIGNAL_MASK(siginfo.ssi_signo)) == 0) return false;
+
+	m_signalfd->pending.push_back(siginfo);
+	lock.unlock();
+
+	// The wait queue must be notified without holding the signal object lock
+	m_signalfd->waitqueue.Notify(UAPI_EPOLLIN | UAPI_EPOLLRDNORM);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::Sync
+//
+// Synchronizes all data associated with the file to storage, not metadata
+//
+// Arguments:
+//
+//	NONE
+
+void SignalFile::Sync(void) const
+{
+	throw LinuxException(UAPI_EINVAL);
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::getWaitQueue
+//
+// Gets the wait queue that is notified when the signaled events change
+
+PollQueue* SignalFile::getWaitQueue(void) const
+{
+	return &m_signalfd->waitqueue;
+}
+
+//-----------------------------------------------------------------------------
+// SignalFile::Write
+//
+// Signal handles cannot be written to
+//
+// Arguments:
+//
+//	buffer		- Source buffer
+//	count		- Size of the source buffer, in bytes
+
+size_t SignalFile::Write(const void* buffer, size_t count)
+{
+	UNREFERENCED_PARAMETER(buffer);
+	UNREFERENCED_PARAMETER(count);
+
+	throw LinuxException(UAPI_EINVAL);
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
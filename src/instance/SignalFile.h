@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __SIGNALFILE_H_
+#define __SIGNALFILE_H_
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <sync.h>
+
+#include "PollQueue.h"
+#include "VirtualMachine.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// SignalFile
+//
+// Implements a signalfd(2) signal notification handle; signals are queued to the
+// handle by the signal delivery code when they are included in the handle mask
+
+class SignalFile : public VirtualMachine::PollableHandle
+{
+public:
+
+	// Instance Constructor
+	//
+	SignalFile(uint64_t mask, int flags);
+
+	// Destructor
+	//
+	virtual ~SignalFile()=default;
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Duplicate (VirtualMachine::Handle)
+	//
+	// Duplicates this Handle instance
+	virtual std::unique_ptr<VirtualMachine::Handle> Duplicate(uint32_t flags) const override;
+
+	// Poll (VirtualMachine::PollableHandle)
+	//
+	// Gets the set of events (EPOLLIN, EPOLLOUT, ...) currently signaled
+	virtual uint32_t Poll(void) const override;
+
+	// Read (VirtualMachine::Handle)
+	//
+	// Reads queued signalfd_siginfo structures from the handle
+	virtual size_t Read(void* buffer, size_t count) override;
+
+	// Seek (VirtualMachine::Handle)
+	//
+	// Changes the file position
+	virtual size_t Seek(ssize_t offset, int whence) override;
+
+	// SetMask
+	//
+	// Changes the set of signals accepted by the handle
+	void SetMask(uint64_t mask);
+
+	// Signal
+	//
+	// Queues a signal to the handle if it is included in the mask
+	bool Signal(uapi_signalfd_siginfo const& siginfo);
+
+	// Sync (VirtualMachine::Handle)
+	//
+	// Synchronizes all data associated with the file to storage, not metadata
+	virtual void Sync(void) const override;
+
+	// Write (VirtualMachine::Handle)
+	//
+	// Signal handles cannot be written to
+	virtual size_t Write(const void* buffer, size_t count) override;
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// Flags (VirtualMachine::Handle)
+	//
+	// Gets the handle-level flags applied to this instance
+	virtual uint32_t getFlags(void) const override;
+
+	// Mask
+	//
+	// Gets the set of signals accepted by the handle
+	__declspec(property(get=getMask)) uint64_t Mask;
+	uint64_t getMask(void) const;
+
+	// WaitQueue (VirtualMachine::PollableHandle)
+	//
+	// Gets the wait queue that is notified when the signaled events change
+	virtual PollQueue* getWaitQueue(void) const override;
+
+private:
+
+	SignalFile(SignalFile const&)=delete;
+	SignalFile& operator=(SignalFile const&)=delete;
+
+	// signalfd_t
+	//
+	// Signal object shared among all handles
+	struct signalfd_t
+	{
+		sync::critical_section					lock;		// Synchronization object
+		uint64_t								mask;		// Accepted signals
+		std::deque<uapi_signalfd_siginfo>		pending;	// Queued signals
+		PollQueue								waitqueue;	// Wait queue
+	};
+
+	// Instance Constructor
+	//
+	SignalFile(std::shared_ptr<signalfd_t> const& signalfd, uint32_t flags);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	std::shared_ptr<signalfd_t> const	m_signalfd;		// Shared signal object
+	uint32_t const						m_flags;		// Handle-level flags
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __SIGNALFILE_H_
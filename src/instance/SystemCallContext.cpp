@@ -0,0 +1,108 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "SystemCallContext.h"
+
+#include "LinuxException.h"
+
+#pragma warning(push, 4)
+
+// SystemCallContext::s_tidpool (static)
+//
+// Thread identifier pool; the first allocated identifier (init) is 1
+IndexPool<int32_t> SystemCallContext::s_tidpool(1);
+
+//-----------------------------------------------------------------------------
+// SystemCallContext Constructor
+//
+// Creates the context for the main thread of a new process
+//
+// Arguments:
+//
+//	NONE
+
+SystemCallContext::SystemCallContext() : m_process(std::make_shared<process_t>(s_tidpool.Allocate())), m_tid(m_process->tgid)
+{
+	m_process->threads.fetch_add(1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallContext Constructor
+//
+// Creates the context for an additional thread of an existing process
+//
+// Arguments:
+//
+//	parent		- Context of any existing thread in the process
+
+SystemCallContext::SystemCallContext(SystemCallContext const* parent) : 
+	m_process((parent) ? parent->m_process : throw LinuxException(UAPI_EFAULT)), m_tid(s_tidpool.Allocate())
+{
+	m_process->threads.fetch_add(1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallContext Destructor
+
+SystemCallContext::~SystemCallContext()
+{
+	m_process->threads.fetch_sub(1, std::memory_order_relaxed);
+
+	// The thread group leader identifier is released with the process state, since
+	// it remains in use as the process identifier until all threads have detached
+	if(m_tid != m_process->tgid) s_tidpool.Release(m_tid);
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallContext::getProcessId
+//
+// Gets the virtual process (thread group) identifier
+
+int32_t SystemCallContext::getProcessId(void) const
+{
+	return m_process->tgid;
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallContext::getThreadCount
+//
+// Gets the number of threads attached to the process
+
+int32_t SystemCallContext::getThreadCount(void) const
+{
+	return m_process->threads.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallContext::getThreadId
+//
+// Gets the virtual thread identifier
+
+int32_t SystemCallContext::getThreadId(void) const
+{
+	return m_tid;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
@@ -0,0 +1,111 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __SYSTEMCALLCONTEXT_H_
+#define __SYSTEMCALLCONTEXT_H_
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "IndexPool.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// SystemCallContext
+//
+// Object referenced by a system call interface context handle.  Every guest thread
+// is assigned its own context so that RPC only serializes the exclusive calls made
+// by that same thread; state that applies to the entire process is shared between
+// all of the thread contexts and must be accessible without a process-wide lock
+
+class SystemCallContext
+{
+public:
+
+	// Instance Constructors
+	//
+	SystemCallContext();
+	SystemCallContext(SystemCallContext const* parent);
+
+	// Destructor
+	//
+	~SystemCallContext();
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// ProcessId
+	//
+	// Gets the virtual process (thread group) identifier
+	__declspec(property(get=getProcessId)) int32_t ProcessId;
+	int32_t getProcessId(void) const;
+
+	// ThreadCount
+	//
+	// Gets the number of threads attached to the process
+	__declspec(property(get=getThreadCount)) int32_t ThreadCount;
+	int32_t getThreadCount(void) const;
+
+	// ThreadId
+	//
+	// Gets the virtual thread identifier
+	__declspec(property(get=getThreadId)) int32_t ThreadId;
+	int32_t getThreadId(void) const;
+
+private:
+
+	SystemCallContext(SystemCallContext const&)=delete;
+	SystemCallContext& operator=(SystemCallContext const&)=delete;
+
+	// process_t
+	//
+	// Process-wide state shared among all thread contexts
+	struct process_t
+	{
+		// Instance Constructor
+		//
+		process_t(int32_t pid) : tgid(pid), threads(0) {}
+
+		// Destructor
+		//
+		~process_t() { s_tidpool.Release(tgid); }
+
+		int32_t const			tgid;			// Thread group identifier
+		std::atomic<int32_t>	threads;		// Number of attached threads
+	};
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	std::shared_ptr<process_t> const	m_process;		// Process-wide state
+	int32_t const						m_tid;			// Thread identifier
+
+	static IndexPool<int32_t>			s_tidpool;		// Thread identifier pool
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __SYSTEMCALLCONTEXT_H_
@@ -0,0 +1,304 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "SystemCallStatistics.h"
+
+#include <algorithm>
+#include <Win32Exception.h>
+
+#pragma warning(push, 4)
+
+// SystemCallStatistics::X64 (static)
+//
+// Statistics for the 64-bit system call interface
+SystemCallStatistics SystemCallStatistics::X64;
+
+// SystemCallStatistics::X86 (static)
+//
+// Statistics for the 32-bit system call interface
+SystemCallStatistics SystemCallStatistics::X86;
+
+//-----------------------------------------------------------------------------
+// GetTimestampFrequency (local)
+//
+// Gets the number of nanoseconds represented by a single performance counter tick
+//
+// Arguments:
+//
+//	NONE
+
+static double GetTimestampFrequency(void)
+{
+	LARGE_INTEGER				qpcfreq;		// QueryPerformanceCounter frequency
+
+	if(!QueryPerformanceFrequency(&qpcfreq)) throw Win32Exception{ GetLastError() };
+	return 1000000000.0 / static_cast<double>(qpcfreq.QuadPart);
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics Constructor
+//
+// Arguments:
+//
+//	NONE
+
+SystemCallStatistics::SystemCallStatistics() : m_tsfreq(GetTimestampFrequency())
+{
+	// Allocate a statistics table for every active processor in the system; the
+	// individual system call entries are allocated on first use
+	DWORD processors = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+	for(DWORD index = 0; index < processors; index++) {
+
+		auto processor = std::make_unique<processor_t>();
+		for(auto& entry : processor->entries) entry = nullptr;
+		m_processors.push_back(std::move(processor));
+	}
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics Destructor
+
+SystemCallStatistics::~SystemCallStatistics()
+{
+	for(auto& processor : m_processors)
+		for(auto& entry : processor->entries) delete entry.load();
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::BucketIndex (static)
+//
+// Gets the histogram bucket index for a latency value
+//
+// Arguments:
+//
+//	ns			- Latency value in nanoseconds
+
+size_t SystemCallStatistics::BucketIndex(uint64_t ns)
+{
+	size_t const subbuckets = (1 << SUBBUCKET_BITS);
+
+	// Values smaller than the number of sub-buckets are stored directly
+	if(ns < subbuckets) return static_cast<size_t>(ns);
+
+	// Find the most significant bit of the value to determine the power-of-two range
+	unsigned long msb = 0;
+#ifdef _M_X64
+	_BitScanReverse64(&msb, ns);
+#else
+	if(ns >> 32) { _BitScanReverse(&msb, static_cast<unsigned long>(ns >> 32)); msb += 32; }
+	else _BitScanReverse(&msb, static_cast<unsigned long>(ns));
+#endif
+
+	// The bucket is the power-of-two range plus the next SUBBUCKET_BITS below the msb
+	size_t shift = msb - SUBBUCKET_BITS;
+	size_t index = ((shift + 1) << SUBBUCKET_BITS) + static_cast<size_t>((ns >> shift) & (subbuckets - 1));
+
+	return std::min(index, HistogramBuckets - 1);
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::BucketLowerBound (static)
+//
+// Gets the lower bound, in nanoseconds, of a latency histogram bucket
+//
+// Arguments:
+//
+//	bucket		- Histogram bucket index
+
+uint64_t SystemCallStatistics::BucketLowerBound(size_t bucket)
+{
+	size_t const subbuckets = (1 << SUBBUCKET_BITS);
+
+	if(bucket < subbuckets) return bucket;
+
+	size_t shift = (bucket >> SUBBUCKET_BITS) - 1;
+	return static_cast<uint64_t>(subbuckets | (bucket & (subbuckets - 1))) << shift;
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::Enumerate
+//
+// Enumerates the aggregated statistics for all system calls that have been invoked
+//
+// Arguments:
+//
+//	func		- Function to invoke for each system call snapshot
+
+void SystemCallStatistics::Enumerate(std::function<void(size_t number, Snapshot const& snapshot)> func) const
+{
+	for(size_t number = 0; number < MaximumSystemCalls; number++) {
+
+		Snapshot snapshot = {};
+
+		// Aggregate the per-processor statistics for this system call
+		for(auto const& processor : m_processors) {
+
+			entry_t* entry = processor->entries[number].load(std::memory_order_acquire);
+			if(entry == nullptr) continue;
+
+			snapshot.name = entry->name.load(std::memory_order_relaxed);
+			snapshot.calls += entry->calls.load(std::memory_order_relaxed);
+			snapshot.errors += entry->errors.load(std::memory_order_relaxed);
+			snapshot.totalns += entry->totalns.load(std::memory_order_relaxed);
+			snapshot.maxns = std::max(snapshot.maxns, entry->maxns.load(std::memory_order_relaxed));
+
+			for(size_t index = 0; index < HistogramBuckets; index++)
+				snapshot.histogram[index] += entry->histogram[index].load(std::memory_order_relaxed);
+		}
+
+		if(snapshot.calls) func(number, snapshot);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::GetEntry (private)
+//
+// Gets (or allocates) the per-processor entry for a system call
+//
+// Arguments:
+//
+//	number		- System call number
+
+SystemCallStatistics::entry_t* SystemCallStatistics::GetEntry(size_t number)
+{
+	// The thread may migrate to another processor after this, which is harmless
+	// since all of the counters are atomic; the processor only serves to spread
+	// the updates across different cache lines
+	auto& processor = m_processors[GetCurrentProcessorNumber() % m_processors.size()];
+
+	entry_t* entry = processor->entries[number].load(std::memory_order_acquire);
+	if(entry != nullptr) return entry;
+
+	// Allocate and zero-initialize a new entry for this processor
+	auto allocated = std::make_unique<entry_t>();
+	allocated->name = nullptr;
+	allocated->calls = allocated->errors = allocated->totalns = allocated->maxns = 0;
+	for(auto& bucket : allocated->histogram) bucket = 0;
+
+	// Another thread on the same processor may have beaten this one to it
+	if(processor->entries[number].compare_exchange_strong(entry, allocated.get(), std::memory_order_acq_rel)) return allocated.release();
+	return entry;
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::Percentile (static)
+//
+// Calculates an approximate latency percentile (ns) from a snapshot histogram
+//
+// Arguments:
+//
+//	snapshot	- Aggregated system call statistics
+//	percentile	- Percentile to calculate (0.0 - 100.0)
+
+uint64_t SystemCallStatistics::Percentile(Snapshot const& snapshot, double percentile)
+{
+	if(snapshot.calls == 0) return 0;
+
+	// Determine how many samples need to be at or below the returned value
+	uint64_t threshold = static_cast<uint64_t>((std::min(std::max(percentile, 0.0), 100.0) / 100.0) * snapshot.calls);
+	uint64_t accumulated = 0;
+
+	for(size_t index = 0; index < HistogramBuckets; index++) {
+
+		accumulated += snapshot.histogram[index];
+		if((accumulated > 0) && (accumulated >= threshold)) return BucketLowerBound(index);
+	}
+
+	return snapshot.maxns;
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::Record
+//
+// Records a completed system call
+//
+// Arguments:
+//
+//	number		- System call number
+//	name		- System call name (must be a static string)
+//	elapsed		- Elapsed performance counter ticks
+//	error		- Flag indicating if the system call failed
+
+void SystemCallStatistics::Record(size_t number, char_t const* name, int64_t elapsed, bool error)
+{
+	_ASSERTE(number < MaximumSystemCalls);
+	if(number >= MaximumSystemCalls) return;
+
+	entry_t* entry = GetEntry(number);
+	uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(elapsed, 0) * m_tsfreq);
+
+	entry->name.store(name, std::memory_order_relaxed);
+	entry->calls.fetch_add(1, std::memory_order_relaxed);
+	if(error) entry->errors.fetch_add(1, std::memory_order_relaxed);
+	entry->totalns.fetch_add(ns, std::memory_order_relaxed);
+	entry->histogram[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+
+	// Update the maximum observed latency
+	uint64_t maxns = entry->maxns.load(std::memory_order_relaxed);
+	while((ns > maxns) && !entry->maxns.compare_exchange_weak(maxns, ns, std::memory_order_relaxed)) {}
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::Reset
+//
+// Resets all of the collected statistics
+//
+// Arguments:
+//
+//	NONE
+
+void SystemCallStatistics::Reset(void)
+{
+	for(auto& processor : m_processors) {
+
+		for(auto& slot : processor->entries) {
+
+			entry_t* entry = slot.load(std::memory_order_acquire);
+			if(entry == nullptr) continue;
+
+			entry->calls = entry->errors = entry->totalns = entry->maxns = 0;
+			for(auto& bucket : entry->histogram) bucket = 0;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics::Timestamp (private, static)
+//
+// Gets the current performance counter value
+//
+// Arguments:
+//
+//	NONE
+
+int64_t SystemCallStatistics::Timestamp(void)
+{
+	LARGE_INTEGER				qpc;			// QueryPerformanceCounter value
+
+	QueryPerformanceCounter(&qpc);
+	return qpc.QuadPart;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
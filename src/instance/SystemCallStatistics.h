@@ -0,0 +1,201 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __SYSTEMCALLSTATISTICS_H_
+#define __SYSTEMCALLSTATISTICS_H_
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <text.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// SystemCallStatistics
+//
+// Collects per-system call invocation counters and latency histograms.  Counters
+// are maintained per-processor to avoid cache line contention between threads and
+// are only aggregated when a snapshot is requested.  Latency histograms use a
+// log-linear bucket layout (HDR style) with four sub-buckets per power of two
+
+class SystemCallStatistics
+{
+public:
+
+	// Instance Constructor
+	//
+	SystemCallStatistics();
+
+	// Destructor
+	//
+	~SystemCallStatistics();
+
+	//-------------------------------------------------------------------------
+	// Fields
+
+	// HistogramBuckets
+	//
+	// Number of latency histogram buckets maintained per system call
+	static size_t const HistogramBuckets = 160;
+
+	// MaximumSystemCalls
+	//
+	// Maximum system call number that can be tracked
+	static size_t const MaximumSystemCalls = 512;
+
+	// X64
+	//
+	// Statistics for the 64-bit system call interface
+	static SystemCallStatistics X64;
+
+	// X86
+	//
+	// Statistics for the 32-bit system call interface
+	static SystemCallStatistics X86;
+
+	//-------------------------------------------------------------------------
+	// Data Types
+
+	// Snapshot
+	//
+	// Aggregated statistics for a single system call
+	struct Snapshot
+	{
+		char_t const*							name;			// System call name
+		uint64_t								calls;			// Number of calls
+		uint64_t								errors;			// Number of failed calls
+		uint64_t								totalns;		// Total latency (ns)
+		uint64_t								maxns;			// Maximum latency (ns)
+		std::array<uint64_t, HistogramBuckets>	histogram;		// Latency histogram
+	};
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// BucketIndex (static)
+	//
+	// Gets the histogram bucket index for a latency value
+	static size_t BucketIndex(uint64_t ns);
+
+	// BucketLowerBound (static)
+	//
+	// Gets the lower bound, in nanoseconds, of a latency histogram bucket
+	static uint64_t BucketLowerBound(size_t bucket);
+
+	// Enumerate
+	//
+	// Enumerates the aggregated statistics for all system calls that have been invoked
+	void Enumerate(std::function<void(size_t number, Snapshot const& snapshot)> func) const;
+
+	// Invoke
+	//
+	// Invokes a system call handler and records the statistics for it
+	template<typename _func>
+	long Invoke(size_t number, char_t const* name, _func func)
+	{
+		int64_t start = Timestamp();
+
+		try {
+
+			long result = func();
+			Record(number, name, Timestamp() - start, (result < 0));
+			return result;
+		}
+
+		catch(...) { Record(number, name, Timestamp() - start, true); throw; }
+	}
+
+	// Percentile
+	//
+	// Calculates an approximate latency percentile (ns) from a snapshot histogram
+	static uint64_t Percentile(Snapshot const& snapshot, double percentile);
+
+	// Record
+	//
+	// Records a completed system call
+	void Record(size_t number, char_t const* name, int64_t elapsed, bool error);
+
+	// Reset
+	//
+	// Resets all of the collected statistics
+	void Reset(void);
+
+private:
+
+	SystemCallStatistics(SystemCallStatistics const&)=delete;
+	SystemCallStatistics& operator=(SystemCallStatistics const&)=delete;
+
+	// entry_t
+	//
+	// Per-processor statistics for a single system call
+	struct alignas(64) entry_t
+	{
+		std::atomic<char_t const*>	name;							// System call name
+		std::atomic<uint64_t>		calls;							// Number of calls
+		std::atomic<uint64_t>		errors;							// Number of failed calls
+		std::atomic<uint64_t>		totalns;						// Total latency (ns)
+		std::atomic<uint64_t>		maxns;							// Maximum latency (ns)
+		std::atomic<uint64_t>		histogram[HistogramBuckets];	// Latency histogram
+	};
+
+	// processor_t
+	//
+	// Per-processor table of system call statistics entries
+	struct processor_t
+	{
+		std::atomic<entry_t*>		entries[MaximumSystemCalls];	// Lazily allocated
+	};
+
+	// SUBBUCKET_BITS
+	//
+	// Number of bits of precision within each power-of-two histogram range
+	static size_t const SUBBUCKET_BITS = 2;
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// GetEntry
+	//
+	// Gets (or allocates) the per-processor entry for a system call
+	entry_t* GetEntry(size_t number);
+
+	// Timestamp (static)
+	//
+	// Gets the current performance counter value
+	static int64_t Timestamp(void);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	double const								m_tsfreq;		// Nanoseconds per tick
+	std::vector<std::unique_ptr<processor_t>>	m_processors;	// Per-processor statistics
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __SYSTEMCALLSTATISTICS_H_
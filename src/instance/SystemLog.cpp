@@ -27,8 +27,15 @@
 #include <SystemInformation.h>
 #include <Win32Exception.h>
 
+#include "Tracepoint.h"
+
 #pragma warning(push, 4)
 
+// s_syslogwrite (local)
+//
+// Fired when an entry is written into the system log (facility, level, length)
+static Tracepoint s_syslogwrite{ "syslog:write" };
+
 //-----------------------------------------------------------------------------
 // SystemLog Constructor
 //
@@ -49,7 +56,7 @@ SystemLog::SystemLog(size_t size) : SystemLog(size, VirtualMachine::LogLevel::Wa
 //	defaultlevel	- Default message logging level
 
 SystemLog::SystemLog(size_t size, VirtualMachine::LogLevel defaultlevel) : m_tsfreq(GetTimestampFrequency()), 
-	m_tsbias(GetTimestampBias()), m_defaultlevel(defaultlevel), m_stdout(GetStdHandle(STD_OUTPUT_HANDLE))
+	m_tsbias(GetTimestampBias()), m_defaultlevel(defaultlevel), m_stdout(GetStdHandle(STD_OUTPUT_HANDLE)), m_lock("SystemLog::m_lock")
 {
 	// Minimum log size is the page size, maximum is constant MAX_BUFFER
 	size = std::min(std::max(size, SystemInformation::PageSize), MAX_BUFFER);
@@ -170,6 +177,8 @@ void SystemLog::WriteEntry(uint8_t facility, VirtualMachine::LogLevel level, cha
 	static const char	crlf[] ={ '\r', '\n' };		// CRLF pair for STDOUT output
 	DWORD				cch;						// Characters written to STDOUT
 
+	s_syslogwrite.Fire(facility, static_cast<uint64_t>(level), length);
+
 	length = std::min(length, MAX_MESSAGE);			// Truncate if > MAX_MESSAGE
 
 	// Determine the overall aligned length of the log entry, must be <= 64KiB
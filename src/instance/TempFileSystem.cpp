@@ -24,15 +24,31 @@
 #include "TempFileSystem.h"
 
 #include <align.h>
+#include <coarseclock.h>
 #include <convert.h>
+#include <mutex>
+#include <numeric>
 #include <SystemInformation.h>
 #include <Win32Exception.h>
 
+#include "DirectoryEntryBuffer.h"
 #include "LinuxException.h"
 #include "MountOptions.h"
+#include "Tracepoint.h"
 
 #pragma warning(push, 4)
 
+//-----------------------------------------------------------------------------
+// Tracepoints
+//
+// Fired on entry to the file handle operations (handle, offset, count)
+//-----------------------------------------------------------------------------
+
+static Tracepoint s_tmpfsread{ "tmpfs:read" };
+static Tracepoint s_tmpfssetlength{ "tmpfs:set_length" };
+static Tracepoint s_tmpfssync{ "tmpfs:sync" };
+static Tracepoint s_tmpfswrite{ "tmpfs:write" };
+
 // g_maxmemory (local)
 //
 // The maximum amount of memory available to this process
@@ -88,6 +104,45 @@ size_t ParseScaledInteger(std::string const& str)
 	return static_cast<size_t>(interim);
 }
 
+//---------------------------------------------------------------------------
+// CloneTempFileSystem
+//
+// Creates a copy-on-write clone of a TempFileSystem instance; the source file
+// system is frozen as read-only so that it can be shared with the clone
+//
+// Arguments:
+//
+//	source		- Mount point of the file system to be cloned
+//	flags		- Standard mounting option flags for the clone
+
+std::unique_ptr<VirtualMachine::Mount> CloneTempFileSystem(VirtualMachine::Mount const* source, uint32_t flags)
+{
+	if(source == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	// Verify that the specified flags are supported for a creation operation
+	if(flags & ~TempFileSystem::MOUNT_FLAGS) throw LinuxException(UAPI_EINVAL);
+
+	// The source must be a TempFileSystem mount point
+	auto origin = dynamic_cast<TempFileSystem*>(source->FileSystem);
+	auto rootdir = dynamic_cast<TempFileSystem::Directory const*>(source->RootNode);
+	if((origin == nullptr) || (rootdir == nullptr)) throw LinuxException(UAPI_EINVAL);
+
+	// Freeze the source file system; the nodes and data shared with the clone cannot change 
+	// after this point.  Writes through handles that are already open fail with EROFS
+	origin->Flags |= UAPI_MS_RDONLY;
+
+	// Construct the shared file system instance with the same limits as the source
+	auto fs = std::make_shared<TempFileSystem>(flags & ~UAPI_MS_PERMOUNT_MASK);
+	fs->MaximumSize = static_cast<size_t>(origin->MaximumSize);
+	fs->MaximumNodes = static_cast<size_t>(origin->MaximumNodes);
+
+	// Only the root directory is cloned here, everything beneath it is cloned on demand
+	auto clonedroot = std::dynamic_pointer_cast<TempFileSystem::directory_node_t>(TempFileSystem::CloneNode(fs, rootdir->m_node));
+
+	// Create and return the mount point instance with an O_PATH handle against the root directory
+	return std::make_unique<TempFileSystem::Mount>(fs, std::make_unique<TempFileSystem::Directory>(clonedroot), flags & UAPI_MS_PERMOUNT_MASK);
+}
+
 //---------------------------------------------------------------------------
 // MountTempFileSystem
 //
@@ -185,6 +240,30 @@ std::unique_ptr<VirtualMachine::Mount> MountTempFileSystem(char_t const* source,
 	return std::make_unique<TempFileSystem::Mount>(fs, std::make_unique<TempFileSystem::Directory>(rootdir), options.Flags & UAPI_MS_PERMOUNT_MASK);
 }
 
+//---------------------------------------------------------------------------
+// SealTempFileSystem
+//
+// Seals a TempFileSystem directory subtree into immutable lookup tables, returns
+// the number of directories that were sealed
+//
+// Arguments:
+//
+//	mount		- Mount point on which to perform the operation
+//	directory	- Directory node at the top of the subtree to be sealed
+
+size_t SealTempFileSystem(VirtualMachine::Mount const* mount, VirtualMachine::Node const* directory)
+{
+	if(mount == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(directory == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	// The node must be a directory that belongs to the mounted file system
+	auto dir = dynamic_cast<TempFileSystem::Directory const*>(directory);
+	if(dir == nullptr) throw LinuxException(UAPI_ENOTDIR);
+	if(mount->FileSystem != dir->m_node->fs.get()) throw LinuxException(UAPI_EXDEV);
+
+	return dir->m_node->seal();
+}
+
 //---------------------------------------------------------------------------
 // TempFileSystem Constructor
 //
@@ -192,7 +271,8 @@ std::unique_ptr<VirtualMachine::Mount> MountTempFileSystem(char_t const* source,
 //
 //	flags		- Initial file system level flags
 
-TempFileSystem::TempFileSystem(uint32_t flags) : Flags(flags), m_heap(nullptr), m_heapsize(0)
+TempFileSystem::TempFileSystem(uint32_t flags) : Flags(flags), m_heap(nullptr), m_heapsize(0), m_heappeak(0), m_heapallocs(0), m_heaplock("TempFileSystem::m_heaplock"),
+	m_renamelock("TempFileSystem::m_renamelock"), m_clonelock("TempFileSystem::m_clonelock")
 {
 	// The specified flags should not include any that apply to the mount point
 	_ASSERTE((flags & UAPI_MS_PERMOUNT_MASK) == 0);
@@ -238,9 +318,114 @@ void* TempFileSystem::AllocateHeap(size_t bytecount, bool zeroinit)
 	if(ptr == nullptr) throw LinuxException(UAPI_ENOMEM);
 
 	m_heapsize += bytecount;		// Add to the allocated memory count
+	++m_heapallocs;					// Count the allocation
+
+	if(m_heapsize > m_heappeak) m_heappeak = m_heapsize.load();
+
 	return ptr;						// Return the allocated heap pointer
 }
 
+//---------------------------------------------------------------------------
+// TempFileSystem::CloneNode (private, static)
+//
+// Creates a clone of a node from a frozen file system
+//
+// Arguments:
+//
+//	fs			- File system in which to create the cloned node
+//	origin		- Node to be cloned
+
+std::shared_ptr<TempFileSystem::node_t> TempFileSystem::CloneNode(std::shared_ptr<TempFileSystem> const& fs, std::shared_ptr<node_t> const& origin)
+{
+	std::shared_ptr<node_t>		clone;			// Cloned node instance
+
+	_ASSERTE(origin);
+	_ASSERTE(origin->fs->Flags & UAPI_MS_RDONLY);
+
+	// Directories have a single parent and only ever get cloned once
+	if((origin->mode & UAPI_S_IFMT) == UAPI_S_IFDIR) {
+
+		auto dir = directory_node_t::allocate_shared(fs, origin->mode, origin->uid, origin->gid);
+		dir->origin = std::dynamic_pointer_cast<directory_node_t>(origin);
+		dir->cloned = true;
+		clone = dir;
+	}
+
+	else {
+
+		sync::critical_section::scoped_lock cs(fs->m_clonelock);
+
+		// Reuse the existing clone if this node has already been reached through another link
+		auto found = fs->m_clones.find(origin);
+		if(found != fs->m_clones.end()) {
+
+			clone = found->second.lock();
+			if(clone) return clone;
+		}
+
+		switch(origin->mode & UAPI_S_IFMT) {
+
+			// Files share the origin data until they are written to; if the origin is itself an
+			// undiverged clone, share the data of its origin instead
+			case UAPI_S_IFREG: {
+
+				auto file = file_node_t::allocate_shared(fs, origin->mode, origin->uid, origin->gid);
+				auto originfile = std::dynamic_pointer_cast<file_node_t>(origin);
+
+				sync::reader_writer_lock::scoped_lock_read reader(originfile->datalock);
+				file->origin = (originfile->origin) ? originfile->origin : originfile;
+				clone = file;
+			}
+			break;
+
+			// Symbolic link targets cannot change, they are copied rather than shared
+			case UAPI_S_IFLNK:
+				clone = symlink_node_t::allocate_shared(fs, std::dynamic_pointer_cast<symlink_node_t>(origin)->target.c_str(), origin->uid, origin->gid);
+				break;
+
+			default: throw LinuxException(UAPI_ENXIO);
+		}
+
+		fs->m_clones[origin] = clone;
+	}
+
+	// The clone starts with the same timestamps as the origin node
+	auto times = origin->get_times();
+	clone->set_times(&times.atime, &times.ctime, &times.mtime);
+
+	return clone;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::getHeapAllocations
+//
+// Gets the total number of allocations made from the private heap
+
+uint64_t TempFileSystem::getHeapAllocations(void) const
+{
+	return m_heapallocs;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::getHeapUsage
+//
+// Gets the number of bytes currently allocated from the private heap
+
+size_t TempFileSystem::getHeapUsage(void) const
+{
+	return m_heapsize;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::getPeakHeapUsage
+//
+// Gets the largest number of bytes allocated from the private heap at once
+
+size_t TempFileSystem::getPeakHeapUsage(void) const
+{
+	return m_heappeak;
+}
+
 //---------------------------------------------------------------------------
 // TempFileSystem::ReallocateHeap (private)
 //
@@ -273,6 +458,8 @@ void* TempFileSystem::ReallocateHeap(void* ptr, size_t bytecount, bool zeroinit)
 	if(bytecount > oldcount) m_heapsize += (bytecount - oldcount);
 	else if(bytecount < oldcount) m_heapsize -= (oldcount - bytecount);
 
+	if(m_heapsize > m_heappeak) m_heappeak = m_heapsize.load();
+
 	return newptr;
 }
 
@@ -316,13 +503,13 @@ void TempFileSystem::ReleaseHeap(void* ptr)
 //	groupid			- Initial owner GID to assign to the node
 
 TempFileSystem::node_t::node_t(std::shared_ptr<TempFileSystem> const& filesystem, uapi_mode_t nodemode, uapi_uid_t userid, uapi_gid_t groupid) : 
-	fs(filesystem), index(filesystem->NodeIndexPool.Allocate()), mode(nodemode), uid(userid), gid(groupid)
+	fs(filesystem), index(filesystem->NodeIndexPool.Allocate()), mode(nodemode), uid(userid), gid(groupid), m_timesseq(0)
 {
 	_ASSERTE(fs);
 
 	// Set the access time, change time and modification time to now
-	uapi_timespec now = convert<uapi_timespec>(datetime::now());
-	atime = ctime = mtime = now;
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_times = { now, now, now };
 }
 
 //---------------------------------------------------------------------------
@@ -334,6 +521,58 @@ TempFileSystem::node_t::~node_t()
 	fs->NodeIndexPool.Release(index);
 }
 
+//---------------------------------------------------------------------------
+// TempFileSystem::node_t::get_times
+//
+// Gets a consistent snapshot of the node timestamps without locking
+//
+// Arguments:
+//
+//	NONE
+
+TempFileSystem::node_t::times_t TempFileSystem::node_t::get_times(void) const
+{
+	while(true) {
+
+		// An odd sequence number indicates that a writer is updating the timestamps
+		uint32_t sequence = m_timesseq.load(std::memory_order_acquire);
+		if(sequence & 1) { YieldProcessor(); continue; }
+
+		times_t times = m_times;
+
+		// If the sequence number has not changed the snapshot is consistent
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(m_timesseq.load(std::memory_order_relaxed) == sequence) return times;
+	}
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::node_t::set_times
+//
+// Updates the node timestamps; null pointers leave a timestamp unchanged
+//
+// Arguments:
+//
+//	atime			- New access time or nullptr
+//	ctime			- New change time or nullptr
+//	mtime			- New modification time or nullptr
+
+void TempFileSystem::node_t::set_times(uapi_timespec const* atime, uapi_timespec const* ctime, uapi_timespec const* mtime)
+{
+	// Writers serialize by moving the sequence number from even to odd
+	uint32_t sequence = m_timesseq.load(std::memory_order_relaxed);
+	while((sequence & 1) || (!m_timesseq.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire))) {
+
+		if(sequence & 1) { YieldProcessor(); sequence = m_timesseq.load(std::memory_order_relaxed); }
+	}
+
+	if(atime) m_times.atime = *atime;
+	if(ctime) m_times.ctime = *ctime;
+	if(mtime) m_times.mtime = *mtime;
+
+	m_timesseq.store(sequence + 2, std::memory_order_release);
+}
+
 //---------------------------------------------------------------------------
 // TempFileSystem::Node::touch_atime
 //
@@ -348,7 +587,8 @@ uapi_timespec TempFileSystem::node_t::touch_atime(uapi_timespec accesstime, uint
 {
 	bool update = false;							// Flag to actually change the atime
 
-	uapi_timespec current = atime;					// Get the current node access time
+	times_t times = get_times();					// Get the current node timestamps
+	uapi_timespec current = times.atime;			// Get the current node access time
 
 	// MS_NOATIME on the mount or UTIME_OMIT on the timestamp -- do nothing
 	if((mountflags & UAPI_MS_NOATIME) == UAPI_MS_NOATIME) return current;
@@ -358,7 +598,7 @@ uapi_timespec TempFileSystem::node_t::touch_atime(uapi_timespec accesstime, uint
 	if(((mode & UAPI_S_IFMT) == UAPI_S_IFDIR) && ((mountflags & UAPI_MS_NODIRATIME) == UAPI_MS_NODIRATIME)) return current;
 
 	// If UTIME_NOW has been specified, use the current date/time otherwise convert the provided timespec
-	datetime newatime = (accesstime.tv_nsec == UAPI_UTIME_NOW) ? datetime::now() : convert<datetime>(accesstime);
+	datetime newatime = (accesstime.tv_nsec == UAPI_UTIME_NOW) ? coarseclock::now() : convert<datetime>(accesstime);
 
 	// Update atime if previous atime is more than 24 hours in the past (see mount(2))
 	if(newatime > (convert<datetime>(current) + timespan::days(1))) update = true;
@@ -367,11 +607,11 @@ uapi_timespec TempFileSystem::node_t::touch_atime(uapi_timespec accesstime, uint
 	else if((mountflags & UAPI_MS_STRICTATIME) == UAPI_MS_STRICTATIME) update = true;
 
 	// Default (MS_RELATIME) - update atime if it is more recent than ctime or mtime
-	else if((newatime >= convert<datetime>(ctime.load())) || (newatime >= convert<datetime>(mtime.load()))) update = true;
+	else if((newatime >= convert<datetime>(times.ctime)) || (newatime >= convert<datetime>(times.mtime))) update = true;
 
 	// Convert from a datetime back into a timespec and update the node timestamp
 	current = convert<uapi_timespec>(newatime);
-	if(update) atime = current;
+	if(update) set_times(&current, nullptr, nullptr);
 
 	return current;
 }
@@ -391,7 +631,8 @@ uapi_timespec TempFileSystem::node_t::touch_atime(uapi_timespec accesstime, uint
 //	groupid			- Initial owner GID to assign to the node
 
 TempFileSystem::directory_node_t::directory_node_t(std::shared_ptr<TempFileSystem> const& filesystem, uapi_mode_t nodemode, uapi_uid_t userid, uapi_gid_t groupid) :
-	node_t(filesystem, nodemode, userid, groupid), nodes(allocator_t<nodemap_t>(filesystem))
+	node_t(filesystem, nodemode, userid, groupid), nodes(allocator_t<nodemap_t>(filesystem)), nodeslock("TempFileSystem::nodeslock"), cloned(false), sealed(nullptr),
+	m_sealtables(allocator_t<std::shared_ptr<sealed_t>>(filesystem))
 {
 }
 
@@ -415,6 +656,359 @@ std::shared_ptr<TempFileSystem::directory_node_t> TempFileSystem::directory_node
 	return std::allocate_shared<directory_node_t, allocator_t<directory_node_t>>(allocator_t<directory_node_t>(fs), fs, mode, uid, gid);
 }
 
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::contains
+//
+// Determines if a node is this directory or is located anywhere beneath it
+//
+// Arguments:
+//
+//	node			- Node to be located
+
+bool TempFileSystem::directory_node_t::contains(node_t const* node)
+{
+	std::vector<std::shared_ptr<directory_node_t>>	pending;	// Directories left to search
+
+	if(node == nullptr) return false;
+	if(node == this) return true;
+
+	// Searches a single directory, queueing up any child directories; only one
+	// directory lock is ever held at a time while the tree is being walked
+	auto search = [&](directory_node_t* dir) -> bool {
+
+		sync::distributed_reader_writer_lock::scoped_lock_read reader(dir->nodeslock);
+		for(auto const& iterator : dir->nodes) {
+
+			if(iterator.second.get() == node) return true;
+			if((iterator.second->mode & UAPI_S_IFMT) == UAPI_S_IFDIR) pending.push_back(std::dynamic_pointer_cast<directory_node_t>(iterator.second));
+		}
+
+		return false;
+	};
+
+	if(search(this)) return true;
+
+	while(!pending.empty()) {
+
+		auto dir = std::move(pending.back());
+		pending.pop_back();
+
+		if(search(dir.get())) return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::cookie (static)
+//
+// Generates the stable enumeration cookie for a child node name
+//
+// Arguments:
+//
+//	name			- Child node name
+
+size_t TempFileSystem::directory_node_t::cookie(std::string const& name)
+{
+	// The cookie is derived from the name hash rather than an ordinal position so that it
+	// remains valid as other entries are added and removed; zero is the start position
+	// and the value must remain positive when reported to the caller as an offset
+	size_t hash = (std::hash<std::string>()(name) & COOKIE_END);
+	return (hash == 0) ? 1 : hash;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::entries
+//
+// Gets up to count child entries positioned after a cookie, in cookie order
+//
+// Arguments:
+//
+//	lock			- Reference to the held nodeslock
+//	position		- Cookie after which to begin returning entries
+//	count			- Maximum number of sorted entries to return
+//	result			- Receives the entries; entries beyond count are not sorted
+
+void TempFileSystem::directory_node_t::entries(sync::distributed_reader_writer_lock::scoped_lock& lock, size_t position, size_t count, std::vector<entry_t>& result) const
+{
+	UNREFERENCED_PARAMETER(lock);
+
+	result.clear();
+	result.reserve(nodes.size());
+
+	for(auto const& iterator : nodes) {
+
+		size_t entrycookie = cookie(iterator.first);
+		if(entrycookie > position) result.emplace_back(entrycookie, &iterator);
+	}
+
+	// Entries are ordered by cookie and then by name should any cookies collide; only the
+	// number of entries that the caller can actually consume need to be sorted
+	auto compare = [](entry_t const& lhs, entry_t const& rhs) -> bool {
+
+		if(lhs.first != rhs.first) return lhs.first < rhs.first;
+		return lhs.second->first < rhs.second->first;
+	};
+
+	std::partial_sort(result.begin(), result.begin() + std::min(count, result.size()), result.end(), compare);
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::materialize
+//
+// Populates a cloned directory with clones of the origin directory child nodes
+//
+// Arguments:
+//
+//	NONE
+
+void TempFileSystem::directory_node_t::materialize(void)
+{
+	// Directories that were not cloned or have already been materialized have nothing to do
+	if(!cloned.load(std::memory_order_acquire)) return;
+
+	sync::distributed_reader_writer_lock::scoped_lock_write writer(nodeslock);
+	if(!origin) return;
+
+	// The origin directory may itself be a clone that has not been materialized yet; its
+	// file system is frozen so nothing else can change it once it has been
+	origin->materialize();
+
+	// Child nodes that already exist were cloned by an earlier attempt that failed part way
+	sync::distributed_reader_writer_lock::scoped_lock_read reader(origin->nodeslock);
+	for(auto const& iterator : origin->nodes)
+		if(nodes.find(iterator.first) == nodes.end()) nodes.emplace(iterator.first, CloneNode(fs, iterator.second));
+	reader.unlock();
+
+	origin.reset();
+	cloned.store(false, std::memory_order_release);
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::seal
+//
+// Seals this directory and every directory beneath it, returns the number sealed
+//
+// Arguments:
+//
+//	NONE
+
+size_t TempFileSystem::directory_node_t::seal(void)
+{
+	std::vector<std::shared_ptr<directory_node_t>>	pending;	// Directories left to seal
+	size_t											count = 0;	// Number of sealed directories
+
+	// Seals a single directory, queueing up any child directories; only one directory
+	// lock is ever held at a time while the tree is being walked
+	auto sealdir = [&](directory_node_t* dir) -> void {
+
+		dir->materialize();
+
+		sync::distributed_reader_writer_lock::scoped_lock_write writer(dir->nodeslock);
+		for(auto const& iterator : dir->nodes)
+			if((iterator.second->mode & UAPI_S_IFMT) == UAPI_S_IFDIR) pending.push_back(std::dynamic_pointer_cast<directory_node_t>(iterator.second));
+
+		// Any change to the directory discards the table, so an existing one is still current
+		if(dir->sealed.load(std::memory_order_relaxed) == nullptr) {
+
+			auto table = std::allocate_shared<sealed_t, allocator_t<sealed_t>>(allocator_t<sealed_t>(dir->fs), dir->fs, dir->nodes);
+			dir->m_sealtables.push_back(table);
+			dir->sealed.store(table.get(), std::memory_order_release);
+		}
+
+		count++;
+	};
+
+	sealdir(this);
+
+	while(!pending.empty()) {
+
+		auto dir = std::move(pending.back());
+		pending.pop_back();
+
+		sealdir(dir.get());
+	}
+
+	return count;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::unseal
+//
+// Discards the sealed lookup table; nodeslock must be held for exclusive access
+//
+// Arguments:
+//
+//	NONE
+
+void TempFileSystem::directory_node_t::unseal(void)
+{
+	// The table itself is kept alive until this directory is destroyed; a lookup that loaded 
+	// the pointer before it was cleared may still be reading from it
+	sealed.store(nullptr, std::memory_order_release);
+}
+
+//
+// TEMPFILESYSTEM::DIRECTORY_NODE_T::SEALED_T IMPLEMENTATION
+//
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::sealed_t Constructor
+//
+// Arguments:
+//
+//	filesystem		- Shared file system instance
+//	nodes			- Child node collection to be sealed; must be locked
+
+TempFileSystem::directory_node_t::sealed_t::sealed_t(std::shared_ptr<TempFileSystem> const& filesystem, nodemap_t const& nodes) :
+	m_seeds(allocator_t<uint32_t>(filesystem)), m_slots(allocator_t<slot_t>(filesystem)), m_names(allocator_t<char_t>(filesystem))
+{
+	std::vector<nodemap_t::value_type const*>	entries;		// Child node entries
+	std::vector<std::vector<size_t>>			buckets;		// Entries assigned to each bucket
+	std::vector<size_t>							order;			// Bucket placement order
+	std::vector<size_t>							assigned;		// Slot assigned to each entry
+	std::vector<uint32_t>						seeds;			// Seed assigned to each bucket
+
+	if(nodes.empty()) return;
+
+	entries.reserve(nodes.size());
+	for(auto const& iterator : nodes) entries.push_back(&iterator);
+
+	// Hash and displace: each name is assigned to a bucket by its unseeded hash, then each bucket
+	// is given the first seed that places all of its names into unoccupied slots.  Buckets hold
+	// two names on average and are placed largest first since those are the hardest to place
+	buckets.resize((entries.size() + 1) >> 1);
+	for(size_t index = 0; index < entries.size(); index++) 
+		buckets[hash(entries[index]->first.data(), entries[index]->first.length(), 0) % buckets.size()].push_back(index);
+
+	order.resize(buckets.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) -> bool { return buckets[lhs].size() > buckets[rhs].size(); });
+
+	assigned.resize(entries.size());
+	size_t slotcount = entries.size();
+
+	// A minimal table (one slot per name) is attempted first; if a bucket cannot be placed
+	// within MAX_SEED attempts the table is grown slightly and the placement starts over
+	while(true) {
+
+		std::vector<bool>		occupied(slotcount, false);		// Slots already assigned
+		std::vector<size_t>		candidates;						// Slots for the current bucket
+		bool					placed = true;					// Flag if all buckets were placed
+
+		seeds.assign(buckets.size(), 0);
+
+		for(auto bucket : order) {
+
+			auto const& members = buckets[bucket];
+			if(members.empty()) break;
+
+			uint32_t seed = 1;
+			for(; seed < MAX_SEED; seed++) {
+
+				candidates.clear();
+				for(auto member : members) {
+
+					size_t slot = static_cast<size_t>(hash(entries[member]->first.data(), entries[member]->first.length(), seed) % slotcount);
+					if(occupied[slot] || (std::find(candidates.begin(), candidates.end(), slot) != candidates.end())) break;
+					candidates.push_back(slot);
+				}
+
+				if(candidates.size() == members.size()) break;
+			}
+
+			if(seed == MAX_SEED) { placed = false; break; }
+
+			seeds[bucket] = seed;
+			for(size_t index = 0; index < members.size(); index++) {
+
+				occupied[candidates[index]] = true;
+				assigned[members[index]] = candidates[index];
+			}
+		}
+
+		if(placed) break;
+		slotcount += (slotcount >> 3) + 1;
+	}
+
+	// Copy the seeds and the densely packed slots and names onto the file system heap
+	m_seeds.assign(seeds.begin(), seeds.end());
+	m_slots.resize(slotcount);
+
+	size_t namelength = 0;
+	for(auto const& entry : entries) namelength += entry->first.length();
+	m_names.reserve(namelength);
+
+	for(size_t index = 0; index < entries.size(); index++) {
+
+		slot_t& slot = m_slots[assigned[index]];
+		slot.offset = static_cast<uint32_t>(m_names.size());
+		slot.length = static_cast<uint32_t>(entries[index]->first.length());
+		slot.node = entries[index]->second;
+
+		m_names.insert(m_names.end(), entries[index]->first.begin(), entries[index]->first.end());
+	}
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::sealed_t::find
+//
+// Locates a child node by name; returns an empty pointer if not found
+//
+// Arguments:
+//
+//	name			- Name of the child node to locate
+
+std::shared_ptr<TempFileSystem::node_t> TempFileSystem::directory_node_t::sealed_t::find(char_t const* name) const
+{
+	_ASSERTE(name);
+	if(m_slots.empty()) return nullptr;
+
+	size_t length = strlen(name);
+
+	// A zero seed indicates an empty bucket, no names hash to it
+	uint32_t seed = m_seeds[static_cast<size_t>(hash(name, length, 0) % m_seeds.size())];
+	if(seed == 0) return nullptr;
+
+	// Every sealed name has a unique slot but any other name also maps to one of them, so
+	// the name in the slot must still be compared
+	slot_t const& slot = m_slots[static_cast<size_t>(hash(name, length, seed) % m_slots.size())];
+	if((slot.length != length) || (memcmp(m_names.data() + slot.offset, name, length) != 0)) return nullptr;
+
+	// The node may have since been unlinked after the table was discarded
+	return slot.node.lock();
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::directory_node_t::sealed_t::hash (private, static)
+//
+// Generates a seeded hash of a child node name
+//
+// Arguments:
+//
+//	name			- Child node name; need not be null terminated
+//	length			- Length of the child node name
+//	seed			- Seed value
+
+uint64_t TempFileSystem::directory_node_t::sealed_t::hash(char_t const* name, size_t length, uint32_t seed)
+{
+	// 64-bit FNV-1a, with the seed mixed into the offset basis
+	uint64_t result = 14695981039346656037ui64 ^ (seed * 0x9E3779B97F4A7C15ui64);
+	for(size_t index = 0; index < length; index++) {
+
+		result ^= static_cast<uint8_t>(name[index]);
+		result *= 1099511628211ui64;
+	}
+
+	// FNV-1a alone leaves hashes for different seeds too closely related for the displacement
+	// search to converge quickly; finish with the splitmix64 avalanche
+	result ^= (result >> 30);
+	result *= 0xBF58476D1CE4E5B9ui64;
+	result ^= (result >> 27);
+	result *= 0x94D049BB133111EBui64;
+	return result ^ (result >> 31);
+}
+
 //
 // TEMPFILESYSTEM::FILE_NODE_T IMPLEMENTATION
 //
@@ -430,7 +1024,7 @@ std::shared_ptr<TempFileSystem::directory_node_t> TempFileSystem::directory_node
 //	groupid			- Initial owner GID to assign to the node
 
 TempFileSystem::file_node_t::file_node_t(std::shared_ptr<TempFileSystem> const& filesystem, uapi_mode_t nodemode, uapi_uid_t userid, uapi_gid_t groupid) :
-	node_t(filesystem, nodemode, userid, groupid), data(allocator_t<uint8_t>(filesystem))
+	node_t(filesystem, nodemode, userid, groupid), data(allocator_t<uint8_t>(filesystem)), datalock("TempFileSystem::datalock")
 {
 }
 
@@ -454,6 +1048,44 @@ std::shared_ptr<TempFileSystem::file_node_t> TempFileSystem::file_node_t::alloca
 	return std::allocate_shared<file_node_t, allocator_t<file_node_t>>(allocator_t<file_node_t>(fs), fs, mode, uid, gid);
 }
 
+//---------------------------------------------------------------------------
+// TempFileSystem::file_node_t::contents
+//
+// Gets the file data, which may be shared with the origin node; requires datalock
+//
+// Arguments:
+//
+//	NONE
+
+TempFileSystem::file_node_t::data_t const& TempFileSystem::file_node_t::contents(void) const
+{
+	// The origin node belongs to a frozen file system, its data cannot change
+	return (origin) ? origin->data : data;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::file_node_t::diverge
+//
+// Copies up to length bytes of shared origin data into this node; requires 
+// datalock to be held for exclusive access
+//
+// Arguments:
+//
+//	length		- Maximum number of bytes that need to be copied
+
+void TempFileSystem::file_node_t::diverge(size_t length)
+{
+	if(!origin) return;
+
+	// Only the data that will remain after a truncation needs to be copied
+	length = std::min(length, origin->data.size());
+
+	try { data.assign(origin->data.begin(), origin->data.begin() + length); }
+	catch(...) { throw LinuxException(UAPI_ENOSPC); }
+
+	origin.reset();
+}
+
 //
 // TEMPFILESYSTEM::SYMLINK_NODE_T IMPLEMENTATION
 //
@@ -495,6 +1127,112 @@ std::shared_ptr<TempFileSystem::symlink_node_t> TempFileSystem::symlink_node_t::
 	return std::allocate_shared<symlink_node_t, allocator_t<symlink_node_t>>(allocator_t<symlink_node_t>(fs), fs, target, uid, gid);
 }
 
+//
+// TEMPFILESYSTEM::DIRLOCK_T IMPLEMENTATION
+//
+
+//---------------------------------------------------------------------------
+// TempFileSystem::dirlock_t Constructor
+//
+// Arguments:
+//
+//	NONE
+
+TempFileSystem::dirlock_t::dirlock_t() : m_count(0), m_held(false)
+{
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::dirlock_t Destructor
+
+TempFileSystem::dirlock_t::~dirlock_t()
+{
+	unlock();
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::dirlock_t::add
+//
+// Adds a directory node to the set of nodes to be locked
+//
+// Arguments:
+//
+//	node			- Directory node to be locked
+//	exclusive		- Flag to lock the directory node for exclusive access
+
+void TempFileSystem::dirlock_t::add(directory_node_t* node, bool exclusive)
+{
+	_ASSERTE(node != nullptr);
+	_ASSERTE(!m_held);
+
+	// The same directory node may be added more than once, exclusive access wins
+	for(size_t index = 0; index < m_count; index++) {
+
+		if(m_entries[index].node == node) { 
+			
+			m_entries[index].exclusive = (m_entries[index].exclusive || exclusive);
+			return;
+		}
+	}
+
+	_ASSERTE(m_count < MAX_NODES);
+	if(m_count >= MAX_NODES) throw LinuxException(UAPI_EINVAL);
+
+	// Insert the new entry such that the array remains sorted by node index
+	size_t pos = m_count++;
+	while((pos > 0) && (m_entries[pos - 1].node->index > node->index)) {
+
+		m_entries[pos] = m_entries[pos - 1];
+		--pos;
+	}
+
+	m_entries[pos] = { node, exclusive };
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::dirlock_t::lock
+//
+// Locks all of the directory nodes in ascending node index order
+//
+// Arguments:
+//
+//	NONE
+
+void TempFileSystem::dirlock_t::lock(void)
+{
+	_ASSERTE(!m_held);
+
+	for(size_t index = 0; index < m_count; index++) {
+
+		if(m_entries[index].exclusive) m_entries[index].node->nodeslock.lock_write();
+		else m_entries[index].node->nodeslock.lock_read();
+	}
+
+	m_held = true;
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::dirlock_t::unlock
+//
+// Unlocks all of the directory nodes in reverse order
+//
+// Arguments:
+//
+//	NONE
+
+void TempFileSystem::dirlock_t::unlock(void)
+{
+	if(!m_held) return;
+
+	for(size_t index = m_count; index > 0; index--) {
+
+		if(m_entries[index - 1].exclusive) m_entries[index - 1].node->nodeslock.unlock_write();
+		else m_entries[index - 1].node->nodeslock.unlock_read();
+	}
+
+	m_held = false;
+}
+
 //
 // TEMPFILESYSTEM::HANDLE_T IMPLEMENTATION
 //
@@ -556,14 +1294,19 @@ std::unique_ptr<VirtualMachine::Node> TempFileSystem::Directory::CreateDirectory
 	auto node = directory_node_t::allocate_shared(m_node->fs, mode, uid, gid);
 
 	// Lock the nodes collection for exclusive access
-	sync::reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
+	m_node->materialize();
+	sync::distributed_reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
 
 	// Attempt to insert the new node into the collection
 	auto result = m_node->nodes.emplace(name, node);
 	if(result.second == false) throw LinuxException(UAPI_EEXIST);
+	m_node->unseal();
 
 	// Update mtime and ctime for this node
-	m_node->mtime = m_node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_node->set_times(nullptr, &now, &now);
+
+	mount->Statistics->RecordCreate();
 
 	// Return a Directory instance to the caller
 	return std::make_unique<Directory>(node);
@@ -598,14 +1341,19 @@ std::unique_ptr<VirtualMachine::Node> TempFileSystem::Directory::CreateFile(Virt
 	auto node = file_node_t::allocate_shared(m_node->fs, mode, uid, gid);
 
 	// Lock the nodes collection for exclusive access
-	sync::reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
+	m_node->materialize();
+	sync::distributed_reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
 
 	// Attempt to insert the new node into the collection
 	auto result = m_node->nodes.emplace(name, node);
 	if(result.second == false) throw LinuxException(UAPI_EEXIST);
+	m_node->unseal();
 
 	// Update mtime and ctime for this node
-	m_node->mtime = m_node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_node->set_times(nullptr, &now, &now);
+
+	mount->Statistics->RecordCreate();
 
 	// Return a File instance to the caller
 	return std::make_unique<File>(node);
@@ -635,6 +1383,9 @@ std::unique_ptr<VirtualMachine::DirectoryHandle> TempFileSystem::Directory::Crea
 	// Directories cannot be opened for write access
 	if((flags & UAPI_O_ACCMODE) != UAPI_O_RDONLY) throw LinuxException(UAPI_EISDIR);
 
+	// Directory handles enumerate the child nodes; a cloned directory must be populated first
+	m_node->materialize();
+
 	// Create and return the new handle instance
 	auto handle = std::make_shared<handle_t<directory_node_t>>(m_node);
 	return std::make_unique<DirectoryHandle>(handle, flags, mount->Flags);
@@ -682,14 +1433,19 @@ std::unique_ptr<VirtualMachine::Node> TempFileSystem::Directory::CreateSymbolicL
 	auto node = symlink_node_t::allocate_shared(m_node->fs, target, uid, gid);
 
 	// Lock the nodes collection for exclusive access
-	sync::reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
+	m_node->materialize();
+	sync::distributed_reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
 
 	// Attempt to insert the new node into the collection
 	auto result = m_node->nodes.emplace(name, node);
 	if(result.second == false) throw LinuxException(UAPI_EEXIST);
+	m_node->unseal();
 
 	// Update mtime and ctime for this node
-	m_node->mtime = m_node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_node->set_times(nullptr, &now, &now);
+
+	mount->Statistics->RecordCreate();
 
 	// Return a SymbolicLink instance to the caller
 	return std::make_unique<SymbolicLink>(node);
@@ -751,14 +1507,17 @@ void TempFileSystem::Directory::Link(VirtualMachine::Mount const* mount, Virtual
 	if(!nodeptr) throw LinuxException(UAPI_ENXIO);
 
 	// Lock the nodes collection for exclusive access
-	sync::reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
+	m_node->materialize();
+	sync::distributed_reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
 
 	// Attempt to insert the node into the collection with the new name
 	auto result = m_node->nodes.emplace(name, nodeptr);
 	if(result.second == false) throw LinuxException(UAPI_EEXIST);
+	m_node->unseal();
 
 	// Update mtime and ctime for this node
-	m_node->mtime = m_node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_node->set_times(nullptr, &now, &now);
 }
 
 //-----------------------------------------------------------------------------
@@ -773,6 +1532,7 @@ void TempFileSystem::Directory::Link(VirtualMachine::Mount const* mount, Virtual
 std::unique_ptr<VirtualMachine::Node> TempFileSystem::Directory::Lookup(VirtualMachine::Mount const* mount, char_t const* name)
 {
 	std::unique_ptr<VirtualMachine::Node>		result;			// Resultant Node instance
+	std::shared_ptr<node_t>						child;			// Child node_t instance
 
 	if(mount == nullptr) throw LinuxException(UAPI_EFAULT);
 	if(name == nullptr) throw LinuxException(UAPI_EFAULT);
@@ -780,26 +1540,41 @@ std::unique_ptr<VirtualMachine::Node> TempFileSystem::Directory::Lookup(VirtualM
 	// Check that the provided mount is part of the same file system instance
 	if(mount->FileSystem != m_node->fs.get()) throw LinuxException(UAPI_EXDEV);
 
-	// Lock the nodes collection for shared access
-	sync::reader_writer_lock::scoped_lock_read reader(m_node->nodeslock);
+	mount->Statistics->RecordLookup();
+
+	// Cloned directories are populated from their origin the first time they are accessed
+	m_node->materialize();
+
+	// Sealed directories are looked up in the immutable table without acquiring nodeslock
+	directory_node_t::sealed_t const* sealed = m_node->sealed.load(std::memory_order_acquire);
+	if(sealed) child = sealed->find(name);
+
+	else {
+
+		// Lock the nodes collection for shared access
+		sync::distributed_reader_writer_lock::scoped_lock_read reader(m_node->nodeslock);
+
+		// Attempt to find the node in the collection
+		auto found = m_node->nodes.find(name);
+		if(found != m_node->nodes.end()) child = found->second;
+	}
 
-	// Attempt to find the node in the collection, ENOENT if it doesn't exist
-	auto found = m_node->nodes.find(name);
-	if(found == m_node->nodes.end()) throw LinuxException(UAPI_ENOENT);
+	// ENOENT if the node doesn't exist
+	if(!child) throw LinuxException(UAPI_ENOENT);
 
 	// Return the appropriate type of VirtualMachine::Node instance to the caller
-	switch(found->second->mode & UAPI_S_IFMT) {
+	switch(child->mode & UAPI_S_IFMT) {
 
 		case UAPI_S_IFDIR: 
-			result = std::make_unique<Directory>(std::dynamic_pointer_cast<directory_node_t>(found->second));
+			result = std::make_unique<Directory>(std::dynamic_pointer_cast<directory_node_t>(child));
 			break;
 
 		case UAPI_S_IFREG: 
-			result = std::make_unique<File>(std::dynamic_pointer_cast<file_node_t>(found->second));
+			result = std::make_unique<File>(std::dynamic_pointer_cast<file_node_t>(child));
 			break;
 
 		case UAPI_S_IFLNK: 
-			result = std::make_unique<SymbolicLink>(std::dynamic_pointer_cast<symlink_node_t>(found->second));
+			result = std::make_unique<SymbolicLink>(std::dynamic_pointer_cast<symlink_node_t>(child));
 			break;
 
 		// todo: other valid node types (block device, fifo, char device, etc)
@@ -812,6 +1587,148 @@ std::unique_ptr<VirtualMachine::Node> TempFileSystem::Directory::Lookup(VirtualM
 	return result;										
 }
 
+//---------------------------------------------------------------------------
+// TempFileSystem::Directory::Rename
+//
+// Atomically renames or exchanges a child node of this directory
+//
+// Arguments:
+//
+//	mount		- Mount point on which to perform the operation
+//	oldname		- Name of the child node to be renamed
+//	newdir		- Directory in which the node will be placed
+//	newname		- New name to assign to the child node
+//	flags		- RENAME_NOREPLACE, RENAME_EXCHANGE
+
+void TempFileSystem::Directory::Rename(VirtualMachine::Mount const* mount, char_t const* oldname, VirtualMachine::Directory const* newdir, char_t const* newname, uint32_t flags)
+{
+	if(mount == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(oldname == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(newdir == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(newname == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	// RENAME_WHITEOUT is not supported, and RENAME_NOREPLACE cannot be combined with RENAME_EXCHANGE
+	if(flags & ~(UAPI_RENAME_NOREPLACE | UAPI_RENAME_EXCHANGE)) throw LinuxException(UAPI_EINVAL);
+	if((flags & UAPI_RENAME_NOREPLACE) && (flags & UAPI_RENAME_EXCHANGE)) throw LinuxException(UAPI_EINVAL);
+
+	// Check that the mount is for this file system and it's not read-only
+	if(mount->FileSystem != m_node->fs.get()) throw LinuxException(UAPI_EXDEV);
+	if(mount->Flags & UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
+
+	// The target directory must also be part of this file system
+	Directory const* target = dynamic_cast<Directory const*>(newdir);
+	if((target == nullptr) || (target->m_node->fs != m_node->fs)) throw LinuxException(UAPI_EXDEV);
+
+	directory_node_t* olddir = m_node.get();
+	directory_node_t* newdirnode = target->m_node.get();
+	bool exchange = ((flags & UAPI_RENAME_EXCHANGE) == UAPI_RENAME_EXCHANGE);
+
+	// Renames across directories are serialized for the entire file system, this prevents
+	// another rename from changing the shape of the tree while it's being checked for loops
+	std::unique_lock<sync::critical_section> renamer(m_node->fs->m_renamelock, std::defer_lock);
+	if(olddir != newdirnode) renamer.lock();
+
+	olddir->materialize();
+	newdirnode->materialize();
+
+	while(true) {
+
+		std::shared_ptr<node_t>		source;			// Node being renamed
+		std::shared_ptr<node_t>		victim;			// Node being replaced or exchanged
+		dirlock_t					locks;			// Ordered directory locks
+
+		// Look up the source node with shared access, ENOENT if it doesn't exist
+		sync::distributed_reader_writer_lock::scoped_lock_read oldreader(olddir->nodeslock);
+		auto oldfound = olddir->nodes.find(oldname);
+		if(oldfound == olddir->nodes.end()) throw LinuxException(UAPI_ENOENT);
+		source = oldfound->second;
+		oldreader.unlock();
+
+		// Look up the victim node with shared access, this one is allowed to not exist
+		sync::distributed_reader_writer_lock::scoped_lock_read newreader(newdirnode->nodeslock);
+		auto newfound = newdirnode->nodes.find(newname);
+		if(newfound != newdirnode->nodes.end()) victim = newfound->second;
+		newreader.unlock();
+
+		// RENAME_EXCHANGE requires both names to exist, RENAME_NOREPLACE requires that the new one does not
+		if(exchange && !victim) throw LinuxException(UAPI_ENOENT);
+		if((flags & UAPI_RENAME_NOREPLACE) && victim) throw LinuxException(UAPI_EEXIST);
+
+		// If both names refer to the same node there is nothing to do
+		if(source == victim) return;
+
+		bool sourceisdir = ((source->mode & UAPI_S_IFMT) == UAPI_S_IFDIR);
+		bool victimisdir = (victim && ((victim->mode & UAPI_S_IFMT) == UAPI_S_IFDIR));
+
+		// A directory can only replace another directory and a non-directory can only replace a non-directory
+		if(victim && !exchange) {
+
+			if(sourceisdir && !victimisdir) throw LinuxException(UAPI_ENOTDIR);
+			if(!sourceisdir && victimisdir) throw LinuxException(UAPI_EISDIR);
+		}
+
+		// A directory cannot be moved into itself or any of its own descendants
+		if(olddir != newdirnode) {
+
+			if(sourceisdir && std::dynamic_pointer_cast<directory_node_t>(source)->contains(newdirnode)) throw LinuxException(UAPI_EINVAL);
+			if(exchange && victimisdir && std::dynamic_pointer_cast<directory_node_t>(victim)->contains(olddir)) throw LinuxException(UAPI_EINVAL);
+		}
+
+		// Lock both directories for exclusive access; a directory being replaced must also be
+		// locked for shared access to ensure that it remains empty
+		std::shared_ptr<directory_node_t> replaced;
+		if(victimisdir && !exchange) replaced = std::dynamic_pointer_cast<directory_node_t>(victim);
+		if(replaced) replaced->materialize();
+
+		locks.add(olddir, true);
+		locks.add(newdirnode, true);
+		if(replaced) locks.add(replaced.get(), false);
+		locks.lock();
+
+		// Either name may have changed while no locks were held, try again
+		oldfound = olddir->nodes.find(oldname);
+		if((oldfound == olddir->nodes.end()) || (oldfound->second != source)) continue;
+
+		newfound = newdirnode->nodes.find(newname);
+		bool newexists = (newfound != newdirnode->nodes.end());
+		if((newexists != static_cast<bool>(victim)) || (newexists && (newfound->second != victim))) continue;
+
+		// A directory that is not empty cannot be replaced
+		if(replaced && (replaced->nodes.size() > 0)) throw LinuxException(UAPI_ENOTEMPTY);
+
+		// RENAME_EXCHANGE -- swap the nodes referenced by each name
+		if(exchange) std::swap(oldfound->second, newfound->second);
+
+		else {
+
+			// Insert or replace the new name before removing the old name; if the insert
+			// fails the operation has no effect on either directory
+			if(victim) newfound->second = source;
+			else newdirnode->nodes.emplace(newname, source);
+
+			// The old iterator may have been invalidated by the insertion if both names
+			// are in the same directory, erase by name rather than by iterator
+			olddir->nodes.erase(oldname);
+		}
+
+		// The sealed lookup tables of both directories no longer reflect their contents
+		olddir->unseal();
+		newdirnode->unseal();
+
+		// Bump the rename generation while the directories are still locked
+		m_node->fs->RenameGeneration++;
+
+		// Update mtime and ctime for both directories and ctime for the renamed node(s)
+		uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+		olddir->set_times(nullptr, &now, &now);
+		if(newdirnode != olddir) newdirnode->set_times(nullptr, &now, &now);
+		source->set_times(nullptr, &now, nullptr);
+		if(exchange) victim->set_times(nullptr, &now, nullptr);
+
+		return;
+	}
+}
+
 //---------------------------------------------------------------------------
 // TempFileSystem::Directory::Unlink
 //
@@ -830,31 +1747,52 @@ void TempFileSystem::Directory::Unlink(VirtualMachine::Mount const* mount, char_
 	// Check that the mount is for this file system and it's not read-only
 	if(mount->FileSystem != m_node->fs.get()) throw LinuxException(UAPI_EXDEV);
 	if(mount->Flags & UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
-	
-	// Lock the nodes collection for exclusive access
-	sync::reader_writer_lock::scoped_lock_write writer(m_node->nodeslock);
 
-	// Attempt to find the node in the collection, ENOENT if it doesn't exist
-	auto found = m_node->nodes.find(name);
-	if(found == m_node->nodes.end()) throw LinuxException(UAPI_ENOENT);
+	m_node->materialize();
+
+	while(true) {
+
+		std::shared_ptr<node_t>		child;			// Child node to be unlinked
+		dirlock_t					locks;			// Ordered directory locks
 
-	// Directory nodes are processed using different semantics than other nodes
-	if((found->second->mode & UAPI_S_IFMT) == UAPI_S_IFDIR) {
+		// Look up the child node with shared access, ENOENT if it doesn't exist
+		sync::distributed_reader_writer_lock::scoped_lock_read reader(m_node->nodeslock);
+		auto found = m_node->nodes.find(name);
+		if(found == m_node->nodes.end()) throw LinuxException(UAPI_ENOENT);
+		child = found->second;
+		reader.unlock();
 
-		// Cast out a pointer to the child's directory_node_t and lock it
-		auto dir = std::dynamic_pointer_cast<directory_node_t>(found->second);
-		sync::reader_writer_lock::scoped_lock_read reader(dir->nodeslock);
+		// Directory nodes are processed using different semantics than other nodes, the
+		// child directory must be locked as well to ensure that it remains empty
+		std::shared_ptr<directory_node_t> dir;
+		if((child->mode & UAPI_S_IFMT) == UAPI_S_IFDIR) dir = std::dynamic_pointer_cast<directory_node_t>(child);
+		if(dir) dir->materialize();
+
+		// Lock this directory for exclusive access and the child directory for shared access
+		locks.add(m_node.get(), true);
+		if(dir) locks.add(dir.get(), false);
+		locks.lock();
+
+		// The name may have been unlinked or renamed while no locks were held, try again
+		found = m_node->nodes.find(name);
+		if((found == m_node->nodes.end()) || (found->second != child)) continue;
 
 		// If the directory is not empty, it cannot be unlinked
-		if(dir->nodes.size() > 0) throw LinuxException(UAPI_ENOTEMPTY);
-	}
+		if(dir && (dir->nodes.size() > 0)) throw LinuxException(UAPI_ENOTEMPTY);
 
-	// Unlink the node by removing it from this directory; the node itself will
-	// die off when it's no longer in use but this prevents it from being looked up
-	m_node->nodes.erase(found->first);
+		// Unlink the node by removing it from this directory; the node itself will
+		// die off when it's no longer in use but this prevents it from being looked up
+		m_node->nodes.erase(found);
+		m_node->unseal();
 
-	// Update mtime and ctime for this node
-	m_node->mtime = m_node->ctime = convert<uapi_timespec>(datetime::now());
+		// Update mtime and ctime for this node
+		uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+		m_node->set_times(nullptr, &now, &now);
+
+		mount->Statistics->RecordUnlink();
+
+		return;
+	}
 }
 
 //
@@ -911,31 +1849,90 @@ std::unique_ptr<VirtualMachine::Handle> TempFileSystem::DirectoryHandle::Duplica
 
 void TempFileSystem::DirectoryHandle::Enumerate(std::function<bool(VirtualMachine::DirectoryEntry const&)> func)
 {
-	size_t				index = 0;				// Current enumeration index value
+	std::vector<directory_node_t::entry_t>	entries;	// Entries after the current position
 
 	if(func == nullptr) throw LinuxException(UAPI_EFAULT);
 
 	size_t pos = m_handle->position;			// Copy the current position
 
 	// Lock the nodes collection for shared access
-	sync::reader_writer_lock::scoped_lock_read reader(m_handle->node->nodeslock);
+	sync::distributed_reader_writer_lock::scoped_lock_read reader(m_handle->node->nodeslock);
+
+	// The position is the cookie of the last entry consumed by the previous enumeration
+	m_handle->node->entries(reader, pos, SIZE_MAX, entries);
 
 	// There are many different formats used when reading directories from the system 
 	// call interfaces, use a caller-provided function to do the actual processing
-	for(auto const entry : m_handle->node->nodes) {
+	for(auto const& entry : entries) {
 
-		// Skip entries up to the current fake file position
-		if(pos > index++) continue;
+		pos = entry.first;
 
 		// The callback function can return false to stop the enumeration
-		if(!func({ entry.second->index, entry.second->mode, entry.first.c_str() })) break;
+		if(!func({ entry.second->second->index, entry.second->second->mode, entry.second->first.c_str() })) break;
+	}
+
+	// Move the fake seek pointer to the cookie of the last entry that was processed
+	m_handle->position = pos;
+
+	// Update the access time for this node
+	m_handle->node->touch_atime({ 0, UAPI_UTIME_NOW }, m_mountflags);
+}
+
+//---------------------------------------------------------------------------
+// TempFileSystem::DirectoryHandle::ReadEntries
+//
+// Writes directory entry records into a buffer, resuming from the current position
+//
+// Arguments:
+//
+//	format		- Format of the directory entry records to be written
+//	buffer		- Output buffer
+//	length		- Length of the output buffer, in bytes
+
+size_t TempFileSystem::DirectoryHandle::ReadEntries(VirtualMachine::DirectoryEntryFormat format, void* buffer, size_t length)
+{
+	std::vector<directory_node_t::entry_t>	entries;	// Entries after the current position
+
+	// O_PATH handles cannot be used for this operation
+	if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
+
+	DirectoryEntryBuffer output(format, buffer, length);
+	size_t pos = m_handle->position;			// Copy the current position
+
+	// Lock the nodes collection for shared access
+	sync::distributed_reader_writer_lock::scoped_lock_read reader(m_handle->node->nodeslock);
+
+	// Only as many entries as could possibly fit into the output buffer need to be sorted
+	m_handle->node->entries(reader, pos, (length / DirectoryEntryBuffer::RecordLength(format, 1)) + 1, entries);
+
+	size_t groupcookie = pos;					// Cookie of the current group of entries
+	size_t grouplength = 0;						// Output length at the start of the group
+	bool full = false;							// Flag if the output buffer is full
+
+	for(auto const& entry : entries) {
+
+		// Entries that share a cookie cannot be split across calls, track where each group starts
+		if(entry.first != groupcookie) { pos = groupcookie; groupcookie = entry.first; grouplength = output.Length; }
+
+		auto const& name = entry.second->first;
+		if(!output.Append(entry.second->second->index, entry.second->second->mode, name.data(), name.length(), static_cast<int64_t>(entry.first))) {
+
+			// Discard the partial group; if nothing fit into the buffer it's too small
+			output.Rollback(grouplength);
+			if(output.Length == 0) throw LinuxException(UAPI_EINVAL);
+
+			full = true;
+			break;
+		}
 	}
 
-	// Move the fake seek pointer to the higher of the last entry index or original position
-	m_handle->position = std::max(index, pos);
+	// Move the fake seek pointer to the cookie of the last complete group written into the buffer
+	m_handle->position = (full) ? pos : groupcookie;
 
 	// Update the access time for this node
 	m_handle->node->touch_atime({ 0, UAPI_UTIME_NOW }, m_mountflags);
+
+	return output.Length;
 }
 
 //---------------------------------------------------------------------------
@@ -956,7 +1953,7 @@ size_t TempFileSystem::DirectoryHandle::Seek(ssize_t offset, int whence)
 	size_t pos = m_handle->position;		// Copy the current position
 
 	// Prevent changes to the underlying directory contents during the seek
-	sync::reader_writer_lock::scoped_lock_read reader(m_handle->node->nodeslock);
+	sync::distributed_reader_writer_lock::scoped_lock_read reader(m_handle->node->nodeslock);
 
 	switch(whence) {
 
@@ -977,7 +1974,7 @@ size_t TempFileSystem::DirectoryHandle::Seek(ssize_t offset, int whence)
 		// UAPI_SEEK_END - Seeks to an offset relative to the end of the file
 		case UAPI_SEEK_END:
 
-			pos = m_handle->node->nodes.size() + offset;
+			pos = directory_node_t::COOKIE_END + offset;
 			break;
 
 		default: throw LinuxException(UAPI_EINVAL);
@@ -1044,8 +2041,9 @@ std::unique_ptr<VirtualMachine::FileHandle> TempFileSystem::File::CreateFileHand
 	if((flags & UAPI_O_DIRECTORY) == UAPI_O_DIRECTORY) throw LinuxException(UAPI_ENOTDIR);
 	if(flags & (UAPI_FASYNC | UAPI_O_CREAT | UAPI_O_EXCL | UAPI_O_TMPFILE | UAPI_O_TRUNC)) throw LinuxException(UAPI_EINVAL);
 
+	// The handle shares the mount statistics so that it can outlive the mount instance
 	auto handle = std::make_shared<handle_t<file_node_t>>(m_node);
-	return std::make_unique<FileHandle>(handle, flags, mount->Flags);
+	return std::make_unique<FileHandle>(handle, flags, mount->Flags, static_cast<TempFileSystem::Mount const*>(mount)->m_stats);
 }
 
 //---------------------------------------------------------------------------
@@ -1089,11 +2087,13 @@ std::unique_ptr<VirtualMachine::Node> TempFileSystem::File::Duplicate(void) cons
 //	handle		- Shared handle_t instance
 //	flags		- Handle instance specific flags
 //	mountflags	- Mount flags in effect when handle was opened
+//	stats		- Statistics for the mount the handle was opened on
 
-TempFileSystem::FileHandle::FileHandle(std::shared_ptr<handle_t<file_node_t>> const& handle, uint32_t flags, uint32_t mountflags) : 
-	Handle(flags, mountflags), m_handle(handle)
+TempFileSystem::FileHandle::FileHandle(std::shared_ptr<handle_t<file_node_t>> const& handle, uint32_t flags, uint32_t mountflags, 
+	std::shared_ptr<MountStatistics> const& stats) : Handle(flags, mountflags), m_handle(handle), m_stats(stats)
 {
 	_ASSERTE(m_handle);
+	_ASSERTE(m_stats);
 }
 
 //---------------------------------------------------------------------------
@@ -1112,7 +2112,7 @@ std::unique_ptr<VirtualMachine::Handle> TempFileSystem::FileHandle::Duplicate(ui
 	if((flags & UAPI_O_DIRECTORY) == UAPI_O_DIRECTORY) throw LinuxException(UAPI_ENOTDIR);
 	if(flags & (UAPI_FASYNC | UAPI_O_CREAT | UAPI_O_EXCL | UAPI_O_TMPFILE | UAPI_O_TRUNC)) throw LinuxException(UAPI_EINVAL);
 
-	return std::make_unique<FileHandle>(m_handle, flags, m_mountflags);
+	return std::make_unique<FileHandle>(m_handle, flags, m_mountflags, m_stats);
 }
 
 //---------------------------------------------------------------------------
@@ -1127,6 +2127,10 @@ std::unique_ptr<VirtualMachine::Handle> TempFileSystem::FileHandle::Duplicate(ui
 
 size_t TempFileSystem::FileHandle::Read(void* buffer, size_t count)
 {
+	s_tmpfsread.Fire(reinterpret_cast<uintptr_t>(this), m_handle->position, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Read);
+
 	if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
 
 	// O_PATH handles cannot be used for this operation
@@ -1136,22 +2140,25 @@ size_t TempFileSystem::FileHandle::Read(void* buffer, size_t count)
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	sync::reader_writer_lock::scoped_lock_read reader(m_handle->node->datalock);
+	auto const& data = m_handle->node->contents();
 
 	size_t pos = m_handle->position;		// Copy the current position
 
 	// Determine the number of bytes to actually read from the file data
-	if(pos >= m_handle->node->data.size()) return 0;
-	count = std::min(count, m_handle->node->data.size() - pos);
+	if(pos >= data.size()) return transfer.Complete(0);
+	count = std::min(count, data.size() - pos);
 
 	// Copy the requested data from the file into the provided buffer
-	if(count > 0) memcpy(buffer, &m_handle->node->data[pos], count);
+	sync::range_lock::scoped_lock_read range(m_handle->node->rangelock, pos, count);
+	if(count > 0) memcpy(buffer, &data[pos], count);
+	range.unlock();
 
 	m_handle->position = (pos + count);		// Set the new position
 
 	// Update atime for this node if O_NOATIME was not set on this handle
 	if((m_flags & UAPI_O_NOATIME) == 0) m_handle->node->touch_atime({ 0, UAPI_UTIME_NOW }, m_mountflags);
 
-	return count;
+	return transfer.Complete(count);
 }
 
 //---------------------------------------------------------------------------
@@ -1167,6 +2174,10 @@ size_t TempFileSystem::FileHandle::Read(void* buffer, size_t count)
 
 size_t TempFileSystem::FileHandle::ReadAt(size_t offset, void* buffer, size_t count)
 {
+	s_tmpfsread.Fire(reinterpret_cast<uintptr_t>(this), offset, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Read);
+
 	if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
 
 	// O_PATH handles cannot be used for this operation
@@ -1176,18 +2187,21 @@ size_t TempFileSystem::FileHandle::ReadAt(size_t offset, void* buffer, size_t co
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	sync::reader_writer_lock::scoped_lock_read reader(m_handle->node->datalock);
+	auto const& data = m_handle->node->contents();
 
 	// Determine the number of bytes to actually read from the file data
-	if(offset >= m_handle->node->data.size()) return 0;
-	count = std::min(count, m_handle->node->data.size() - offset);
+	if(offset >= data.size()) return transfer.Complete(0);
+	count = std::min(count, data.size() - offset);
 
 	// Copy the requested data from the file into the provided buffer
-	if(count > 0) memcpy(buffer, &m_handle->node->data[offset], count);
+	sync::range_lock::scoped_lock_read range(m_handle->node->rangelock, offset, count);
+	if(count > 0) memcpy(buffer, &data[offset], count);
+	range.unlock();
 
 	// Update atime for this node if O_NOATIME was not set on this handle
 	if((m_flags & UAPI_O_NOATIME) == 0) m_handle->node->touch_atime({ 0, UAPI_UTIME_NOW }, m_mountflags);
 
-	return count;
+	return transfer.Complete(count);
 }
 
 //---------------------------------------------------------------------------
@@ -1229,7 +2243,7 @@ size_t TempFileSystem::FileHandle::Seek(ssize_t offset, int whence)
 		// UAPI_SEEK_END - Seeks to an offset relative to the end of the file
 		case UAPI_SEEK_END:
 
-			pos = m_handle->node->data.size() + offset;
+			pos = m_handle->node->contents().size() + offset;
 			break;
 
 		default: throw LinuxException(UAPI_EINVAL);
@@ -1250,14 +2264,22 @@ size_t TempFileSystem::FileHandle::Seek(ssize_t offset, int whence)
 
 size_t TempFileSystem::FileHandle::SetLength(size_t length)
 {
+	s_tmpfssetlength.Fire(reinterpret_cast<uintptr_t>(this), 0, length);
+
 	// O_PATH handles cannot be used for this operation
 	if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
 
 	// Verify that the handle was not opened in read-only mode
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_RDONLY) throw LinuxException(UAPI_EBADF);
 
+	// The file system may have been frozen after the handle was opened
+	if((m_handle->node->fs->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
+
 	sync::reader_writer_lock::scoped_lock_write writer(m_handle->node->datalock);
 
+	// A cloned file only needs its own copy of the data that remains after the new length
+	m_handle->node->diverge(length);
+
 	// Determine if the operation will shrink the file data buffer
 	bool shrink = (length < m_handle->node->data.size());
 
@@ -1269,7 +2291,8 @@ size_t TempFileSystem::FileHandle::SetLength(size_t length)
 	if(shrink) m_handle->node->data.shrink_to_fit();
 
 	// Update mtime and ctime for this node
-	m_handle->node->mtime = m_handle->node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_handle->node->set_times(nullptr, &now, &now);
 
 	return m_handle->node->data.size();
 }
@@ -1285,6 +2308,8 @@ size_t TempFileSystem::FileHandle::SetLength(size_t length)
 
 void TempFileSystem::FileHandle::Sync(void) const
 {
+	s_tmpfssync.Fire(reinterpret_cast<uintptr_t>(this));
+
 	// O_PATH handles cannot be used for this operation
 	if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
 
@@ -1293,6 +2318,7 @@ void TempFileSystem::FileHandle::Sync(void) const
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_WRONLY) throw LinuxException(UAPI_EBADF);
 
 	// no-operation
+	m_stats->RecordSync();
 }
 
 //---------------------------------------------------------------------------
@@ -1307,6 +2333,10 @@ void TempFileSystem::FileHandle::Sync(void) const
 
 size_t TempFileSystem::FileHandle::Write(const void* buffer, size_t count)
 {
+	s_tmpfswrite.Fire(reinterpret_cast<uintptr_t>(this), m_handle->position, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Write);
+
 	if((count > 0) && (buffer == nullptr)) throw LinuxException(UAPI_EFAULT);
 
 	// O_PATH handles cannot be used for this operation
@@ -1315,27 +2345,53 @@ size_t TempFileSystem::FileHandle::Write(const void* buffer, size_t count)
 	// Verify that the handle was not opened in read-only mode
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_RDONLY) throw LinuxException(UAPI_EBADF);
 
-	sync::reader_writer_lock::scoped_lock_write writer(m_handle->node->datalock);
+	// The file system may have been frozen after the handle was opened
+	if((m_handle->node->fs->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
+
+	// Writes that fit within the existing data only need to lock the range being written
+	sync::reader_writer_lock::scoped_lock_read reader(m_handle->node->datalock);
 
 	// O_APPEND: Always move the position to the end of the file data
-	size_t pos = ((m_flags & UAPI_O_APPEND) == UAPI_O_APPEND) ? m_handle->node->data.size() : m_handle->position;
+	size_t pos = ((m_flags & UAPI_O_APPEND) == UAPI_O_APPEND) ? m_handle->node->contents().size() : m_handle->position;
 
-	// Ensure that the node buffer is large enough to accept the data
-	if((pos + count) > m_handle->node->data.size()) {
-		
-		try { m_handle->node->data.resize(pos + count); }
-		catch(...) { throw LinuxException(UAPI_ENOSPC); }
+	// A cloned file that still shares the origin data always requires exclusive access
+	if(!m_handle->node->origin && ((pos + count) <= m_handle->node->data.size())) {
+
+		// Copy the data from the input buffer into the node data buffer
+		sync::range_lock::scoped_lock_write range(m_handle->node->rangelock, pos, count);
+		if(count > 0) memcpy(&m_handle->node->data[pos], buffer, count);
 	}
 
-	// Copy the data from the input buffer into the node data buffer
-	if(count > 0) memcpy(&m_handle->node->data[pos], buffer, count);
+	else {
+
+		// Writes that extend the data change its size and require exclusive access
+		reader.unlock();
+		sync::reader_writer_lock::scoped_lock_write writer(m_handle->node->datalock);
+
+		// Take a private copy of any data still shared with the origin node
+		m_handle->node->diverge();
+
+		// The size of the data may have changed while the lock was released
+		pos = ((m_flags & UAPI_O_APPEND) == UAPI_O_APPEND) ? m_handle->node->data.size() : m_handle->position;
+
+		// Ensure that the node buffer is large enough to accept the data
+		if((pos + count) > m_handle->node->data.size()) {
+		
+			try { m_handle->node->data.resize(pos + count); }
+			catch(...) { throw LinuxException(UAPI_ENOSPC); }
+		}
+
+		// Copy the data from the input buffer into the node data buffer
+		if(count > 0) memcpy(&m_handle->node->data[pos], buffer, count);
+	}
 	
 	m_handle->position = (pos + count);		// Set the new position
 
 	// Update mtime and ctime for this node
-	m_handle->node->mtime = m_handle->node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_handle->node->set_times(nullptr, &now, &now);
 
-	return count;
+	return transfer.Complete(count);
 }
 
 //---------------------------------------------------------------------------
@@ -1352,28 +2408,55 @@ size_t TempFileSystem::FileHandle::Write(const void* buffer, size_t count)
 
 size_t TempFileSystem::FileHandle::WriteAt(size_t offset, const void* buffer, size_t count)
 {
+	s_tmpfswrite.Fire(reinterpret_cast<uintptr_t>(this), offset, count);
+
+	MountStatistics::Transfer transfer(m_stats.get(), MountStatistics::Direction::Write);
+
 	// O_PATH handles cannot be used for this operation
 	if((m_flags & UAPI_O_PATH) == UAPI_O_PATH) throw LinuxException(UAPI_EBADF);
 
 	// Verify that the handle was not opened in read-only mode
 	if((m_flags & UAPI_O_ACCMODE) == UAPI_O_RDONLY) throw LinuxException(UAPI_EBADF);
 
-	sync::reader_writer_lock::scoped_lock_write writer(m_handle->node->datalock);
+	// The file system may have been frozen after the handle was opened
+	if((m_handle->node->fs->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
 
-	// Ensure that the node buffer is large enough to accept the data
-	if((offset + count) > m_handle->node->data.size()) {
-		
-		try { m_handle->node->data.resize(offset + count); }
-		catch(...) { throw LinuxException(UAPI_ENOSPC); }
+	// Writes that fit within the existing data only need to lock the range being written
+	sync::reader_writer_lock::scoped_lock_read reader(m_handle->node->datalock);
+
+	// A cloned file that still shares the origin data always requires exclusive access
+	if(!m_handle->node->origin && ((offset + count) <= m_handle->node->data.size())) {
+
+		// Copy the data from the input buffer into the node data buffer
+		sync::range_lock::scoped_lock_write range(m_handle->node->rangelock, offset, count);
+		if(count > 0) memcpy(&m_handle->node->data[offset], buffer, count);
 	}
 
-	// Copy the data from the input buffer into the node data buffer
-	if(count > 0) memcpy(&m_handle->node->data[offset], buffer, count);
+	else {
+
+		// Writes that extend the data change its size and require exclusive access
+		reader.unlock();
+		sync::reader_writer_lock::scoped_lock_write writer(m_handle->node->datalock);
+
+		// Take a private copy of any data still shared with the origin node
+		m_handle->node->diverge();
+
+		// Ensure that the node buffer is large enough to accept the data
+		if((offset + count) > m_handle->node->data.size()) {
+		
+			try { m_handle->node->data.resize(offset + count); }
+			catch(...) { throw LinuxException(UAPI_ENOSPC); }
+		}
+
+		// Copy the data from the input buffer into the node data buffer
+		if(count > 0) memcpy(&m_handle->node->data[offset], buffer, count);
+	}
 
 	// Update mtime and ctime for this node
-	m_handle->node->mtime = m_handle->node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_handle->node->set_times(nullptr, &now, &now);
 
-	return count;
+	return transfer.Complete(count);
 }
 
 //
@@ -1490,7 +2573,7 @@ size_t TempFileSystem::Handle<_interface>::Write(const void* buffer, size_t coun
 //	flags		- Mount-specific flags
 
 TempFileSystem::Mount::Mount(std::shared_ptr<TempFileSystem> const& fs, std::unique_ptr<Directory>&& rootdir, uint32_t flags) : 
-	m_fs(fs), m_rootdir(std::move(rootdir)), m_flags(flags)
+	m_fs(fs), m_rootdir(std::move(rootdir)), m_flags(flags), m_stats(std::make_shared<MountStatistics>())
 {
 	_ASSERTE(m_fs);
 	_ASSERTE(m_rootdir);
@@ -1507,10 +2590,11 @@ TempFileSystem::Mount::Mount(std::shared_ptr<TempFileSystem> const& fs, std::uni
 //
 //	rhs		- Existing Mount instance to create a copy of
 
-TempFileSystem::Mount::Mount(Mount const& rhs) : m_fs(rhs.m_fs), m_rootdir(rhs.m_rootdir), m_flags(static_cast<uint32_t>(rhs.m_flags))
+TempFileSystem::Mount::Mount(Mount const& rhs) : m_fs(rhs.m_fs), m_rootdir(rhs.m_rootdir), m_flags(static_cast<uint32_t>(rhs.m_flags)), 
+	m_stats(rhs.m_stats)
 {
-	// A copy of a mount references the same shared file system and root
-	// directory instance as well as a copy of the mount flags
+	// A copy of a mount references the same shared file system, root directory
+	// and statistics instances as well as a copy of the mount flags
 }
 
 //---------------------------------------------------------------------------
@@ -1562,6 +2646,16 @@ VirtualMachine::Node* TempFileSystem::Mount::getRootNode(void) const
 	return m_rootdir.get();
 }
 
+//---------------------------------------------------------------------------
+// TempFileSystem::Mount::getStatistics
+//
+// Gets a pointer to the mount point operation statistics
+
+MountStatistics* TempFileSystem::Mount::getStatistics(void) const
+{
+	return m_stats.get();
+}
+
 //
 // TEMPFILESYSTEM::NODE IMPLEMENTATION
 //
@@ -1587,7 +2681,7 @@ TempFileSystem::Node<_interface, _node_type>::Node(std::shared_ptr<_node_type> c
 template <class _interface, typename _node_type>
 uapi_timespec TempFileSystem::Node<_interface, _node_type>::getAccessTime(void) const
 {
-	return m_node->atime;
+	return m_node->get_times().atime;
 }
 
 //---------------------------------------------------------------------------
@@ -1598,7 +2692,7 @@ uapi_timespec TempFileSystem::Node<_interface, _node_type>::getAccessTime(void)
 template <class _interface, typename _node_type>
 uapi_timespec TempFileSystem::Node<_interface, _node_type>::getChangeTime(void) const
 {
-	return m_node->ctime;
+	return m_node->get_times().ctime;
 }
 		
 //---------------------------------------------------------------------------
@@ -1642,7 +2736,7 @@ uapi_mode_t TempFileSystem::Node<_interface, _node_type>::getMode(void) const
 template <class _interface, typename _node_type>
 uapi_timespec TempFileSystem::Node<_interface, _node_type>::getModificationTime(void) const
 {
-	return m_node->mtime;
+	return m_node->get_times().mtime;
 }
 		
 //---------------------------------------------------------------------------
@@ -1663,12 +2757,12 @@ uapi_timespec TempFileSystem::Node<_interface, _node_type>::SetAccessTime(Virtua
 	if((mount->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
 
 	// UTIME_OMIT - Don't actually change the access time
-	if(atime.tv_nsec == UAPI_UTIME_OMIT) return m_node->atime;
+	if(atime.tv_nsec == UAPI_UTIME_OMIT) return m_node->get_times().atime;
 
 	// UTIME_NOW - Use the current datetime as the timestamp
-	if(atime.tv_nsec == UAPI_UTIME_NOW) atime = convert<uapi_timespec>(datetime::now());
+	if(atime.tv_nsec == UAPI_UTIME_NOW) atime = convert<uapi_timespec>(coarseclock::now());
 
-	m_node->atime = atime;
+	m_node->set_times(&atime, nullptr, nullptr);
 	return atime;
 }
 
@@ -1690,12 +2784,12 @@ uapi_timespec TempFileSystem::Node<_interface, _node_type>::SetChangeTime(Virtua
 	if((mount->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
 
 	// UTIME_OMIT - Don't actually change the change time
-	if(ctime.tv_nsec == UAPI_UTIME_OMIT) return m_node->ctime;
+	if(ctime.tv_nsec == UAPI_UTIME_OMIT) return m_node->get_times().ctime;
 
 	// UTIME_NOW - Use the current datetime as the timestamp
-	if(ctime.tv_nsec == UAPI_UTIME_NOW) ctime = convert<uapi_timespec>(datetime::now());
+	if(ctime.tv_nsec == UAPI_UTIME_NOW) ctime = convert<uapi_timespec>(coarseclock::now());
 
-	m_node->ctime = ctime;
+	m_node->set_times(nullptr, &ctime, nullptr);
 	return ctime;
 }
 
@@ -1718,7 +2812,8 @@ uapi_gid_t TempFileSystem::Node<_interface, _node_type>::SetGroupId(VirtualMachi
 
 	// Apply the group id change and update the ctime for this node
 	m_node->gid = gid;
-	m_node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_node->set_times(nullptr, &now, nullptr);
 
 	return gid;
 }
@@ -1746,7 +2841,8 @@ uapi_mode_t TempFileSystem::Node<_interface, _node_type>::SetMode(VirtualMachine
 
 	// Apply the mode change and update the ctime for this node
 	m_node->mode = mode;
-	m_node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_node->set_times(nullptr, &now, nullptr);
 
 	return mode;
 }
@@ -1769,13 +2865,13 @@ uapi_timespec TempFileSystem::Node<_interface, _node_type>::SetModificationTime(
 	if((mount->Flags & UAPI_MS_RDONLY) == UAPI_MS_RDONLY) throw LinuxException(UAPI_EROFS);
 
 	// UTIME_OMIT - Don't actually change the modification time
-	if(mtime.tv_nsec == UAPI_UTIME_OMIT) return m_node->mtime;
+	if(mtime.tv_nsec == UAPI_UTIME_OMIT) return m_node->get_times().mtime;
 
 	// UTIME_NOW - Use the current datetime as the timestamp
-	if(mtime.tv_nsec == UAPI_UTIME_NOW) mtime = convert<uapi_timespec>(datetime::now());
+	if(mtime.tv_nsec == UAPI_UTIME_NOW) mtime = convert<uapi_timespec>(coarseclock::now());
 
 	// Setting the modification time also sets the change time
-	m_node->mtime = m_node->ctime = mtime;
+	m_node->set_times(nullptr, &mtime, &mtime);
 	return mtime;
 }
 
@@ -1798,7 +2894,8 @@ uapi_uid_t TempFileSystem::Node<_interface, _node_type>::SetUserId(VirtualMachin
 
 	// Apply the user id change and update the ctime for this node
 	m_node->uid = uid;
-	m_node->ctime = convert<uapi_timespec>(datetime::now());
+	uapi_timespec now = convert<uapi_timespec>(coarseclock::now());
+	m_node->set_times(nullptr, &now, nullptr);
 
 	return uid;
 }
@@ -1826,11 +2923,8 @@ void TempFileSystem::Node<_interface, _node_type>::Stat(VirtualMachine::Mount co
 	// to zeros since the underlying stat3264 structure is different for each platform
 	memset(stat, 0, sizeof(uapi_stat3264));
 
-	// Load all the atomic timespec values from the node since they are accessed
-	// multiple times to grab the tv_sec and tv_nsec values separately below
-	auto atime = m_node->atime.load();
-	auto mtime = m_node->mtime.load();
-	auto ctime = m_node->ctime.load();
+	// Take a consistent snapshot of the node timestamps
+	auto times = m_node->get_times();
 
 	//stat->st_dev = 0;						// todo - no device support yet
 	stat->st_ino = m_node->index;
@@ -1842,12 +2936,12 @@ void TempFileSystem::Node<_interface, _node_type>::Stat(VirtualMachine::Mount co
 	//stat->st_size = 0;					// todo - depends on node type
 	stat->st_blksize = SystemInformation::PageSize;
 	stat->st_blocks = align::up(stat->st_size, 512) / 512;
-	stat->st_atime = atime.tv_sec;
-	stat->st_atime_nsec;
-	stat->st_mtime = mtime.tv_sec;
-	stat->st_mtime_nsec = mtime.tv_nsec;
-	stat->st_ctime = ctime.tv_sec;
-	stat->st_ctime_nsec = ctime.tv_nsec;
+	stat->st_atime = times.atime.tv_sec;
+	stat->st_atime_nsec = times.atime.tv_nsec;
+	stat->st_mtime = times.mtime.tv_sec;
+	stat->st_mtime_nsec = times.mtime.tv_nsec;
+	stat->st_ctime = times.ctime.tv_sec;
+	stat->st_ctime_nsec = times.ctime.tv_nsec;
 
 	// Update the access time for this node based on the mount flags
 	m_node->touch_atime({ 0, UAPI_UTIME_NOW }, mount->Flags);
@@ -25,22 +25,36 @@
 #pragma once
 
 #include <datetime.h>
+#include <freelist.h>
+#include <map>
 #include <memory>
 #include <sync.h>
 #include <text.h>
 #include <timespan.h>
 #include <unordered_map>
+#include <vector>
 
 #include "IndexPool.h"
+#include "MountStatistics.h"
 #include "VirtualMachine.h"
 
 #pragma warning(push, 4)
 
+// CloneTempFileSystem
+//
+// Creates a copy-on-write clone of a TempFileSystem instance
+std::unique_ptr<VirtualMachine::Mount> CloneTempFileSystem(VirtualMachine::Mount const* source, uint32_t flags);
+
 // MountTempFileSystem
 //
 // Creates an instance of TempFileSystem
 std::unique_ptr<VirtualMachine::Mount> MountTempFileSystem(char_t const* source, uint32_t flags, void const* data, size_t datalength);
 
+// SealTempFileSystem
+//
+// Seals a TempFileSystem directory subtree into immutable lookup tables
+size_t SealTempFileSystem(VirtualMachine::Mount const* mount, VirtualMachine::Node const* directory);
+
 //-----------------------------------------------------------------------------
 // Class TempFileSystem
 //
@@ -88,6 +102,20 @@ std::unique_ptr<VirtualMachine::Mount> MountTempFileSystem(char_t const* source,
 //	size=nnn[K|k|M|m|G|g|%]			- See above
 //	nr_blocks=nnn[K|k|M|m|G|g]		- See above
 //	nr_inodes=nnn[K|k|M|m|G|g]		- See above
+//
+// Sealed directories:
+//
+//	SealTempFileSystem() compiles every directory of a subtree into an immutable minimal
+//	perfect hash table that Lookup() reads without acquiring the directory lock.  The
+//	mutable collection of child nodes is retained; any operation that changes a sealed
+//	directory discards that directory's table and it reverts to normal locked lookups
+//
+// Cloned file systems:
+//
+//	CloneTempFileSystem() freezes the source file system as read-only and creates a new
+//	file system whose root directory refers back to the source root.  A cloned directory
+//	populates itself with clones of the source child nodes the first time it is accessed,
+//	and a cloned file shares the source file data until it is first written to
 
 class TempFileSystem : public VirtualMachine::FileSystem
 {
@@ -103,11 +131,21 @@ class TempFileSystem : public VirtualMachine::FileSystem
 	// Supported remount operation flags
 	static const uint32_t REMOUNT_FLAGS = UAPI_MS_REMOUNT | UAPI_MS_RDONLY | UAPI_MS_SYNCHRONOUS | UAPI_MS_MANDLOCK | UAPI_MS_I_VERSION | UAPI_MS_LAZYTIME;
 
+	// CloneTempFileSystem (friend)
+	//
+	// Creates a copy-on-write clone of a TempFileSystem instance
+	friend std::unique_ptr<VirtualMachine::Mount> CloneTempFileSystem(VirtualMachine::Mount const* source, uint32_t flags);
+
 	// MountTempFileSystem (friend)
 	//
 	// Creates an instance of TempFileSystem
 	friend std::unique_ptr<VirtualMachine::Mount> MountTempFileSystem(char_t const* source, uint32_t flags, void const* data, size_t datalength);
 
+	// SealTempFileSystem (friend)
+	//
+	// Seals a TempFileSystem directory subtree into immutable lookup tables
+	friend size_t SealTempFileSystem(VirtualMachine::Mount const* mount, VirtualMachine::Node const* directory);
+
 public:
 
 	// Instance Constructor
@@ -141,9 +179,36 @@ public:
 	// Maximum allowed size of the private heap
 	std::atomic<size_t> MaximumSize = 0;
 
+	// RenameGeneration
+	//
+	// Incremented by each successful rename while the directory locks are held;
+	// lookups that span several directories can sample it to detect a rename
+	std::atomic<uint64_t> RenameGeneration = 0;
+
 	//-----------------------------------------------------------------------
 	// Member Functions
 	
+	//-----------------------------------------------------------------------
+	// Properties
+
+	// HeapAllocations
+	//
+	// Gets the total number of allocations made from the private heap
+	__declspec(property(get=getHeapAllocations)) uint64_t HeapAllocations;
+	uint64_t getHeapAllocations(void) const;
+
+	// HeapUsage
+	//
+	// Gets the number of bytes currently allocated from the private heap
+	__declspec(property(get=getHeapUsage)) size_t HeapUsage;
+	size_t getHeapUsage(void) const;
+
+	// PeakHeapUsage
+	//
+	// Gets the largest number of bytes allocated from the private heap at once
+	__declspec(property(get=getPeakHeapUsage)) size_t PeakHeapUsage;
+	size_t getPeakHeapUsage(void) const;
+
 private:
 
 	TempFileSystem(TempFileSystem const&)=delete;
@@ -283,6 +348,16 @@ private:
 	{
 	public:
 
+		// times_t
+		//
+		// Node timestamps, accessed through get_times() and set_times()
+		struct times_t
+		{
+			uapi_timespec		atime;		// Date/time that the node was last accessed
+			uapi_timespec		ctime;		// Date/time that the node metadata was last changed
+			uapi_timespec		mtime;		// Date/time that the node data was last changed
+		};
+
 		// Destructor
 		//
 		virtual ~node_t();
@@ -290,16 +365,6 @@ private:
 		//-------------------------------------------------------------------
 		// Fields
 
-		// atime
-		//
-		// Date/time that the node was last accessed
-		std::atomic<uapi_timespec> atime;
-
-		// ctime
-		//
-		// Date/time that the node metadata was last changed
-		std::atomic<uapi_timespec> ctime;
-
 		// fs
 		//
 		// Shared pointer to the parent file system
@@ -320,11 +385,6 @@ private:
 		// The node type and permission flags
 		std::atomic<uapi_mode_t> mode;
 
-		// mtime
-		//
-		// Date/time that the node data was last changed
-		std::atomic<uapi_timespec> mtime;
-
 		// uid
 		//
 		// Node owner user identifier
@@ -333,6 +393,16 @@ private:
 		//-------------------------------------------------------------------
 		// Member Functions
 
+		// get_times
+		//
+		// Gets a consistent snapshot of the node timestamps without locking
+		times_t get_times(void) const;
+
+		// set_times
+		//
+		// Updates the node timestamps; null pointers leave a timestamp unchanged
+		void set_times(uapi_timespec const* atime, uapi_timespec const* ctime, uapi_timespec const* mtime);
+
 		// touch_atime
 		//
 		// Updates the access time for the node based on NOATIME/RELATIME/STRICTATIME
@@ -348,6 +418,12 @@ private:
 
 		node_t(node_t const&)=delete;
 		node_t& operator=(node_t const&)=delete;
+
+		//-------------------------------------------------------------------
+		// Member Variables
+
+		times_t						m_times;		// Node timestamps
+		std::atomic<uint32_t>		m_timesseq;		// Timestamp sequence counter
 	};
 
 	// handle_t
@@ -398,6 +474,75 @@ private:
 		using nodemap_t = std::unordered_map<std::string, std::shared_ptr<node_t>, std::hash<std::string>,
 			std::equal_to<std::string>, allocator_t<std::pair<std::string const, std::shared_ptr<node_t>>>>;
 
+		// entry_t
+		//
+		// Child node entry paired with its stable enumeration cookie
+		using entry_t = std::pair<size_t, nodemap_t::value_type const*>;
+
+		// COOKIE_END
+		//
+		// Enumeration cookie that is positioned after all possible entries
+		static const size_t COOKIE_END = (SIZE_MAX >> 1);
+
+		// sealed_t
+		//
+		// Immutable minimal perfect hash table of the child nodes of a sealed directory
+		class sealed_t
+		{
+		public:
+
+			// Instance Constructor
+			//
+			sealed_t(std::shared_ptr<TempFileSystem> const& filesystem, nodemap_t const& nodes);
+
+			// Destructor
+			//
+			~sealed_t()=default;
+
+			//---------------------------------------------------------------
+			// Member Functions
+
+			// find
+			//
+			// Locates a child node by name; returns an empty pointer if not found
+			std::shared_ptr<node_t> find(char_t const* name) const;
+
+		private:
+
+			sealed_t(sealed_t const&)=delete;
+			sealed_t& operator=(sealed_t const&)=delete;
+
+			// MAX_SEED
+			//
+			// Largest bucket displacement seed attempted before the table is grown
+			static const uint32_t MAX_SEED = 0x10000;
+
+			// slot_t
+			//
+			// Table slot; the name is stored in the packed name buffer
+			struct slot_t
+			{
+				uint32_t				offset;		// Offset of the name in m_names
+				uint32_t				length;		// Length of the name
+				std::weak_ptr<node_t>	node;		// Child node instance
+			};
+
+			//---------------------------------------------------------------
+			// Private Member Functions
+
+			// hash (static)
+			//
+			// Generates a seeded hash of a child node name
+			static uint64_t hash(char_t const* name, size_t length, uint32_t seed);
+
+			//---------------------------------------------------------------
+			// Member Variables
+
+			std::vector<uint32_t, allocator_t<uint32_t>>	m_seeds;	// Bucket displacement seeds
+			std::vector<slot_t, allocator_t<slot_t>>		m_slots;	// Densely packed slots
+			std::vector<char_t, allocator_t<char_t>>		m_names;	// Packed child node names
+		};
+
 		// Instance Constructor
 		//
 		directory_node_t(std::shared_ptr<TempFileSystem> const& filesystem, uapi_mode_t nodemode, uapi_uid_t userid, uapi_gid_t groupid);
@@ -414,6 +559,36 @@ private:
 		// Creates a new directory_node_t instance on the file system private heap
 		static std::shared_ptr<directory_node_t> allocate_shared(std::shared_ptr<TempFileSystem> const& fs, uapi_mode_t mode, uapi_uid_t uid, uapi_gid_t gid);
 
+		// contains
+		//
+		// Determines if a node is this directory or is located anywhere beneath it
+		bool contains(node_t const* node);
+
+		// cookie (static)
+		//
+		// Generates the stable enumeration cookie for a child node name
+		static size_t cookie(std::string const& name);
+
+		// entries
+		//
+		// Gets up to count child entries positioned after a cookie, in cookie order
+		void entries(sync::distributed_reader_writer_lock::scoped_lock& lock, size_t position, size_t count, std::vector<entry_t>& result) const;
+
+		// materialize
+		//
+		// Populates a cloned directory with clones of the origin directory child nodes
+		void materialize(void);
+
+		// seal
+		//
+		// Seals this directory and every directory beneath it, returns the number sealed
+		size_t seal(void);
+
+		// unseal
+		//
+		// Discards the sealed lookup table; nodeslock must be held for exclusive access
+		void unseal(void);
+
 		//-------------------------------------------------------------------
 		// Fields
 
@@ -425,12 +600,32 @@ private:
 		// nodeslock
 		//
 		// Synchronization object
-		sync::reader_writer_lock nodeslock;
+		sync::distributed_reader_writer_lock nodeslock;
+
+		// cloned
+		//
+		// Flag indicating that the directory has not yet been materialized from origin
+		std::atomic<bool> cloned;
+
+		// origin
+		//
+		// Directory that a cloned directory will be materialized from; requires nodeslock
+		std::shared_ptr<directory_node_t> origin;
+
+		// sealed
+		//
+		// Sealed lookup table, if any; read without holding nodeslock
+		std::atomic<sealed_t const*> sealed;
 
 	private:
 
 		directory_node_t(directory_node_t const&)=delete;
 		directory_node_t& operator=(directory_node_t const&)=delete;
+
+		//-------------------------------------------------------------------
+		// Member Variables
+
+		std::vector<std::shared_ptr<sealed_t>, allocator_t<std::shared_ptr<sealed_t>>>	m_sealtables;	// Current and retired tables
 	};
 
 	// file_node_t
@@ -461,6 +656,17 @@ private:
 		// Creates a new file_node_t instance on the file system private heap
 		static std::shared_ptr<file_node_t> allocate_shared(std::shared_ptr<TempFileSystem> const& fs, uapi_mode_t mode, uapi_uid_t uid, uapi_gid_t gid);
 
+		// contents
+		//
+		// Gets the file data, which may be shared with the origin node; requires datalock
+		data_t const& contents(void) const;
+
+		// diverge
+		//
+		// Copies up to length bytes of shared origin data into this node; requires 
+		// datalock to be held for exclusive access
+		void diverge(size_t length = SIZE_MAX);
+
 		//-------------------------------------------------------------------
 		// Fields
 
@@ -469,11 +675,21 @@ private:
 		// File data stored in a vector<> instance
 		data_t data;
 
+		// origin
+		//
+		// Frozen file node whose data is shared until this node is written; requires datalock
+		std::shared_ptr<file_node_t> origin;
+
 		// datalock
 		//
-		// Synchronization object
+		// Synchronization object; held exclusively to change the data size
 		sync::reader_writer_lock datalock;
 
+		// rangelock
+		//
+		// Byte range synchronization object; requires datalock to be held
+		sync::range_lock rangelock;
+
 	private:
 
 		file_node_t(file_node_t const&)=delete;
@@ -522,6 +738,74 @@ private:
 		symlink_node_t& operator=(symlink_node_t const&)=delete;
 	};
 
+	// clonemap_t
+	//
+	// Origin nodes that have been cloned into a file system; a node that has been linked
+	// into more than one directory must only be cloned once to preserve the links.  Keys
+	// are ordered by owner so a released origin node cannot be mistaken for another
+	using clonemap_t = std::map<std::weak_ptr<node_t>, std::weak_ptr<node_t>, std::owner_less<std::weak_ptr<node_t>>>;
+
+	// dirlock_t
+	//
+	// Acquires the nodeslock of multiple directory nodes in ascending node index
+	// order; all operations that lock more than one directory must use this
+	class dirlock_t
+	{
+	public:
+
+		// Instance Constructor
+		//
+		dirlock_t();
+
+		// Destructor
+		//
+		~dirlock_t();
+
+		//-------------------------------------------------------------------
+		// Member Functions
+
+		// add
+		//
+		// Adds a directory node to the set of nodes to be locked
+		void add(directory_node_t* node, bool exclusive);
+
+		// lock
+		//
+		// Locks all of the directory nodes in ascending node index order
+		void lock(void);
+
+		// unlock
+		//
+		// Unlocks all of the directory nodes in reverse order
+		void unlock(void);
+
+	private:
+
+		dirlock_t(dirlock_t const&)=delete;
+		dirlock_t& operator=(dirlock_t const&)=delete;
+
+		// MAX_NODES
+		//
+		// Maximum number of directory nodes that can be locked
+		static const size_t MAX_NODES = 3;
+
+		// entry_t
+		//
+		// Directory node and requested access
+		struct entry_t
+		{
+			directory_node_t*		node;			// Directory node to be locked
+			bool					exclusive;		// Flag to lock for exclusive access
+		};
+
+		//-------------------------------------------------------------------
+		// Member Variables
+
+		entry_t						m_entries[MAX_NODES];	// Directory nodes
+		size_t						m_count;				// Number of directory nodes
+		bool						m_held;					// Flag if the locks are held
+	};
+
 	// Node
 	//
 	// Implements VirtualMachine::Node
@@ -537,6 +821,16 @@ private:
 		//-------------------------------------------------------------------
 		// Member Functions
 
+		// operator new (static)
+		//
+		// Allocates node instances from the file system free list
+		static void* operator new(size_t size) { return freelist<TempFileSystem>::allocate(size); }
+
+		// operator delete (static)
+		//
+		// Releases node instances back into the file system free list
+		static void operator delete(void* ptr, size_t size) { freelist<TempFileSystem>::release(ptr, size); }
+
 		// SetAccessTime (VirtualMachine::Node)
 		//
 		// Changes the access time of this node
@@ -703,6 +997,8 @@ private:
 	class Directory : public Node<VirtualMachine::Directory, directory_node_t>
 	{
 	friend class TempFileSystem;
+	friend std::unique_ptr<VirtualMachine::Mount> CloneTempFileSystem(VirtualMachine::Mount const* source, uint32_t flags);
+	friend size_t SealTempFileSystem(VirtualMachine::Mount const* mount, VirtualMachine::Node const* directory);
 	public:
 
 		// Instance Constructors
@@ -756,6 +1052,11 @@ private:
 		// Looks up a child node of this directory by name
 		virtual std::unique_ptr<VirtualMachine::Node> Lookup(VirtualMachine::Mount const* mount, char_t const* name) override;
 
+		// Rename (VirtualMachine::Directory)
+		//
+		// Atomically renames or exchanges a child node of this directory
+		virtual void Rename(VirtualMachine::Mount const* mount, char_t const* oldname, VirtualMachine::Directory const* newdir, char_t const* newname, uint32_t flags) override;
+
 		// Unlink (VirtualMachine::Directory)
 		//
 		// Unlinks a child node from this directory
@@ -795,6 +1096,11 @@ private:
 		// Enumerates all of the children of this node
 		virtual void Enumerate(std::function<bool(VirtualMachine::DirectoryEntry const&)> func) override;
 
+		// ReadEntries (VirtualMachine::DirectoryHandle)
+		//
+		// Writes directory entry records into a buffer, resuming from the current position
+		virtual size_t ReadEntries(VirtualMachine::DirectoryEntryFormat format, void* buffer, size_t length) override;
+
 		// Seek (VirtualMachine::Handle)
 		//
 		// Changes the file position
@@ -865,7 +1171,7 @@ private:
 
 		// Instance Constructor
 		//
-		FileHandle(std::shared_ptr<handle_t<file_node_t>> const& handle, uint32_t flags, uint32_t mountflags);
+		FileHandle(std::shared_ptr<handle_t<file_node_t>> const& handle, uint32_t flags, uint32_t mountflags, std::shared_ptr<MountStatistics> const& stats);
 
 		// Destructor
 		//
@@ -923,6 +1229,7 @@ private:
 		// Protected Member Variables
 
 		std::shared_ptr<handle_t<file_node_t>>	m_handle;	// Shared handle_t
+		std::shared_ptr<MountStatistics>		m_stats;	// Mount statistics
 	};
 
 	// Mount
@@ -930,6 +1237,7 @@ private:
 	// Implements VirtualMachine::Mount
 	class Mount : public VirtualMachine::Mount
 	{
+	friend class File;
 	public:
 
 		// Instance Constructor
@@ -973,6 +1281,12 @@ private:
 		__declspec(property(get=getRootNode)) VirtualMachine::Node* RootNode;
 		virtual VirtualMachine::Node* getRootNode(void) const override;
 
+		// Statistics (VirtualMachine::Mount)
+		//
+		// Gets a pointer to the mount point operation statistics
+		__declspec(property(get=getStatistics)) MountStatistics* Statistics;
+		virtual MountStatistics* getStatistics(void) const override;
+
 	private:
 
 		Mount& operator=(Mount const&)=delete;
@@ -983,6 +1297,7 @@ private:
 		std::shared_ptr<TempFileSystem>		m_fs;		// File system instance
 		std::shared_ptr<Directory>			m_rootdir;	// Root node instance
 		std::atomic<uint32_t>				m_flags;	// Mount-specific flags
+		std::shared_ptr<MountStatistics>	m_stats;	// Mount statistics
 	};
 
 	// SymbolicLink
@@ -1076,6 +1391,11 @@ private:
 	// Allocates memory from the private heap
 	void* AllocateHeap(size_t bytecount, bool zeroinit = false);
 
+	// CloneNode (static)
+	//
+	// Creates a clone of a node from a frozen file system
+	static std::shared_ptr<node_t> CloneNode(std::shared_ptr<TempFileSystem> const& fs, std::shared_ptr<node_t> const& origin);
+
 	// ReallocateHeap
 	//
 	// Reallocates memory in the private heap
@@ -1090,8 +1410,13 @@ private:
 	// Member Variables
 
 	HANDLE							m_heap;			// Private heap handle
-	size_t							m_heapsize;		// Currently allocated heap size
+	std::atomic<size_t>				m_heapsize;		// Currently allocated heap size
+	std::atomic<size_t>				m_heappeak;		// Peak allocated heap size
+	std::atomic<uint64_t>			m_heapallocs;	// Number of heap allocations
 	sync::critical_section			m_heaplock;		// Heap synchronization object
+	sync::critical_section			m_renamelock;	// Cross-directory rename serialization
+	sync::critical_section			m_clonelock;	// Cloned node map synchronization
+	clonemap_t						m_clones;		// Origin nodes cloned into this file system
 };
 
 //-----------------------------------------------------------------------------
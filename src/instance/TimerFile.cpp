@@ -0,0 +1,330 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TimerFile.h"
+
+#include <convert.h>
+#include <datetime.h>
+
+#include "LinuxException.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// TimerFile Constructor
+//
+// Arguments:
+//
+//	wheel		- Timer wheel that services the timer
+//	clockid		- Clock that the timer is measured against
+//	flags		- TFD_XXXX flags
+
+TimerFile::TimerFile(TimerWheel& wheel, int clockid, int flags) : TimerFile(std::make_shared<timerfd_t>(), 
+	UAPI_O_RDONLY | (flags & (UAPI_TFD_CLOEXEC | UAPI_TFD_NONBLOCK)))
+{
+	if(flags & ~(UAPI_TFD_CLOEXEC | UAPI_TFD_NONBLOCK)) throw LinuxException(UAPI_EINVAL);
+	if((clockid != UAPI_CLOCK_REALTIME) && (clockid != UAPI_CLOCK_MONOTONIC) && (clockid != UAPI_CLOCK_BOOTTIME)) throw LinuxException(UAPI_EINVAL);
+
+	m_timerfd->clockid = clockid;
+	m_timerfd->expirations = 0;
+
+	// The timer is owned by the shared timer object, which cannot be released before the timer is
+	timerfd_t* timerfd = m_timerfd.get();
+	m_timerfd->timer = wheel.CreateTimer([=](uint64_t expirations) -> void { Expire(*timerfd, expirations); });
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile Constructor (private)
+//
+// Arguments:
+//
+//	timerfd		- Shared timer object
+//	flags		- Handle-level flags
+
+TimerFile::TimerFile(std::shared_ptr<timerfd_t> const& timerfd, uint32_t flags) : m_timerfd(timerfd), m_flags(flags)
+{
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::getClockId
+//
+// Gets the clock that the timer is measured against
+
+int TimerFile::getClockId(void) const
+{
+	return m_timerfd->clockid;
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Duplicate
+//
+// Duplicates this Handle instance
+//
+// Arguments:
+//
+//	flags		- Handle-level flags for the duplicate
+
+std::unique_ptr<VirtualMachine::Handle> TimerFile::Duplicate(uint32_t flags) const
+{
+	return std::unique_ptr<TimerFile>(new TimerFile(m_timerfd, flags));
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Expire
+//
+// Adds timer expirations to the handle and signals any waiters
+//
+// Arguments:
+//
+//	expirations	- Number of timer expirations to add
+
+void TimerFile::Expire(uint64_t expirations)
+{
+	Expire(*m_timerfd, expirations);
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Expire (private, static)
+//
+// Adds timer expirations to a timer object and signals any waiters
+//
+// Arguments:
+//
+//	timerfd		- Timer object to be signaled
+//	expirations	- Number of timer expirations to add
+
+void TimerFile::Expire(timerfd_t& timerfd, uint64_t expirations)
+{
+	if(expirations == 0) return;
+
+	sync::critical_section::scoped_lock lock(timerfd.lock);
+	timerfd.expirations += expirations;
+	lock.unlock();
+
+	// The wait queue must be notified without holding the timer object lock
+	timerfd.waitqueue.Notify(UAPI_EPOLLIN | UAPI_EPOLLRDNORM);
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::getFlags
+//
+// Gets the handle-level flags applied to this instance
+
+uint32_t TimerFile::getFlags(void) const
+{
+	return m_flags;
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::GetTime
+//
+// Gets the current setting of the timer (timerfd_gettime)
+//
+// Arguments:
+//
+//	NONE
+
+uapi_itimerspec TimerFile::GetTime(void) const
+{
+	uapi_itimerspec		result;			// Current timer setting
+
+	result.it_interval = convert<uapi_timespec>(m_timerfd->timer->Period);
+	result.it_value = convert<uapi_timespec>(m_timerfd->timer->Remaining);
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Poll
+//
+// Gets the set of events (EPOLLIN, EPOLLOUT, ...) currently signaled
+//
+// Arguments:
+//
+//	NONE
+
+uint32_t TimerFile::Poll(void) const
+{
+	sync::critical_section::scoped_lock lock(m_timerfd->lock);
+	return (m_timerfd->expirations > 0) ? UAPI_EPOLLIN | UAPI_EPOLLRDNORM : 0;
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Read
+//
+// Reads the 8-byte number of expirations that have occurred
+//
+// Arguments:
+//
+//	buffer		- Destination buffer
+//	count		- Size of the destination buffer, in bytes
+
+size_t TimerFile::Read(void* buffer, size_t count)
+{
+	uint64_t		value;				// Number of expirations
+
+	if(buffer == nullptr) throw LinuxException(UAPI_EFAULT);
+	if(count < sizeof(uint64_t)) throw LinuxException(UAPI_EINVAL);
+
+	while(true) {
+
+		// Capture the wait queue generation before checking the expirations to avoid a lost wakeup
+		uint32_t generation = m_timerfd->waitqueue.Generation;
+
+		sync::critical_section::scoped_lock lock(m_timerfd->lock);
+
+		if(m_timerfd->expirations > 0) {
+
+			value = m_timerfd->expirations;
+			m_timerfd->expirations = 0;
+			break;
+		}
+
+		lock.unlock();
+
+		if(m_flags & UAPI_O_NONBLOCK) throw LinuxException(UAPI_EAGAIN);
+		m_timerfd->waitqueue.Wait(generation, INFINITE);
+	}
+
+	*reinterpret_cast<uint64_t*>(buffer) = value;
+	return sizeof(uint64_t);
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Seek
+//
+// Changes the file position
+//
+// Arguments:
+//
+//	offset		- Offset into the file
+//	whence		- Starting position for the offset
+
+size_t TimerFile::Seek(ssize_t offset, int whence)
+{
+	UNREFERENCED_PARAMETER(offset);
+	UNREFERENCED_PARAMETER(whence);
+
+	throw LinuxException(UAPI_ESPIPE);
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::SetTime
+//
+// Arms or disarms the timer, returns the previous setting (timerfd_settime)
+//
+// Arguments:
+//
+//	flags		- TFD_TIMER_XXXX flags
+//	value		- New initial expiration and interval of the timer
+
+uapi_itimerspec TimerFile::SetTime(int flags, uapi_itimerspec const& value)
+{
+	if(flags & ~(UAPI_TFD_TIMER_ABSTIME | UAPI_TFD_TIMER_CANCEL_ON_SET)) throw LinuxException(UAPI_EINVAL);
+
+	// A zero initial expiration disarms the timer regardless of the interval
+	bool arm = (value.it_value.tv_sec != 0) || (value.it_value.tv_nsec != 0);
+
+	try {
+
+		timespan due = convert<timespan>(value.it_value);
+		timespan period = convert<timespan>(value.it_interval);
+
+		// Absolute expirations are converted into a relative expiration against the timer clock
+		if(arm && (flags & UAPI_TFD_TIMER_ABSTIME)) {
+
+			if(m_timerfd->clockid == UAPI_CLOCK_REALTIME) {
+
+				datetime now = datetime::now();
+				datetime expires = convert<datetime>(value.it_value);
+				due = (expires > now) ? expires.difference(now) : timespan::zero;
+			}
+
+			else {
+
+				timespan now = TimerWheel::Now();
+				due = (due > now) ? due - now : timespan::zero;
+			}
+		}
+
+		uapi_itimerspec previous = GetTime();
+
+		// Cancel the timer before taking the lock; this waits for a running expiration callback
+		m_timerfd->timer->Cancel();
+
+		sync::critical_section::scoped_lock lock(m_timerfd->lock);
+
+		m_timerfd->expirations = 0;
+		if(arm) m_timerfd->timer->Arm(due, period);
+
+		return previous;
+	}
+
+	catch(std::out_of_range&) { throw LinuxException(UAPI_EINVAL); }
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Sync
+//
+// Synchronizes all data associated with the file to storage, not metadata
+//
+// Arguments:
+//
+//	NONE
+
+void TimerFile::Sync(void) const
+{
+	throw LinuxException(UAPI_EINVAL);
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::getWaitQueue
+//
+// Gets the wait queue that is notified when the signaled events change
+
+PollQueue* TimerFile::getWaitQueue(void) const
+{
+	return &m_timerfd->waitqueue;
+}
+
+//-----------------------------------------------------------------------------
+// TimerFile::Write
+//
+// Timer handles cannot be written to
+//
+// Arguments:
+//
+//	buffer		- Source buffer
+//	count		- Size of the source buffer, in bytes
+
+size_t TimerFile::Write(const void* buffer, size_t count)
+{
+	UNREFERENCED_PARAMETER(buffer);
+	UNREFERENCED_PARAMETER(count);
+
+	throw LinuxException(UAPI_EINVAL);
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
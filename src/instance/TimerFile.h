@@ -0,0 +1,161 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __TIMERFILE_H_
+#define __TIMERFILE_H_
+#pragma once
+
+#include <memory>
+#include <sync.h>
+
+#include "PollQueue.h"
+#include "TimerWheel.h"
+#include "VirtualMachine.h"
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// TimerFile
+//
+// Implements a timerfd_create(2) timer notification handle; the expirations are
+// delivered to the handle by a timer that is serviced by the instance timer wheel
+
+class TimerFile : public VirtualMachine::PollableHandle
+{
+public:
+
+	// Instance Constructor
+	//
+	TimerFile(TimerWheel& wheel, int clockid, int flags);
+
+	// Destructor
+	//
+	virtual ~TimerFile()=default;
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Duplicate (VirtualMachine::Handle)
+	//
+	// Duplicates this Handle instance
+	virtual std::unique_ptr<VirtualMachine::Handle> Duplicate(uint32_t flags) const override;
+
+	// Expire
+	//
+	// Adds timer expirations to the handle and signals any waiters
+	void Expire(uint64_t expirations);
+
+	// GetTime
+	//
+	// Gets the current setting of the timer (timerfd_gettime)
+	uapi_itimerspec GetTime(void) const;
+
+	// Poll (VirtualMachine::PollableHandle)
+	//
+	// Gets the set of events (EPOLLIN, EPOLLOUT, ...) currently signaled
+	virtual uint32_t Poll(void) const override;
+
+	// Read (VirtualMachine::Handle)
+	//
+	// Reads the 8-byte number of expirations that have occurred
+	virtual size_t Read(void* buffer, size_t count) override;
+
+	// Seek (VirtualMachine::Handle)
+	//
+	// Changes the file position
+	virtual size_t Seek(ssize_t offset, int whence) override;
+
+	// SetTime
+	//
+	// Arms or disarms the timer, returns the previous setting (timerfd_settime)
+	uapi_itimerspec SetTime(int flags, uapi_itimerspec const& value);
+
+	// Sync (VirtualMachine::Handle)
+	//
+	// Synchronizes all data associated with the file to storage, not metadata
+	virtual void Sync(void) const override;
+
+	// Write (VirtualMachine::Handle)
+	//
+	// Timer handles cannot be written to
+	virtual size_t Write(const void* buffer, size_t count) override;
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// ClockId
+	//
+	// Gets the clock that the timer is measured against
+	__declspec(property(get=getClockId)) int ClockId;
+	int getClockId(void) const;
+
+	// Flags (VirtualMachine::Handle)
+	//
+	// Gets the handle-level flags applied to this instance
+	virtual uint32_t getFlags(void) const override;
+
+	// WaitQueue (VirtualMachine::PollableHandle)
+	//
+	// Gets the wait queue that is notified when the signaled events change
+	virtual PollQueue* getWaitQueue(void) const override;
+
+private:
+
+	TimerFile(TimerFile const&)=delete;
+	TimerFile& operator=(TimerFile const&)=delete;
+
+	// timerfd_t
+	//
+	// Timer object shared among all handles
+	struct timerfd_t
+	{
+		sync::critical_section				lock;			// Synchronization object
+		int									clockid;		// Timer clock identifier
+		uint64_t							expirations;	// Unread expirations
+		PollQueue							waitqueue;		// Wait queue
+		std::unique_ptr<TimerWheel::Timer>	timer;			// Timer wheel timer
+	};
+
+	// Instance Constructor
+	//
+	TimerFile(std::shared_ptr<timerfd_t> const& timerfd, uint32_t flags);
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// Expire (static)
+	//
+	// Adds timer expirations to a timer object and signals any waiters
+	static void Expire(timerfd_t& timerfd, uint64_t expirations);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	std::shared_ptr<timerfd_t> const	m_timerfd;		// Shared timer object
+	uint32_t const						m_flags;		// Handle-level flags
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __TIMERFILE_H_
@@ -0,0 +1,599 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <Win32Exception.h>
+
+#pragma comment(lib, "synchronization.lib")
+#pragma comment(lib, "winmm.lib")
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// TimerWheel Constructor
+//
+// Arguments:
+//
+//	NONE
+
+TimerWheel::TimerWheel() : m_slots{}, m_expired(nullptr), m_current(static_cast<uint64_t>(Now()) / TICK), m_count(0), 
+	m_nextwake(UINT64_MAX), m_running(nullptr), m_stop(false)
+{
+	m_wakeevent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if(m_wakeevent == nullptr) throw Win32Exception();
+
+	m_thread = CreateThread(nullptr, 0, ServiceThread, this, 0, &m_threadid);
+	if(m_thread == nullptr) { CloseHandle(m_wakeevent); throw Win32Exception(); }
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel Destructor
+
+TimerWheel::~TimerWheel()
+{
+	// All timers must have been destroyed before the timer wheel
+	_ASSERTE((m_count == 0) && (m_precise.empty()) && (m_expired == nullptr));
+
+	m_stop = true;
+	SetEvent(m_wakeevent);
+	WaitForSingleObject(m_thread, INFINITE);
+
+	CloseHandle(m_thread);
+	CloseHandle(m_wakeevent);
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Advance (private)
+//
+// Advances the wheel to the specified time, collecting expired timers
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock (unused)
+//	now			- Current timer wheel time
+
+void TimerWheel::Advance(sync::critical_section::scoped_lock& lock, uint64_t now)
+{
+	uint64_t target = now / TICK;
+
+	while(m_current <= target) {
+
+		// When the wheel is empty there is nothing to cascade or expire, jump ahead
+		if(m_count == 0) { m_current = target + 1; break; }
+
+		size_t index = static_cast<size_t>(m_current & SLOT_MASK);
+
+		// Each time the first level wraps around, cascade the next slot of the upper level(s)
+		if(index == 0) {
+
+			for(size_t level = 1; level < LEVELS; level++) {
+
+				size_t cascade = static_cast<size_t>((m_current >> (SLOT_BITS * level)) & SLOT_MASK);
+				Cascade(lock, level, cascade);
+				if(cascade != 0) break;
+			}
+		}
+
+		Timer* timer = m_slots[0][index];
+		m_slots[0][index] = nullptr;
+
+		while(timer) {
+
+			Timer* next = timer->m_next;
+			timer->m_list = nullptr;
+			m_count--;
+
+			// Timers that are due move to the expired list; timers that were placed in the wheel by
+			// rounding down (no slack) are promoted to the high resolution queue for the remainder
+			if(timer->m_expires <= now) Link(&m_expired, timer);
+			else {
+
+				timer->m_iterator = m_precise.emplace(timer->m_expires, timer);
+				timer->m_precise = true;
+			}
+
+			timer = next;
+		}
+
+		m_current++;
+	}
+
+	// Move any high resolution timers that have become due to the expired list
+	auto iterator = m_precise.begin();
+	while((iterator != m_precise.end()) && (iterator->first <= now)) {
+
+		Timer* timer = iterator->second;
+		iterator = m_precise.erase(iterator);
+		timer->m_precise = false;
+		Link(&m_expired, timer);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Cascade (private)
+//
+// Redistributes the timers in a slot to the lower levels of the wheel
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock
+//	level		- Level of the wheel to be cascaded
+//	index		- Index of the slot within the level to be cascaded
+
+void TimerWheel::Cascade(sync::critical_section::scoped_lock& lock, size_t level, size_t index)
+{
+	_ASSERTE((level > 0) && (level < LEVELS) && (index < SLOTS));
+
+	Timer* timer = m_slots[level][index];
+	m_slots[level][index] = nullptr;
+
+	while(timer) {
+
+		Timer* next = timer->m_next;
+		timer->m_list = nullptr;
+		m_count--;
+
+		Insert(lock, timer);
+		timer = next;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::CreateTimer
+//
+// Creates a new unarmed timer associated with this timer wheel
+//
+// Arguments:
+//
+//	callback	- Function to invoke from the service thread when the timer expires
+
+std::unique_ptr<TimerWheel::Timer> TimerWheel::CreateTimer(std::function<void(uint64_t expirations)> callback)
+{
+	return std::unique_ptr<Timer>(new Timer(this, std::move(callback)));
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Insert (private)
+//
+// Inserts a timer into the wheel or the precise queue
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock (unused)
+//	timer		- Timer to be inserted
+
+void TimerWheel::Insert(sync::critical_section::scoped_lock& lock, Timer* timer)
+{
+	UNREFERENCED_PARAMETER(lock);
+	_ASSERTE((timer->m_list == nullptr) && (!timer->m_precise));
+
+	// Timers without slack are rounded down and promoted when they come due, timers with
+	// slack are rounded up and coalesced to the tick with the most trailing zero bits that 
+	// falls within the slack range, this mimics apply_slack() from the linux kernel
+	uint64_t tick = timer->m_expires / TICK;
+	if(timer->m_slack) {
+
+		if(timer->m_expires % TICK) tick++;
+
+		uint64_t limit = (timer->m_slack > (UINT64_MAX - timer->m_expires)) ? UINT64_MAX / TICK : (timer->m_expires + timer->m_slack) / TICK;
+		if(limit > tick) {
+
+			uint64_t mask = tick ^ limit;
+			unsigned long bit = 0;
+#ifdef _M_X64
+			_BitScanReverse64(&bit, mask);
+#else
+			if(mask >> 32) { _BitScanReverse(&bit, static_cast<unsigned long>(mask >> 32)); bit += 32; }
+			else _BitScanReverse(&bit, static_cast<unsigned long>(mask));
+#endif
+			tick = limit & ~((1ui64 << bit) - 1);
+		}
+	}
+
+	timer->m_tick = tick;
+
+	// Timers without slack that are due in the immediate future go directly to the high resolution queue
+	if((timer->m_slack == 0) && (tick < m_current + PRECISE_THRESHOLD)) {
+
+		timer->m_iterator = m_precise.emplace(timer->m_expires, timer);
+		timer->m_precise = true;
+		return;
+	}
+
+	// Expirations that have already passed are placed into the next slot to be processed, and
+	// expirations beyond the range of the wheel are placed in the last slot and re-cascaded
+	uint64_t delta = (tick > m_current) ? tick - m_current : 0;
+	if(delta >= (1ui64 << (SLOT_BITS * LEVELS))) delta = (1ui64 << (SLOT_BITS * LEVELS)) - 1;
+
+	size_t level = 0;
+	while((level < (LEVELS - 1)) && (delta >= (1ui64 << (SLOT_BITS * (level + 1))))) level++;
+
+	size_t index = static_cast<size_t>(((m_current + delta) >> (SLOT_BITS * level)) & SLOT_MASK);
+	Link(&m_slots[level][index], timer);
+	m_count++;
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Link (private, static)
+//
+// Links a timer into the head of a list
+//
+// Arguments:
+//
+//	list		- List head to link the timer into
+//	timer		- Timer to be linked into the list
+
+void TimerWheel::Link(Timer** list, Timer* timer)
+{
+	_ASSERTE(timer->m_list == nullptr);
+
+	timer->m_list = list;
+	timer->m_prev = nullptr;
+	timer->m_next = *list;
+
+	if(*list) (*list)->m_prev = timer;
+	*list = timer;
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::NextExpiration (private)
+//
+// Determines the next time that the service thread needs to run
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock (unused)
+
+uint64_t TimerWheel::NextExpiration(sync::critical_section::scoped_lock& lock) const
+{
+	UNREFERENCED_PARAMETER(lock);
+
+	uint64_t next = (m_precise.empty()) ? UINT64_MAX : m_precise.begin()->first;
+	if(m_count == 0) return next;
+
+	// The first level contains only the ticks that precede the next cascade, look for the
+	// first occupied slot in that range otherwise wake up at the next cascade boundary
+	uint64_t tick = (m_current | SLOT_MASK) + 1;
+	for(uint64_t offset = 0; offset < SLOTS; offset++) {
+
+		if(m_slots[0][(m_current + offset) & SLOT_MASK]) { tick = m_current + offset; break; }
+	}
+
+	return std::min(next, tick * TICK);
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Now (static)
+//
+// Gets the current monotonic time used by the timer wheel
+//
+// Arguments:
+//
+//	NONE
+
+timespan TimerWheel::Now(void)
+{
+	static uint64_t const frequency = []() -> uint64_t {
+
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return static_cast<uint64_t>(frequency.QuadPart);
+	}();
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	// Convert the performance counter into 100ns units without overflowing the intermediate
+	uint64_t qpc = static_cast<uint64_t>(counter.QuadPart);
+	return timespan(((qpc / frequency) * 10000000ui64) + (((qpc % frequency) * 10000000ui64) / frequency));
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Remove (private)
+//
+// Removes a timer from the wheel, precise queue or expired list
+//
+// Arguments:
+//
+//	lock		- Reference to a scoped_lock (unused)
+//	timer		- Timer to be removed
+
+bool TimerWheel::Remove(sync::critical_section::scoped_lock& lock, Timer* timer)
+{
+	UNREFERENCED_PARAMETER(lock);
+
+	if(timer->m_precise) {
+
+		m_precise.erase(timer->m_iterator);
+		timer->m_precise = false;
+		return true;
+	}
+
+	if(timer->m_list == nullptr) return false;
+
+	// Timers in the expired list are no longer counted as being in the wheel
+	if(timer->m_list != &m_expired) m_count--;
+
+	if(timer->m_prev) timer->m_prev->m_next = timer->m_next;
+	else *timer->m_list = timer->m_next;
+	if(timer->m_next) timer->m_next->m_prev = timer->m_prev;
+
+	timer->m_list = nullptr;
+	timer->m_prev = timer->m_next = nullptr;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::ServiceThread (private, static)
+//
+// Entry point for the timer wheel service thread
+//
+// Arguments:
+//
+//	arg			- Pointer to the TimerWheel instance
+
+DWORD WINAPI TimerWheel::ServiceThread(void* arg)
+{
+	TimerWheel* instance = reinterpret_cast<TimerWheel*>(arg);
+	_ASSERTE(instance);
+
+	// The default system timer resolution is far too coarse for a millisecond wheel
+	timeBeginPeriod(1);
+
+	while(!instance->m_stop) {
+
+		sync::critical_section::scoped_lock lock(instance->m_lock);
+
+		// The service thread is running; timers armed now will be seen without signaling it
+		instance->m_nextwake = 0;
+
+		uint64_t now = Now();
+		instance->Advance(lock, now);
+
+		// Invoke the callback for one expired timer at a time outside of the lock
+		if(instance->m_expired) {
+
+			Timer* timer = instance->m_expired;
+			instance->Remove(lock, timer);
+
+			// Periodic timers are rescheduled against their original expiration to prevent drift
+			uint64_t expirations = 1;
+			if(timer->m_period) {
+
+				expirations += (now - timer->m_expires) / timer->m_period;
+				timer->m_expires += expirations * timer->m_period;
+				instance->Insert(lock, timer);
+			}
+
+			instance->m_running = timer;
+			lock.unlock();
+
+			timer->m_callback(expirations);
+
+			instance->m_running = nullptr;
+			WakeByAddressAll(&instance->m_running);
+
+			continue;
+		}
+
+		uint64_t next = instance->NextExpiration(lock);
+		bool precise = (!instance->m_precise.empty()) && (next == instance->m_precise.begin()->first);
+		instance->m_nextwake = next;
+		lock.unlock();
+
+		now = Now();
+		if(next <= now) continue;
+
+		// High resolution deadlines are approached by waiting until they are within a tick and spinning
+		DWORD timeout = INFINITE;
+		if(next != UINT64_MAX) {
+
+			uint64_t remaining = next - now;
+			if(precise) {
+
+				if(remaining <= SPIN_THRESHOLD) {
+
+					while((static_cast<uint64_t>(Now()) < next) && (!instance->m_stop)) YieldProcessor();
+					continue;
+				}
+
+				remaining = (remaining - SPIN_THRESHOLD) / TICK;
+			}
+
+			else remaining = (remaining + TICK - 1) / TICK;
+
+			timeout = static_cast<DWORD>(std::min(remaining, static_cast<uint64_t>(INFINITE - 1)));
+		}
+
+		WaitForSingleObject(instance->m_wakeevent, timeout);
+	}
+
+	timeEndPeriod(1);
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Sleep
+//
+// Blocks the calling thread for the specified amount of time (nanosleep)
+//
+// Arguments:
+//
+//	duration	- Amount of time to block the calling thread
+
+void TimerWheel::Sleep(timespan duration)
+{
+	std::atomic<uint32_t>	signaled(0);		// Timer signaled flag
+	uint32_t				unsignaled = 0;		// Comparison value
+
+	std::unique_ptr<Timer> timer = CreateTimer([&](uint64_t) {
+
+		signaled = 1;
+		WakeByAddressAll(&signaled);
+	});
+
+	timer->Arm(duration, 0);
+	while(signaled == 0) WaitOnAddress(&signaled, &unsignaled, sizeof(uint32_t), INFINITE);
+}
+
+//
+// TIMERWHEEL::TIMER
+//
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Timer Constructor (private)
+//
+// Arguments:
+//
+//	wheel		- Owning TimerWheel instance
+//	callback	- Function to invoke when the timer expires
+
+TimerWheel::Timer::Timer(TimerWheel* wheel, std::function<void(uint64_t expirations)> const& callback) : m_wheel(wheel), 
+	m_callback(callback), m_expires(0), m_period(0), m_slack(0), m_tick(0), m_precise(false), m_list(nullptr), m_prev(nullptr), 
+	m_next(nullptr)
+{
+	_ASSERTE(wheel);
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Timer Destructor
+
+TimerWheel::Timer::~Timer()
+{
+	Cancel();
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Timer::Arm
+//
+// Arms (or re-arms) the timer relative to the current time
+//
+// Arguments:
+//
+//	due			- Amount of time until the first expiration
+//	period		- Period of the timer after the first expiration, or zero
+//	slack		- Amount of time that the expiration can be deferred for coalescing
+
+void TimerWheel::Timer::Arm(timespan due, timespan period)
+{
+	Arm(due, period, 0);
+}
+
+void TimerWheel::Timer::Arm(timespan due, timespan period, timespan slack)
+{
+	uint64_t now = Now();
+
+	sync::critical_section::scoped_lock lock(m_wheel->m_lock);
+	m_wheel->Remove(lock, this);
+
+	m_expires = (static_cast<uint64_t>(due) > (UINT64_MAX - now)) ? UINT64_MAX : now + due;
+	m_period = period;
+	m_slack = slack;
+
+	// If the wheel is empty the service thread may not have advanced it in some time
+	if(m_wheel->m_count == 0) m_wheel->m_current = std::max(m_wheel->m_current, now / TICK);
+
+	m_wheel->Insert(lock, this);
+
+	// Wake up the service thread if this timer expires before it was otherwise going to run
+	uint64_t wake = (m_precise) ? m_expires : m_tick * TICK;
+	if(wake < m_wheel->m_nextwake) {
+
+		m_wheel->m_nextwake = wake;
+		SetEvent(m_wheel->m_wakeevent);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Timer::getArmed
+//
+// Determines if the timer is currently armed
+
+bool TimerWheel::Timer::getArmed(void) const
+{
+	sync::critical_section::scoped_lock lock(m_wheel->m_lock);
+	return (m_precise) || (m_list != nullptr);
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Timer::Cancel
+//
+// Disarms the timer; waits for a running callback to complete
+//
+// Arguments:
+//
+//	NONE
+
+bool TimerWheel::Timer::Cancel(void)
+{
+	sync::critical_section::scoped_lock lock(m_wheel->m_lock);
+	bool result = m_wheel->Remove(lock, this);
+	lock.unlock();
+
+	// Wait for the callback to complete if it's running, unless this is the callback itself
+	if(GetCurrentThreadId() != m_wheel->m_threadid) {
+
+		Timer* running = m_wheel->m_running;
+		while(running == this) {
+
+			WaitOnAddress(&m_wheel->m_running, &running, sizeof(Timer*), INFINITE);
+			running = m_wheel->m_running;
+		}
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Timer::getPeriod
+//
+// Gets the period of the timer
+
+timespan TimerWheel::Timer::getPeriod(void) const
+{
+	sync::critical_section::scoped_lock lock(m_wheel->m_lock);
+	return m_period;
+}
+
+//-----------------------------------------------------------------------------
+// TimerWheel::Timer::getRemaining
+//
+// Gets the time remaining until the timer expires
+
+timespan TimerWheel::Timer::getRemaining(void) const
+{
+	uint64_t now = Now();
+
+	sync::critical_section::scoped_lock lock(m_wheel->m_lock);
+	if((!m_precise) && (m_list == nullptr)) return 0;
+
+	return (m_expires > now) ? m_expires - now : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
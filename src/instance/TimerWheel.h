@@ -0,0 +1,249 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __TIMERWHEEL_H_
+#define __TIMERWHEEL_H_
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sync.h>
+#include <timespan.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// TimerWheel
+//
+// Hierarchical timing wheel that services all of the timers for an instance
+// (nanosleep, timerfd, setitimer) from a single service thread.  Arming and
+// canceling a timer are O(1) operations; timers are cascaded down the levels of
+// the wheel as their expiration approaches.  Wheel timers are rounded up to the
+// next millisecond tick and may specify slack, which allows the expiration to
+// be coalesced with other timers.  Timers without slack that expire within the
+// next couple of ticks are promoted to a precise (high resolution) queue that is
+// not subject to the tick granularity of the wheel
+
+class TimerWheel
+{
+public:
+
+	// FORWARD DECLARATIONS
+	//
+	class Timer;
+
+	// Instance Constructor
+	//
+	TimerWheel();
+
+	// Destructor
+	//
+	~TimerWheel();
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// CreateTimer
+	//
+	// Creates a new unarmed timer associated with this timer wheel
+	std::unique_ptr<Timer> CreateTimer(std::function<void(uint64_t expirations)> callback);
+
+	// Now (static)
+	//
+	// Gets the current monotonic time used by the timer wheel
+	static timespan Now(void);
+
+	// Sleep
+	//
+	// Blocks the calling thread for the specified amount of time (nanosleep)
+	void Sleep(timespan duration);
+
+	//-------------------------------------------------------------------------
+	// Data Types
+
+	// Timer
+	//
+	// Individual timer object; the callback is invoked from the service thread
+	class Timer
+	{
+	friend class TimerWheel;
+	public:
+
+		// Destructor
+		//
+		~Timer();
+
+		//---------------------------------------------------------------------
+		// Member Functions
+
+		// Arm
+		//
+		// Arms (or re-arms) the timer relative to the current time
+		void Arm(timespan due, timespan period);
+		void Arm(timespan due, timespan period, timespan slack);
+
+		// Cancel
+		//
+		// Disarms the timer; waits for a running callback to complete
+		bool Cancel(void);
+
+		//---------------------------------------------------------------------
+		// Properties
+
+		// Armed
+		//
+		// Determines if the timer is currently armed
+		__declspec(property(get=getArmed)) bool Armed;
+		bool getArmed(void) const;
+
+		// Period
+		//
+		// Gets the period of the timer
+		__declspec(property(get=getPeriod)) timespan Period;
+		timespan getPeriod(void) const;
+
+		// Remaining
+		//
+		// Gets the time remaining until the timer expires
+		__declspec(property(get=getRemaining)) timespan Remaining;
+		timespan getRemaining(void) const;
+
+	private:
+
+		Timer(Timer const&)=delete;
+		Timer& operator=(Timer const&)=delete;
+
+		// Instance Constructor
+		//
+		Timer(TimerWheel* wheel, std::function<void(uint64_t expirations)> const& callback);
+
+		//---------------------------------------------------------------------
+		// Member Variables
+
+		TimerWheel* const							m_wheel;		// Owning timer wheel
+		std::function<void(uint64_t)> const			m_callback;		// Expiration callback
+		uint64_t									m_expires;		// Expiration time
+		uint64_t									m_period;		// Timer period
+		uint64_t									m_slack;		// Allowable slack
+		uint64_t									m_tick;			// Wheel expiration tick
+		bool										m_precise;		// High resolution timer
+		Timer**										m_list;			// Owning list head
+		Timer*										m_prev;			// Previous timer in list
+		Timer*										m_next;			// Next timer in list
+		std::multimap<uint64_t, Timer*>::iterator	m_iterator;		// Precise queue position
+	};
+
+private:
+
+	TimerWheel(TimerWheel const&)=delete;
+	TimerWheel& operator=(TimerWheel const&)=delete;
+
+	// precisequeue_t
+	//
+	// Queue of high resolution timers ordered by expiration time
+	using precisequeue_t = std::multimap<uint64_t, Timer*>;
+
+	// LEVELS / SLOTS
+	//
+	// Geometry of the timing wheel; each level is SLOTS times coarser than the last
+	static size_t const LEVELS		= 4;
+	static size_t const SLOT_BITS	= 6;
+	static size_t const SLOTS		= (1 << SLOT_BITS);
+	static size_t const SLOT_MASK	= (SLOTS - 1);
+
+	// PRECISE_THRESHOLD
+	//
+	// Timers without slack that expire within this many ticks are promoted
+	static uint64_t const PRECISE_THRESHOLD = 2;
+
+	// SPIN_THRESHOLD
+	//
+	// Deadlines closer than this (100ns units) are waited for by spinning
+	static uint64_t const SPIN_THRESHOLD = 20000;
+
+	// TICK
+	//
+	// Granularity of the timing wheel (1 millisecond in 100ns units)
+	static uint64_t const TICK = 10000;
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// Advance
+	//
+	// Advances the wheel to the specified time, collecting expired timers
+	void Advance(sync::critical_section::scoped_lock& lock, uint64_t now);
+
+	// Cascade
+	//
+	// Redistributes the timers in a slot to the lower levels of the wheel
+	void Cascade(sync::critical_section::scoped_lock& lock, size_t level, size_t index);
+
+	// Insert
+	//
+	// Inserts a timer into the wheel or the precise queue
+	void Insert(sync::critical_section::scoped_lock& lock, Timer* timer);
+
+	// Link (static)
+	//
+	// Links a timer into the head of a list
+	static void Link(Timer** list, Timer* timer);
+
+	// NextExpiration
+	//
+	// Determines the next time that the service thread needs to run
+	uint64_t NextExpiration(sync::critical_section::scoped_lock& lock) const;
+
+	// Remove
+	//
+	// Removes a timer from the wheel, precise queue or expired list
+	bool Remove(sync::critical_section::scoped_lock& lock, Timer* timer);
+
+	// ServiceThread (static)
+	//
+	// Entry point for the timer wheel service thread
+	static DWORD WINAPI ServiceThread(void* arg);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	mutable sync::critical_section	m_lock;						// Synchronization object
+	Timer*							m_slots[LEVELS][SLOTS];		// Timing wheel slots
+	precisequeue_t					m_precise;					// High resolution queue
+	Timer*							m_expired;					// Expired timers
+	uint64_t						m_current;					// Current wheel tick
+	size_t							m_count;					// Timers in the wheel
+	uint64_t						m_nextwake;					// Next service time
+	std::atomic<Timer*>				m_running;					// Running timer callback
+	std::atomic<bool>				m_stop;						// Service thread stop flag
+	HANDLE							m_wakeevent;				// Service thread wake event
+	HANDLE							m_thread;					// Service thread handle
+	DWORD							m_threadid;					// Service thread id
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __TIMERWHEEL_H_
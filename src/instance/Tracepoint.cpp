@@ -0,0 +1,315 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "Tracepoint.h"
+
+#include <algorithm>
+#include <new>
+#include <string.h>
+#include <Win32Exception.h>
+
+#pragma warning(push, 4)
+
+// Tracepoint::s_buffers (static)
+//
+// Allocated thread buffers
+std::atomic<Tracepoint::buffer_t*> Tracepoint::s_buffers{ nullptr };
+
+// Tracepoint::s_drainlock (static)
+//
+// Serializes drain operations
+sync::critical_section Tracepoint::s_drainlock{ "Tracepoint::s_drainlock" };
+
+// Tracepoint::s_nextid (static)
+//
+// Next tracepoint identifier
+std::atomic<uint32_t> Tracepoint::s_nextid{ 1 };
+
+// Tracepoint::s_tracepoints (static)
+//
+// Registered tracepoints; tracepoints register themselves during dynamic initialization
+// so this must remain constant-initialized
+std::atomic<Tracepoint*> Tracepoint::s_tracepoints{ nullptr };
+
+//-----------------------------------------------------------------------------
+// Tracepoint Constructor
+//
+// Arguments:
+//
+//	name		- Tracepoint name (must be a static string)
+
+Tracepoint::Tracepoint(char_t const* name) : m_name(name), m_id(s_nextid.fetch_add(1, std::memory_order_relaxed)), m_enabled(false), m_next(nullptr)
+{
+	_ASSERTE(name);
+
+	// Push this tracepoint onto the head of the registered tracepoints list
+	m_next = s_tracepoints.load(std::memory_order_relaxed);
+	while(!s_tracepoints.compare_exchange_weak(m_next, this, std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::Drain (static)
+//
+// Drains all buffered events to a file, returns the number of events written
+//
+// Arguments:
+//
+//	path		- Path to the output file
+
+size_t Tracepoint::Drain(tchar_t const* path)
+{
+	header_t			header = {};			// Trace file header
+	size_t				events = 0;				// Number of events written
+	LARGE_INTEGER		frequency;				// Performance counter frequency
+
+	if(path == nullptr) throw Win32Exception(ERROR_INVALID_PARAMETER);
+
+	sync::critical_section::scoped_lock cs{ s_drainlock };
+
+	// Generate the file header, the dropped event counters are reset by the drain
+	memcpy(header.magic, "VMTRACE", sizeof(header.magic));
+	header.version = 1;
+	QueryPerformanceFrequency(&frequency);
+	header.frequency = frequency.QuadPart;
+
+	for(Tracepoint* tracepoint = s_tracepoints.load(std::memory_order_acquire); tracepoint; tracepoint = tracepoint->m_next) header.tracepoints++;
+	for(buffer_t* buffer = s_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) header.dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+
+	// Create or overwrite the output file
+	HANDLE file = CreateFile(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE) throw Win32Exception();
+
+	try {
+
+		// WriteData (local)
+		//
+		// Writes a block of data into the output file
+		auto WriteData = [&](void const* data, size_t length) -> void {
+
+			DWORD written = 0;
+			if(!WriteFile(file, data, static_cast<DWORD>(length), &written, nullptr)) throw Win32Exception();
+		};
+
+		WriteData(&header, sizeof(header_t));
+
+		// Write the tracepoint identifier and name table
+		for(Tracepoint* tracepoint = s_tracepoints.load(std::memory_order_acquire); tracepoint; tracepoint = tracepoint->m_next) {
+
+			uint32_t length = static_cast<uint32_t>(strlen(tracepoint->m_name));
+
+			WriteData(&tracepoint->m_id, sizeof(uint32_t));
+			WriteData(&length, sizeof(uint32_t));
+			WriteData(tracepoint->m_name, length);
+		}
+
+		// Write the events from each of the thread buffers; the owning threads may continue to
+		// produce events while this is happening, only those visible at the start are drained
+		for(buffer_t* buffer = s_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+
+			uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+			uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+			while(tail != head) {
+
+				// Write the contiguous run of events up to the end of the ring
+				size_t index = static_cast<size_t>(tail & (BufferEvents - 1));
+				size_t count = std::min(static_cast<size_t>(head - tail), BufferEvents - index);
+
+				WriteData(&buffer->events[index], count * sizeof(Event));
+
+				tail += count;
+				events += count;
+			}
+
+			buffer->tail.store(tail, std::memory_order_release);
+		}
+	}
+
+	catch(...) { CloseHandle(file); throw; }
+
+	CloseHandle(file);
+
+	return events;
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::Enable (static)
+//
+// Enables or disables tracepoints by name, returns the number of matches
+//
+// Arguments:
+//
+//	names		- Comma-delimited list of tracepoint names or prefixes
+//	enable		- Flag to enable or disable the matching tracepoints
+
+size_t Tracepoint::Enable(char_t const* names, bool enable)
+{
+	size_t				matches = 0;			// Number of matching tracepoints
+
+	if(names == nullptr) return 0;
+
+	while(*names) {
+
+		// Skip over any leading delimiters and whitespace
+		while((*names == ',') || (*names == ' ')) names++;
+
+		// Find the end of the current name and check for a trailing wildcard
+		char_t const* end = names;
+		while(*end && (*end != ',') && (*end != ' ')) end++;
+
+		size_t length = static_cast<size_t>(end - names);
+		bool prefix = ((length > 0) && (names[length - 1] == '*'));
+		if(prefix) length--;
+
+		if((length > 0) || prefix) {
+
+			for(Tracepoint* tracepoint = s_tracepoints.load(std::memory_order_acquire); tracepoint; tracepoint = tracepoint->m_next) {
+
+				// Prefixes need only match the start of the name, otherwise the entire name must match
+				if(strncmp(tracepoint->m_name, names, length) != 0) continue;
+				if(!prefix && (tracepoint->m_name[length] != '\0')) continue;
+
+				tracepoint->m_enabled.store(enable, std::memory_order_relaxed);
+				matches++;
+			}
+		}
+
+		names = end;
+	}
+
+	return matches;
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::Enumerate (static)
+//
+// Enumerates all of the registered tracepoints
+//
+// Arguments:
+//
+//	func		- Function to invoke for each registered tracepoint
+
+void Tracepoint::Enumerate(std::function<void(Tracepoint const& tracepoint)> func)
+{
+	for(Tracepoint* tracepoint = s_tracepoints.load(std::memory_order_acquire); tracepoint; tracepoint = tracepoint->m_next) func(*tracepoint);
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::GetBuffer (private, static)
+//
+// Gets (or allocates) the event buffer for the calling thread
+//
+// Arguments:
+//
+//	NONE
+
+Tracepoint::buffer_t* Tracepoint::GetBuffer(void)
+{
+	__declspec(thread) static buffer_t* t_buffer = nullptr;
+
+	if(t_buffer) return t_buffer;
+
+	// Buffers are only allocated for threads that hit an enabled tracepoint; they are
+	// never released since the drain operation may still need to access them
+	buffer_t* buffer = new(std::nothrow) buffer_t;
+	if(buffer == nullptr) return nullptr;
+
+	buffer->head = buffer->tail = buffer->dropped = 0;
+
+	// Push the buffer onto the head of the allocated buffers list
+	buffer->next = s_buffers.load(std::memory_order_relaxed);
+	while(!s_buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed)) {}
+
+	t_buffer = buffer;
+	return t_buffer;
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::getEnabled
+//
+// Gets a flag indicating if the tracepoint has been enabled
+
+bool Tracepoint::getEnabled(void) const
+{
+	return m_enabled.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::getId
+//
+// Gets the tracepoint identifier written into events
+
+uint32_t Tracepoint::getId(void) const
+{
+	return m_id;
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::getName
+//
+// Gets the tracepoint name
+
+char_t const* Tracepoint::getName(void) const
+{
+	return m_name;
+}
+
+//-----------------------------------------------------------------------------
+// Tracepoint::Write (private)
+//
+// Writes an event for this tracepoint into the calling thread's buffer
+//
+// Arguments:
+//
+//	arg0 - arg3		- Tracepoint specific arguments
+
+void Tracepoint::Write(uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3)
+{
+	buffer_t* buffer = GetBuffer();
+	if(buffer == nullptr) return;
+
+	// Only the owning thread produces events into the buffer, if it is full the event is dropped
+	uint64_t head = buffer->head.load(std::memory_order_relaxed);
+	if((head - buffer->tail.load(std::memory_order_acquire)) >= BufferEvents) {
+
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Event& event = buffer->events[head & (BufferEvents - 1)];
+	QueryPerformanceCounter(reinterpret_cast<PLARGE_INTEGER>(&event.timestamp));
+
+	event.id = m_id;
+	event.threadid = GetCurrentThreadId();
+	event.args[0] = arg0;
+	event.args[1] = arg1;
+	event.args[2] = arg2;
+	event.args[3] = arg3;
+
+	// Publish the event to the consumer
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
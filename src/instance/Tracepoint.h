@@ -0,0 +1,193 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016 Michael G. Brehm
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef __TRACEPOINT_H_
+#define __TRACEPOINT_H_
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <sync.h>
+#include <text.h>
+
+#pragma warning(push, 4)
+
+//-----------------------------------------------------------------------------
+// Tracepoint
+//
+// Named static tracepoint.  Tracepoints are declared with static storage duration
+// and register themselves when constructed; a disabled tracepoint costs a single
+// relaxed load and branch.  When enabled, each hit writes a fixed-size binary event
+// into a lock-free ring buffer owned by the calling thread that can later be drained
+// to a file.  Events are dropped, and counted, if a thread's buffer is full.
+//
+// Tracepoints are named "subsystem:event"; Enable() accepts a comma-delimited list of
+// names where a trailing asterisk matches any name with that prefix ("vfs:*", "*")
+//
+// Drained trace file format:
+//
+//	header_t				- File header
+//	[tracepoint entries]	- uint32_t id, uint32_t length, char name[length]
+//	[events]				- Event structures until the end of the file
+
+class Tracepoint
+{
+public:
+
+	// Instance Constructor
+	//
+	Tracepoint(char_t const* name);
+
+	// Destructor
+	//
+	~Tracepoint()=default;
+
+	//-------------------------------------------------------------------------
+	// Fields
+
+	// BufferEvents
+	//
+	// Number of events that can be held in each per-thread buffer (power of two)
+	static size_t const BufferEvents = 1024;
+
+	//-------------------------------------------------------------------------
+	// Data Types
+
+	// Event
+	//
+	// Fixed-size binary event written for each tracepoint hit
+	struct Event
+	{
+		int64_t				timestamp;		// Performance counter value
+		uint32_t			id;				// Tracepoint identifier
+		uint32_t			threadid;		// Calling thread identifier
+		uint64_t			args[4];		// Tracepoint specific arguments
+	};
+
+	//-------------------------------------------------------------------------
+	// Member Functions
+
+	// Drain (static)
+	//
+	// Drains all buffered events to a file, returns the number of events written
+	static size_t Drain(tchar_t const* path);
+
+	// Enable (static)
+	//
+	// Enables or disables tracepoints by name, returns the number of matches
+	static size_t Enable(char_t const* names, bool enable);
+
+	// Enumerate (static)
+	//
+	// Enumerates all of the registered tracepoints
+	static void Enumerate(std::function<void(Tracepoint const& tracepoint)> func);
+
+	// Fire
+	//
+	// Writes an event for this tracepoint if it has been enabled
+	inline void Fire(uint64_t arg0 = 0, uint64_t arg1 = 0, uint64_t arg2 = 0, uint64_t arg3 = 0)
+	{
+		if(m_enabled.load(std::memory_order_relaxed)) Write(arg0, arg1, arg2, arg3);
+	}
+
+	//-------------------------------------------------------------------------
+	// Properties
+
+	// Enabled
+	//
+	// Gets a flag indicating if the tracepoint has been enabled
+	__declspec(property(get=getEnabled)) bool Enabled;
+	bool getEnabled(void) const;
+
+	// Id
+	//
+	// Gets the tracepoint identifier written into events
+	__declspec(property(get=getId)) uint32_t Id;
+	uint32_t getId(void) const;
+
+	// Name
+	//
+	// Gets the tracepoint name
+	__declspec(property(get=getName)) char_t const* Name;
+	char_t const* getName(void) const;
+
+private:
+
+	Tracepoint(Tracepoint const&)=delete;
+	Tracepoint& operator=(Tracepoint const&)=delete;
+
+	// buffer_t
+	//
+	// Per-thread single producer/single consumer event ring buffer
+	struct buffer_t
+	{
+		std::atomic<uint64_t>		head;					// Producer position
+		std::atomic<uint64_t>		dropped;				// Dropped events
+		buffer_t*					next;					// Next buffer in the list
+		Event						events[BufferEvents];	// Event ring
+		std::atomic<uint64_t>		tail;					// Consumer position
+	};
+
+	// header_t
+	//
+	// Drained trace file header
+	struct header_t
+	{
+		char				magic[8];		// "VMTRACE\0"
+		uint32_t			version;		// File format version
+		uint32_t			tracepoints;	// Number of tracepoint entries
+		int64_t				frequency;		// Performance counter frequency
+		uint64_t			dropped;		// Number of dropped events
+	};
+
+	//-------------------------------------------------------------------------
+	// Private Member Functions
+
+	// GetBuffer (static)
+	//
+	// Gets (or allocates) the event buffer for the calling thread
+	static buffer_t* GetBuffer(void);
+
+	// Write
+	//
+	// Writes an event for this tracepoint into the calling thread's buffer
+	void Write(uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3);
+
+	//-------------------------------------------------------------------------
+	// Member Variables
+
+	char_t const* const				m_name;			// Tracepoint name
+	uint32_t const					m_id;			// Tracepoint identifier
+	std::atomic<bool>				m_enabled;		// Enabled flag
+	Tracepoint*						m_next;			// Next registered tracepoint
+
+	static std::atomic<Tracepoint*>	s_tracepoints;	// Registered tracepoints
+	static std::atomic<buffer_t*>	s_buffers;		// Allocated thread buffers
+	static std::atomic<uint32_t>	s_nextid;		// Next tracepoint identifier
+	static sync::critical_section	s_drainlock;	// Serializes drain operations
+};
+
+//-----------------------------------------------------------------------------
+
+#pragma warning(pop)
+
+#endif	// __TRACEPOINT_H_
@@ -23,6 +23,8 @@
 #include "stdafx.h"
 #include "VirtualMachine.h"
 
+#include "LinuxException.h"
+
 #pragma warning(push, 4)
 
 //
@@ -37,6 +39,134 @@ VirtualMachine::AllocationFlags const VirtualMachine::AllocationFlags::None { 0x
 //
 VirtualMachine::AllocationFlags const VirtualMachine::AllocationFlags::TopDown { 0x01 };
 
+//
+// VIRTUALMACHINE::FILEHANDLE
+//
+
+//-----------------------------------------------------------------------------
+// VirtualMachine::FileHandle::ReadAtAsync
+//
+// Asynchronously reads data from the underlying node into a buffer; completes synchronously
+//
+// Arguments:
+//
+//	offset		- Offset within the node data to begin reading
+//	buffer		- Destination data buffer
+//	count		- Maximum number of bytes to read into the buffer
+//	completion	- Function to invoke when the operation has completed
+
+void VirtualMachine::FileHandle::ReadAtAsync(size_t offset, void* buffer, size_t count, IoCompletion const& completion)
+{
+	size_t					transferred = 0;		// Number of bytes transferred
+	std::exception_ptr		exception;				// Exception thrown by the operation
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try { transferred = ReadAt(offset, buffer, count); }
+	catch(...) { exception = std::current_exception(); }
+
+	completion(transferred, exception);
+}
+
+//-----------------------------------------------------------------------------
+// VirtualMachine::FileHandle::WriteAtAsync
+//
+// Asynchronously writes data from a buffer to the underlying node; completes synchronously
+//
+// Arguments:
+//
+//	offset		- Offset within the node data to begin writing
+//	buffer		- Source data buffer
+//	count		- Maximum number of bytes to write from the buffer
+//	completion	- Function to invoke when the operation has completed
+
+void VirtualMachine::FileHandle::WriteAtAsync(size_t offset, const void* buffer, size_t count, IoCompletion const& completion)
+{
+	size_t					transferred = 0;		// Number of bytes transferred
+	std::exception_ptr		exception;				// Exception thrown by the operation
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try { transferred = WriteAt(offset, buffer, count); }
+	catch(...) { exception = std::current_exception(); }
+
+	completion(transferred, exception);
+}
+
+//
+// VIRTUALMACHINE::HANDLE
+//
+
+//-----------------------------------------------------------------------------
+// VirtualMachine::Handle::ReadAsync
+//
+// Asynchronously reads data from the underlying node into a buffer; completes synchronously
+//
+// Arguments:
+//
+//	buffer		- Destination data buffer
+//	count		- Maximum number of bytes to read into the buffer
+//	completion	- Function to invoke when the operation has completed
+
+void VirtualMachine::Handle::ReadAsync(void* buffer, size_t count, IoCompletion const& completion)
+{
+	size_t					transferred = 0;		// Number of bytes transferred
+	std::exception_ptr		exception;				// Exception thrown by the operation
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try { transferred = Read(buffer, count); }
+	catch(...) { exception = std::current_exception(); }
+
+	completion(transferred, exception);
+}
+
+//-----------------------------------------------------------------------------
+// VirtualMachine::Handle::SyncAsync
+//
+// Asynchronously synchronizes the file data to storage; completes synchronously
+//
+// Arguments:
+//
+//	completion	- Function to invoke when the operation has completed
+
+void VirtualMachine::Handle::SyncAsync(IoCompletion const& completion) const
+{
+	size_t					transferred = 0;		// Number of bytes transferred
+	std::exception_ptr		exception;				// Exception thrown by the operation
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try { Sync(); }
+	catch(...) { exception = std::current_exception(); }
+
+	completion(transferred, exception);
+}
+
+//-----------------------------------------------------------------------------
+// VirtualMachine::Handle::WriteAsync
+//
+// Asynchronously writes data from a buffer to the underlying node; completes synchronously
+//
+// Arguments:
+//
+//	buffer		- Source data buffer
+//	count		- Maximum number of bytes to write from the buffer
+//	completion	- Function to invoke when the operation has completed
+
+void VirtualMachine::Handle::WriteAsync(const void* buffer, size_t count, IoCompletion const& completion)
+{
+	size_t					transferred = 0;		// Number of bytes transferred
+	std::exception_ptr		exception;				// Exception thrown by the operation
+
+	if(completion == nullptr) throw LinuxException(UAPI_EFAULT);
+
+	try { transferred = Write(buffer, count); }
+	catch(...) { exception = std::current_exception(); }
+
+	completion(transferred, exception);
+}
+
 //
 // VIRTUALMACHINE::PROTECTIONFLAGS
 //
@@ -24,6 +24,7 @@
 #define __VIRTUALMACHINE_H_
 #pragma once
 
+#include <exception>
 #include <functional>
 #include <bitmask.h>
 #include <stdint.h>
@@ -31,6 +32,11 @@
 
 #pragma warning(push, 4)
 
+// FORWARD DECLARATIONS
+//
+class MountStatistics;
+class PollQueue;
+
 //-----------------------------------------------------------------------------
 // Class VirtualMachine
 //
@@ -57,6 +63,7 @@ public:
 	struct Handle;
 	struct Mount;
 	struct Node;
+	struct PollableHandle;
 	struct SymbolicLink;
 	struct SymbolicLinkHandle;
 
@@ -115,6 +122,22 @@ public:
 		char_t const* Name;
 	};
 
+	// DirectoryEntryFormat
+	//
+	// Strongly typed enumeration defining the record format written by ReadEntries
+	enum class DirectoryEntryFormat : uint8_t
+	{
+		Dirent			= 0,	// struct linux_dirent (getdents)
+		Dirent64		= 1,	// struct linux_dirent64 (getdents64)
+	};
+
+	// IoCompletion
+	//
+	// Function invoked when an asynchronous handle operation completes; receives the number
+	// of bytes transferred, or the exception that caused the operation to fail.  This may be
+	// invoked before the operation function returns, or later from an arbitrary thread
+	using IoCompletion = std::function<void(size_t transferred, std::exception_ptr exception)>;
+
 	// LogLevel
 	//
 	// Strongly typed enumeration defining the level of a log entry
@@ -223,6 +246,12 @@ public:
 		// Gets a pointer to the mount point root node instance
 		__declspec(property(get=getRootNode)) struct Node* RootNode;
 		virtual struct Node* getRootNode(void) const = 0;
+
+		// Statistics
+		//
+		// Gets a pointer to the mount point operation statistics
+		__declspec(property(get=getStatistics)) MountStatistics* Statistics;
+		virtual MountStatistics* getStatistics(void) const = 0;
 	};
 
 	// Node
@@ -355,6 +384,12 @@ public:
 		// Synchronously reads data from the underlying node into a buffer
 		virtual size_t Read(void* buffer, size_t count) = 0;
 
+		// ReadAsync
+		//
+		// Asynchronously reads data from the underlying node into a buffer; the default
+		// implementation completes synchronously by invoking Read()
+		virtual void ReadAsync(void* buffer, size_t count, IoCompletion const& completion);
+
 		// Seek
 		//
 		// Changes the file position
@@ -365,11 +400,23 @@ public:
 		// Synchronizes all data associated with the file to storage, not metadata
 		virtual void Sync(void) const = 0;
 
+		// SyncAsync
+		//
+		// Asynchronously synchronizes the file data to storage; the default implementation
+		// completes synchronously by invoking Sync()
+		virtual void SyncAsync(IoCompletion const& completion) const;
+
 		// Write
 		//
 		// Synchronously writes data from a buffer to the underlying node
 		virtual size_t Write(const void* buffer, size_t count) = 0;
 
+		// WriteAsync
+		//
+		// Asynchronously writes data from a buffer to the underlying node; the default
+		// implementation completes synchronously by invoking Write()
+		virtual void WriteAsync(const void* buffer, size_t count, IoCompletion const& completion);
+
 		//--------------------------------------------------------------------
 		// Properties
 
@@ -396,6 +443,11 @@ public:
 		//
 		// Enumerates all of the entries in this directory
 		virtual void Enumerate(std::function<bool(DirectoryEntry const&)> func) = 0;
+
+		// ReadEntries
+		//
+		// Writes directory entry records into a buffer, resuming from the current position
+		virtual size_t ReadEntries(DirectoryEntryFormat format, void* buffer, size_t length) = 0;
 	};
 
 	// FileHandle
@@ -415,6 +467,12 @@ public:
 		// Synchronously reads data from the underlying node into a buffer
 		virtual size_t ReadAt(size_t offset, void* buffer, size_t count) = 0;
 
+		// ReadAtAsync
+		//
+		// Asynchronously reads data from the underlying node into a buffer; the default
+		// implementation completes synchronously by invoking ReadAt()
+		virtual void ReadAtAsync(size_t offset, void* buffer, size_t count, IoCompletion const& completion);
+
 		// SetLength
 		//
 		// Sets the length of the node data
@@ -424,6 +482,39 @@ public:
 		//
 		// Synchronously writes data from a buffer to the underlying node
 		virtual size_t WriteAt(size_t offset, const void* buffer, size_t count) = 0;
+
+		// WriteAtAsync
+		//
+		// Asynchronously writes data from a buffer to the underlying node; the default
+		// implementation completes synchronously by invoking WriteAt()
+		virtual void WriteAtAsync(size_t offset, const void* buffer, size_t count, IoCompletion const& completion);
+	};
+
+	// PollableHandle
+	//
+	// Interface that must be implemented by a handle that can be monitored with poll/epoll
+	struct PollableHandle : public Handle
+	{
+		// Destructor
+		//
+		virtual ~PollableHandle()=default;
+
+		//-------------------------------------------------------------------
+		// Member Functions
+
+		// Poll
+		//
+		// Gets the set of events (EPOLLIN, EPOLLOUT, ...) currently signaled
+		virtual uint32_t Poll(void) const = 0;
+
+		//-------------------------------------------------------------------
+		// Properties
+
+		// WaitQueue
+		//
+		// Gets the wait queue that is notified when the signaled events change
+		__declspec(property(get=getWaitQueue)) PollQueue* WaitQueue;
+		virtual PollQueue* getWaitQueue(void) const = 0;
 	};
 
 	// Directory
@@ -473,6 +564,11 @@ public:
 		// Opens or creates a child in this directory by name
 		//virtual std::unique_ptr<Handle> Open(Mount const* mount, char_t const* name, .... blah blah
 
+		// Rename
+		//
+		// Atomically renames a child node of this directory, optionally into another directory
+		virtual void Rename(Mount const* mount, char_t const* oldname, Directory const* newdir, char_t const* newname, uint32_t flags) = 0;
+
 		// Unlink
 		//
 		// Unlinks a child node from this directory by name
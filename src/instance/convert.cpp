@@ -24,6 +24,7 @@
 
 #include <convert.h>
 #include <datetime.h>
+#include <timespan.h>
 
 #pragma warning(push, 4)
 
@@ -92,6 +93,32 @@ template<> FILETIME convert<FILETIME>(uapi_timespec const& rhs)
 	return{ largeint.LowPart, static_cast<DWORD>(largeint.HighPart) };
 }
 
+// timespan --> uapi_timespec
+//
+template<> uapi_timespec convert<uapi_timespec>(timespan const& rhs)
+{
+	uint64_t ticks = static_cast<uint64_t>(rhs);
+
+	// Convert the timespec components individually so they can be range checked
+	uint64_t tv_sec = ticks / 10000000ui64;
+	uint64_t tv_nsec = (ticks % 10000000ui64) * 100ui64;
+
+	if(tv_sec > static_cast<uint64_t>(std::numeric_limits<uapi___kernel_time_t>::max())) throw std::out_of_range("tv_sec");
+
+	return{ static_cast<uapi___kernel_time_t>(tv_sec), static_cast<long>(tv_nsec) };
+}
+
+// uapi_timespec --> timespan
+//
+template<> timespan convert<timespan>(uapi_timespec const& rhs)
+{
+	if(rhs.tv_sec < 0) throw std::out_of_range("tv_sec");
+	if((rhs.tv_nsec < 0) || (rhs.tv_nsec >= 1000000000)) throw std::out_of_range("tv_nsec");
+
+	// Round partial 100ns intervals up so that a non-zero timespec never converts to zero
+	return timespan((static_cast<uint64_t>(rhs.tv_sec) * 10000000ui64) + ((static_cast<uint64_t>(rhs.tv_nsec) + 99ui64) / 100ui64));
+}
+
 //-----------------------------------------------------------------------------
 
 #pragma warning(pop)
@@ -33,6 +33,12 @@
 #define	_WIN32_IE				_WIN32_IE_IE100
 #define NOMINMAX
 
+// SYNC_LOCK_PROFILING
+//
+// Uncomment to build the sync:: primitives with lock contention profiling, the
+// collected statistics are written into the system log when the service stops
+//#define SYNC_LOCK_PROFILING
+
 // _ENABLE_ATOMIC_ALIGNMENT_FIX
 //
 // Allows std::atomic<> to be used on data types that don't have 8-byte alignment;
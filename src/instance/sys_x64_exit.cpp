@@ -22,6 +22,9 @@
 
 #include "stdafx.h"
 
+#include "SystemCallContext.h"
+#include "SystemCallStatistics.h"
+
 #pragma warning(push, 4)
 
 //-----------------------------------------------------------------------------
@@ -36,10 +39,18 @@
 
 long sys_x64_exit(sys_x64_context_exclusive_t* context, int exitcode)
 {
-	(context);
-	(exitcode);
+	return SystemCallStatistics::X64.Invoke(60, "exit", [&]() -> long {
+
+		(exitcode);
+
+		if((context == nullptr) || (*context == nullptr)) return -UAPI_EFAULT;
+
+		// Release the thread context; the process state is released along with the last thread
+		delete reinterpret_cast<SystemCallContext*>(*context);
+		*context = nullptr;
 
-	return 0;
+		return 0;
+	});
 }
 
 //---------------------------------------------------------------------------
@@ -22,6 +22,8 @@
 
 #include "stdafx.h"
 
+#include "SystemCallContext.h"
+
 #pragma warning(push, 4)
 
 //-----------------------------------------------------------------------------
@@ -40,9 +42,15 @@
 HRESULT sys_x86_attach_process(handle_t rpchandle, /*sys_x86_uint_t tid, sys_x86_addr_t threadproc, sys_x86_process_t* process,*/ sys_x86_context_exclusive_t* context)
 {
 	(rpchandle);
-	(context);
 
-	return E_FAIL;
+	if(context == nullptr) return E_POINTER;
+
+	// Allocate the context for the main thread of the new process
+	try { *context = reinterpret_cast<sys_x86_context_exclusive_t>(new SystemCallContext()); }
+	catch(std::bad_alloc&) { return E_OUTOFMEMORY; }
+	catch(...) { return E_FAIL; }
+
+	return S_OK;
 }
 
 //---------------------------------------------------------------------------
@@ -22,6 +22,8 @@
 
 #include "stdafx.h"
 
+#include "SystemCallContext.h"
+
 #pragma warning(push, 4)
 
 //-----------------------------------------------------------------------------
@@ -32,16 +34,23 @@
 // Arguments:
 //
 //	rpchandle		- RPC binding handle
+//	parent			- [in] context handle of an existing thread in the process
 //	tid				- [in] native thread id within the host process
 //	thread			- [out] set to the thread startup information
 //	context			- [out] set to the newly allocated context handle
 
-HRESULT sys_x86_attach_thread(handle_t rpchandle, /*sys_x86_uint_t tid, sys_x86_thread_t* thread,*/ sys_x86_context_exclusive_t* context)
+HRESULT sys_x86_attach_thread(handle_t rpchandle, sys_x86_context_t parent, /*sys_x86_uint_t tid, sys_x86_thread_t* thread,*/ sys_x86_context_exclusive_t* context)
 {
 	(rpchandle);
-	(context);
 
-	return E_FAIL;
+	if((parent == nullptr) || (context == nullptr)) return E_POINTER;
+
+	// Allocate a new thread context that shares the process state of the parent context
+	try { *context = reinterpret_cast<sys_x86_context_exclusive_t>(new SystemCallContext(reinterpret_cast<SystemCallContext const*>(parent))); }
+	catch(std::bad_alloc&) { return E_OUTOFMEMORY; }
+	catch(...) { return E_FAIL; }
+
+	return S_OK;
 }
 
 //---------------------------------------------------------------------------
@@ -22,6 +22,9 @@
 
 #include "stdafx.h"
 
+#include "SystemCallContext.h"
+#include "SystemCallStatistics.h"
+
 #pragma warning(push, 4)
 
 //-----------------------------------------------------------------------------
@@ -36,10 +39,18 @@
 
 long sys_x86_exit(sys_x86_context_exclusive_t* context, int exitcode)
 {
-	(context);
-	(exitcode);
+	return SystemCallStatistics::X86.Invoke(1, "exit", [&]() -> long {
+
+		(exitcode);
+
+		if((context == nullptr) || (*context == nullptr)) return -UAPI_EFAULT;
+
+		// Release the thread context; the process state is released along with the last thread
+		delete reinterpret_cast<SystemCallContext*>(*context);
+		*context = nullptr;
 
-	return 0;
+		return 0;
+	});
 }
 
 //---------------------------------------------------------------------------
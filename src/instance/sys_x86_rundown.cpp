@@ -22,6 +22,8 @@
 
 #include "stdafx.h"
 
+#include "SystemCallContext.h"
+
 #pragma warning(push, 4)
 
 //-----------------------------------------------------------------------------
@@ -35,7 +37,7 @@
 
 void __RPC_USER sys_x86_context_t_rundown(sys_x86_context_t context)
 {
-	(context);
+	delete reinterpret_cast<SystemCallContext*>(context);
 }
 
 //-----------------------------------------------------------------------------
@@ -49,7 +51,7 @@ void __RPC_USER sys_x86_context_t_rundown(sys_x86_context_t context)
 
 void __RPC_USER sys_x86_context_exclusive_t_rundown(sys_x86_context_exclusive_t context)
 {
-	(context);
+	delete reinterpret_cast<SystemCallContext*>(context);
 }
 
 
@@ -31,10 +31,13 @@
 #include <linux/errno.h>
 #include <linux/elf.h>
 #include <linux/elf-em.h>
+#include <linux/eventpoll.h>
 #include <linux/fcntl.h>
 #include <linux/fs.h>
+#include <linux/futex.h>
 #include <linux/magic.h>
 #include <linux/sched.h>
+#include <linux/signalfd.h>
 #include <linux/stat.h>
 #include <linux/time.h>
 #include <asm/stat.h>
@@ -49,6 +52,28 @@
 //
 #define O_KERNEL_EXEC 4		// Special flag for EXECUTE access on handles, should not be obeyed by system calls
 
+// linux/eventfd.h
+//
+#define EFD_SEMAPHORE			(1 << 0)
+#define EFD_CLOEXEC				O_CLOEXEC
+#define EFD_NONBLOCK			O_NONBLOCK
+
+// linux/fs.h
+//
+// RENAME_XXXXX flags may not be present in older kernel headers
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE		(1 << 0)
+#define RENAME_EXCHANGE			(1 << 1)
+#define RENAME_WHITEOUT			(1 << 2)
+#endif
+
+// linux/timerfd.h
+//
+#define TFD_TIMER_ABSTIME		(1 << 0)
+#define TFD_TIMER_CANCEL_ON_SET	(1 << 1)
+#define TFD_CLOEXEC				O_CLOEXEC
+#define TFD_NONBLOCK			O_NONBLOCK
+
 // asm/stat.h
 //
 // Define a generic stat that compiles on either platform as stat3264.  x86 should use